@@ -113,29 +113,27 @@ static inline std::vector<int64_t> find_dest_ranks(int64_t rank, int64_t num_ran
     return dest_ranks;
 }
 
-static inline std::vector<int>
-    find_send_counts(const std::vector<int64_t>& dest_ranks, int64_t num_ranks, int64_t elem_size)
+static inline std::vector<int64_t> find_send_counts(const std::vector<int64_t>& dest_ranks, int64_t num_ranks)
 {
-    std::vector<int> send_counts(num_ranks);
+    std::vector<int64_t> send_counts(num_ranks);
     for (auto dest : dest_ranks)
         ++send_counts[dest];
     return send_counts;
 }
 
-static inline std::vector<int> find_disps(const std::vector<int>& counts)
+static inline std::vector<int64_t> find_disps(const std::vector<int64_t>& counts)
 {
-    std::vector<int> disps(counts.size());
+    std::vector<int64_t> disps(counts.size());
     for (size_t i = 1; i < disps.size(); ++i)
         disps[i] = disps[i - 1] + counts[i - 1];
     return disps;
 }
 
-static inline std::vector<int>
-    find_recv_counts(int64_t rank, int64_t num_ranks, int64_t* p, int64_t p_len, int64_t elem_size)
+static inline std::vector<int64_t> find_recv_counts(int64_t rank, int64_t num_ranks, int64_t* p, int64_t p_len)
 {
     auto begin = hpat_dist_get_start(p_len, num_ranks, rank);
     auto end = hpat_dist_get_end(p_len, num_ranks, rank);
-    std::vector<int> recv_counts(num_ranks);
+    std::vector<int64_t> recv_counts(num_ranks);
     for (auto i = begin; i < end; ++i)
         ++recv_counts[index_rank(p_len, num_ranks, p[i])];
     return recv_counts;
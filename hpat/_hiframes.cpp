@@ -1,6 +1,7 @@
 #include <Python.h>
 #include <iostream>
 
+#include "_hpat_hash.h"
 #include "_hpat_sort.h"
 
 PyMODINIT_FUNC PyInit_chiframes(void)
@@ -21,6 +22,10 @@ PyMODINIT_FUNC PyInit_chiframes(void)
     }
 
     PyObject_SetAttrString(m, "timsort", PyLong_FromVoidPtr((void*)(&__hpat_timsort)));
+    PyObject_SetAttrString(m, "hash_shuffle_keys", PyLong_FromVoidPtr((void*)(&hpat_hash_shuffle_keys)));
+    PyObject_SetAttrString(m, "shuffle_pack", PyLong_FromVoidPtr((void*)(&hpat_shuffle_pack)));
+    PyObject_SetAttrString(m, "hash_keys", PyLong_FromVoidPtr((void*)(&hpat_hash_keys)));
+    PyObject_SetAttrString(m, "skew_shuffle_keys", PyLong_FromVoidPtr((void*)(&hpat_skew_shuffle_keys)));
 
     return m;
 }
@@ -0,0 +1,389 @@
+#ifndef HPAT_HASH_H_
+#define HPAT_HASH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "_hpat_common.h"
+
+/*
+  Hashing of keys for hash partitioning (shuffles of joins).
+
+  Keys are hashed with the 64-bit finalizer of MurmurHash3, which spreads sequential,
+  strided and clustered keys evenly, and the hashes of the key columns of a row are
+  combined. Equal keys of different types hash the same (int32 and int64 keys, and
+  integral float keys), since the tables of a join can have different key types.
+  The rows of each column are then packed to the send buffer in node order.
+
+  Keys with many rows (heavy keys) would all go to one node, so joins of skewed tables
+  keep the rows of a heavy key on their node in the table which has most of them, and
+  send the rows of the key in the other table to all nodes. Heavy keys are found by
+  the hashes of a sample of the rows of every node.
+*/
+
+// key type of string columns, other key types are HPAT_CTypes values
+#define HPAT_HASH_KEY_STRING 100
+
+// node id of rows sent to all nodes
+#define HPAT_SHUFFLE_ALL_NODES -1
+
+static inline uint64_t hpat_hash_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t hpat_hash_int(int64_t val)
+{
+    return hpat_hash_mix((uint64_t)val);
+}
+
+static inline uint64_t hpat_hash_float(double val)
+{
+    // integral values hash like ints, so -0.0 is 0 as well
+    if (val >= -9223372036854775808.0 && val < 9223372036854775808.0 && val == (double)(int64_t)val)
+    {
+        return hpat_hash_int((int64_t)val);
+    }
+    if (std::isnan(val))
+    {
+        return hpat_hash_mix(0x7ff8000000000000ULL);
+    }
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return hpat_hash_mix(bits);
+}
+
+/// hash of n bytes, 8 bytes at a time
+static inline uint64_t hpat_hash_bytes(const uint8_t* data, int64_t n)
+{
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    uint64_t h = 0x8445d61a4e774912ULL ^ ((uint64_t)n * m);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t k;
+        memcpy(&k, data + i, 8);
+        k *= m;
+        k ^= k >> 47;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (i < n)
+    {
+        uint64_t k = 0;
+        memcpy(&k, data + i, n - i);
+        h ^= k;
+        h *= m;
+    }
+    return hpat_hash_mix(h);
+}
+
+static inline uint64_t hpat_hash_combine(uint64_t h, uint64_t key_hash)
+{
+    return h ^ (key_hash + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+/// hash of value i of a key column of type_enum (HPAT_CTypes value or HPAT_HASH_KEY_STRING)
+static inline uint64_t hpat_hash_key(int type_enum, const void* data, const uint32_t* offsets, int64_t i)
+{
+    switch (type_enum)
+    {
+    case HPAT_CTypes::INT8: return hpat_hash_int(((const int8_t*)data)[i]);
+    case HPAT_CTypes::UINT8: return hpat_hash_int(((const uint8_t*)data)[i]);
+    case HPAT_CTypes::INT16: return hpat_hash_int(((const int16_t*)data)[i]);
+    case HPAT_CTypes::UINT16: return hpat_hash_int(((const uint16_t*)data)[i]);
+    case HPAT_CTypes::INT32: return hpat_hash_int(((const int32_t*)data)[i]);
+    case HPAT_CTypes::UINT32: return hpat_hash_int(((const uint32_t*)data)[i]);
+    case HPAT_CTypes::INT64: return hpat_hash_int(((const int64_t*)data)[i]);
+    case HPAT_CTypes::UINT64: return hpat_hash_int((int64_t)((const uint64_t*)data)[i]);
+    case HPAT_CTypes::FLOAT32: return hpat_hash_float(((const float*)data)[i]);
+    case HPAT_CTypes::FLOAT64: return hpat_hash_float(((const double*)data)[i]);
+    case HPAT_HASH_KEY_STRING:
+        return hpat_hash_bytes((const uint8_t*)data + offsets[i], offsets[i + 1] - offsets[i]);
+    default: return 0;
+    }
+}
+
+/// node of a row with hash h
+static inline int hpat_hash_node(uint64_t h, int n_pes)
+{
+    // high bits of the product map the hash range evenly to nodes without a division
+    return (int)(((h >> 32) * (uint64_t)n_pes) >> 32);
+}
+
+/// hash of the keys of row i
+static inline uint64_t
+    hpat_hash_row(int n_keys, const int* key_types, void** key_datas, uint32_t** key_offsets, int64_t i)
+{
+    uint64_t h = hpat_hash_key(key_types[0], key_datas[0], key_offsets[0], i);
+    for (int k = 1; k < n_keys; k++)
+    {
+        h = hpat_hash_combine(h, hpat_hash_key(key_types[k], key_datas[k], key_offsets[k], i));
+    }
+    return h;
+}
+
+/**
+ * Node of each row of the key columns and the number of rows of each node, in one pass.
+ * String keys have offsets, the other keys have NULL offsets.
+ **/
+static inline void hpat_hash_shuffle_keys(int64_t n_rows,
+                                          int n_keys,
+                                          const int* key_types,
+                                          void** key_datas,
+                                          uint32_t** key_offsets,
+                                          int n_pes,
+                                          int* node_ids,
+                                          int64_t* send_counts)
+{
+    memset(send_counts, 0, sizeof(int64_t) * n_pes);
+    for (int64_t i = 0; i < n_rows; i++)
+    {
+        int node_id = hpat_hash_node(hpat_hash_row(n_keys, key_types, key_datas, key_offsets, i), n_pes);
+        node_ids[i] = node_id;
+        send_counts[node_id]++;
+    }
+}
+
+/// hash of the keys of every row
+static inline void hpat_hash_keys(
+    int64_t n_rows, int n_keys, const int* key_types, void** key_datas, uint32_t** key_offsets, uint64_t* hashes)
+{
+    for (int64_t i = 0; i < n_rows; i++)
+    {
+        hashes[i] = hpat_hash_row(n_keys, key_types, key_datas, key_offsets, i);
+    }
+}
+
+struct hpat_heavy_key
+{
+    uint64_t hash;
+    // estimated rows of the key in the left and right tables
+    int64_t counts[2];
+};
+
+/**
+ * Add the keys of a table (side 0 left, 1 right) with at least min_count rows, estimated from
+ * every n_rows / sample_size-th row, to candidates. At most max_keys keys are added.
+ **/
+static inline void hpat_heavy_key_candidates(const uint64_t* hashes,
+                                             int64_t n_rows,
+                                             int side,
+                                             int64_t sample_size,
+                                             int64_t min_count,
+                                             int64_t max_keys,
+                                             std::vector<hpat_heavy_key>& candidates)
+{
+    if (n_rows == 0 || sample_size <= 0)
+    {
+        return;
+    }
+    int64_t stride = std::max(n_rows / sample_size, (int64_t)1);
+    int64_t n_sampled = (n_rows + stride - 1) / stride;
+    std::unordered_map<uint64_t, int64_t> sample_counts;
+    for (int64_t i = 0; i < n_rows; i += stride)
+    {
+        sample_counts[hashes[i]]++;
+    }
+
+    std::vector<hpat_heavy_key> keys;
+    for (auto& it : sample_counts)
+    {
+        int64_t count = it.second * n_rows / n_sampled;
+        // a key seen once in a sample is noise
+        if (count >= min_count && (it.second > 1 || stride == 1))
+        {
+            hpat_heavy_key key = {it.first, {0, 0}};
+            key.counts[side] = count;
+            keys.push_back(key);
+        }
+    }
+    if ((int64_t)keys.size() > max_keys)
+    {
+        auto heavier = [side](const hpat_heavy_key& a, const hpat_heavy_key& b) {
+            return a.counts[side] > b.counts[side];
+        };
+        std::partial_sort(keys.begin(), keys.begin() + max_keys, keys.end(), heavier);
+        keys.resize(max_keys);
+    }
+    candidates.insert(candidates.end(), keys.begin(), keys.end());
+}
+
+/**
+ * Select the heavy keys among the candidates of all nodes, the keys with at least min_counts[side]
+ * rows in a table. The table with more rows of a key keeps them on their node if bit side of
+ * local_sides is set, otherwise the key is partitioned by its hash. At most max_keys of the heaviest
+ * keys are selected, their hashes are sorted and heavy_local is the table keeping the rows.
+ * Every node selects the same keys from the same candidates.
+ **/
+static inline int64_t hpat_select_heavy_keys(std::vector<hpat_heavy_key>& candidates,
+                                             const int64_t* min_counts,
+                                             int local_sides,
+                                             int64_t max_keys,
+                                             uint64_t* heavy_hashes,
+                                             int* heavy_local)
+{
+    // sum the estimates of each key on all nodes
+    std::sort(candidates.begin(), candidates.end(), [](const hpat_heavy_key& a, const hpat_heavy_key& b) {
+        return a.hash < b.hash;
+    });
+    std::vector<hpat_heavy_key> keys;
+    for (const hpat_heavy_key& key : candidates)
+    {
+        if (keys.empty() || keys.back().hash != key.hash)
+        {
+            keys.push_back(key);
+        }
+        else
+        {
+            keys.back().counts[0] += key.counts[0];
+            keys.back().counts[1] += key.counts[1];
+        }
+    }
+
+    std::vector<std::pair<hpat_heavy_key, int>> heavy;
+    for (const hpat_heavy_key& key : keys)
+    {
+        int local = key.counts[1] > key.counts[0] ? 1 : 0;
+        if ((key.counts[0] >= min_counts[0] || key.counts[1] >= min_counts[1]) && (local_sides & (1 << local)))
+        {
+            heavy.push_back(std::make_pair(key, local));
+        }
+    }
+    if ((int64_t)heavy.size() > max_keys)
+    {
+        // stable, so ties are broken by hash
+        std::stable_sort(heavy.begin(), heavy.end(), [](const std::pair<hpat_heavy_key, int>& a,
+                                                        const std::pair<hpat_heavy_key, int>& b) {
+            return a.first.counts[a.second] > b.first.counts[b.second];
+        });
+        heavy.resize(max_keys);
+        std::sort(heavy.begin(), heavy.end(), [](const std::pair<hpat_heavy_key, int>& a,
+                                                 const std::pair<hpat_heavy_key, int>& b) {
+            return a.first.hash < b.first.hash;
+        });
+    }
+    for (size_t i = 0; i < heavy.size(); i++)
+    {
+        heavy_hashes[i] = heavy[i].first.hash;
+        heavy_local[i] = heavy[i].second;
+    }
+    return heavy.size();
+}
+
+/**
+ * Node of each row of a table (side 0 left, 1 right) of a skewed join and the number of rows
+ * of each node. Rows of heavy keys stay on node rank if the table keeps them, or are sent to all
+ * nodes (HPAT_SHUFFLE_ALL_NODES) otherwise. The other rows are partitioned by hash.
+ **/
+static inline void hpat_skew_shuffle_keys(int64_t n_rows,
+                                          const uint64_t* hashes,
+                                          int64_t n_heavy,
+                                          const uint64_t* heavy_hashes,
+                                          const int* heavy_local,
+                                          int side,
+                                          int rank,
+                                          int n_pes,
+                                          int* node_ids,
+                                          int64_t* send_counts)
+{
+    memset(send_counts, 0, sizeof(int64_t) * n_pes);
+    int64_t n_all_nodes = 0;
+    for (int64_t i = 0; i < n_rows; i++)
+    {
+        uint64_t h = hashes[i];
+        int node_id = hpat_hash_node(h, n_pes);
+        const uint64_t* heavy = std::lower_bound(heavy_hashes, heavy_hashes + n_heavy, h);
+        if (heavy != heavy_hashes + n_heavy && *heavy == h)
+        {
+            if (heavy_local[heavy - heavy_hashes] != side)
+            {
+                node_ids[i] = HPAT_SHUFFLE_ALL_NODES;
+                n_all_nodes++;
+                continue;
+            }
+            node_id = rank;
+        }
+        node_ids[i] = node_id;
+        send_counts[node_id]++;
+    }
+    for (int i = 0; i < n_pes; i++)
+    {
+        send_counts[i] += n_all_nodes;
+    }
+}
+
+template <typename T>
+static inline void hpat_shuffle_pack_typed(
+    int64_t n_rows, const int* node_ids, int n_pes, int64_t* offsets, const T* data, T* send_buff)
+{
+    for (int64_t i = 0; i < n_rows; i++)
+    {
+        int node_id = node_ids[i];
+        if (node_id != HPAT_SHUFFLE_ALL_NODES)
+        {
+            send_buff[offsets[node_id]++] = data[i];
+            continue;
+        }
+        for (int n = 0; n < n_pes; n++)
+        {
+            send_buff[offsets[n]++] = data[i];
+        }
+    }
+}
+
+/**
+ * Pack the values of a column to send_buff in node order (node n starts at send_disp[n]),
+ * in one pass over the column. Rows with node HPAT_SHUFFLE_ALL_NODES are written for every node.
+ **/
+static inline void hpat_shuffle_pack(int64_t n_rows,
+                                     const int* node_ids,
+                                     const int64_t* send_disp,
+                                     int n_pes,
+                                     int64_t elem_size,
+                                     const uint8_t* data,
+                                     uint8_t* send_buff)
+{
+    std::vector<int64_t> offsets(send_disp, send_disp + n_pes);
+    switch (elem_size)
+    {
+    case 1:
+        hpat_shuffle_pack_typed(
+            n_rows, node_ids, n_pes, offsets.data(), (const uint8_t*)data, (uint8_t*)send_buff);
+        break;
+    case 2:
+        hpat_shuffle_pack_typed(
+            n_rows, node_ids, n_pes, offsets.data(), (const uint16_t*)data, (uint16_t*)send_buff);
+        break;
+    case 4:
+        hpat_shuffle_pack_typed(
+            n_rows, node_ids, n_pes, offsets.data(), (const uint32_t*)data, (uint32_t*)send_buff);
+        break;
+    case 8:
+        hpat_shuffle_pack_typed(
+            n_rows, node_ids, n_pes, offsets.data(), (const uint64_t*)data, (uint64_t*)send_buff);
+        break;
+    default:
+        for (int64_t i = 0; i < n_rows; i++)
+        {
+            int first = node_ids[i] == HPAT_SHUFFLE_ALL_NODES ? 0 : node_ids[i];
+            int last = node_ids[i] == HPAT_SHUFFLE_ALL_NODES ? n_pes : node_ids[i] + 1;
+            for (int n = first; n < last; n++)
+            {
+                memcpy(send_buff + elem_size * offsets[n]++, data + elem_size * i, elem_size);
+            }
+        }
+    }
+}
+
+#endif /* HPAT_HASH_H_ */
@@ -82,7 +82,122 @@ Current value for transport controlled by decorator need to initialize this here
 because decorator called later then modules have been initialized
 '''
 
+config_transport_mpi_hierarchical = distutils_util.strtobool(os.getenv('HPAT_CONFIG_MPI_HIERARCHICAL', 'False'))
+'''
+Use two-level collectives in the MPI transport (all-to-all shuffles and reductions): processes of a
+node exchange data through shared memory and only one process per node communicates with other nodes
+'''
+
+config_transport_mpi_node_size = int(os.getenv('HPAT_CONFIG_MPI_NODE_SIZE', '0'))
+'''
+Number of processes per node of the two-level collectives, grouping consecutive ranks. Tests them on one
+machine, 0 (the default) groups the processes by shared memory node
+'''
+
 config_pipeline_hpat_default = distutils_util.strtobool(os.getenv('HPAT_CONFIG_PIPELINE_HPAT', 'True'))
 '''
 Default value used to select compiler pipeline in a function decorator
 '''
+
+config_csv_native_parser = distutils_util.strtobool(os.getenv('HPAT_CONFIG_CSV_NATIVE_PARSER', 'True'))
+'''
+Parse CSV chunks with the native parser into column buffers when all column types
+are supported by it, otherwise (or if disabled) chunks are parsed by pandas.read_csv
+'''
+
+config_csv_num_threads = int(os.getenv('HPAT_CONFIG_CSV_NUM_THREADS', '1'))
+'''
+Number of threads each process uses to parse its chunk with the native CSV parser,
+0 uses all hardware threads
+'''
+
+config_csv_native_writer = distutils_util.strtobool(os.getenv('HPAT_CONFIG_CSV_NATIVE_WRITER', 'True'))
+'''
+Format the rows of distributed DataFrame.to_csv() natively when the call has default
+arguments and all column types are supported, otherwise (or if disabled) by pandas
+'''
+
+config_pq_row_group_dist = distutils_util.strtobool(os.getenv('HPAT_CONFIG_PQ_ROW_GROUP_DIST', 'False'))
+'''
+Distribute parallel Parquet reads by whole row groups, balanced by their byte size,
+instead of row ranges so no row group is decoded by two processes. The rows are
+shuffled to the 1D block layout afterwards
+'''
+
+config_pq_multi_column_read = distutils_util.strtobool(os.getenv('HPAT_CONFIG_PQ_MULTI_COLUMN_READ', 'True'))
+'''
+Read all numeric columns of a Parquet dataset together, one row group at a time with
+the columns decoded in parallel, instead of scanning the dataset once per column
+'''
+
+config_pq_prefetch_depth = int(os.getenv('HPAT_CONFIG_PQ_PREFETCH_DEPTH', '2'))
+'''
+Number of row groups multi-column Parquet reads fetch and decode in a background thread
+ahead of the row group being copied to the output, 0 reads row groups synchronously
+'''
+
+config_pq_prefetch_max_bytes = int(os.getenv('HPAT_CONFIG_PQ_PREFETCH_MAX_BYTES', str(256 * 1024 * 1024)))
+'''
+Limit of the uncompressed size of prefetched Parquet row groups, at least one row group
+is always prefetched
+'''
+
+config_pq_write_row_group_size = int(os.getenv('HPAT_CONFIG_PQ_WRITE_ROW_GROUP_SIZE', str(1024 * 1024)))
+'''
+Maximum number of rows of the row groups written by the native parallel Parquet writer
+'''
+
+config_pq_metadata_cache_dir = os.getenv('HPAT_CONFIG_PQ_METADATA_CACHE_DIR', '')
+'''
+Directory of the cache of Parquet footers, reused for the files of a dataset which have the
+same size and modification time as when the cache was written. Empty disables the cache
+'''
+
+config_h5_write_compression = os.getenv('HPAT_CONFIG_H5_WRITE_COMPRESSION', '')
+'''
+Filter compressing HDF5 datasets created by compiled functions: 'gzip', 'szip', 'lzf',
+'blosc', 'lz4', 'bzip2', 'zstd' or the id of a filter registered with HDF5. Filters that
+aren't available locally fall back to uncompressed. Empty creates contiguous datasets
+'''
+
+config_h5_write_compression_level = int(os.getenv('HPAT_CONFIG_H5_WRITE_COMPRESSION_LEVEL', '4'))
+'''
+Compression level of the gzip filter of created HDF5 datasets
+'''
+
+config_h5_write_shuffle = distutils_util.strtobool(os.getenv('HPAT_CONFIG_H5_WRITE_SHUFFLE', 'True'))
+'''
+Add the byte shuffle filter before the compression filter of created HDF5 datasets
+'''
+
+config_h5_write_chunk_bytes = int(os.getenv('HPAT_CONFIG_H5_WRITE_CHUNK_BYTES', '0'))
+'''
+Largest chunk size of created HDF5 datasets, which are chunked if this is positive or a
+compression filter is set (with 4 MB chunks by default). Chunk rows are derived from the
+rows written by each process
+'''
+
+config_join_skew_threshold = float(os.getenv('HPAT_CONFIG_JOIN_SKEW_THRESHOLD', '0.5'))
+'''
+Keys of parallel joins with more rows in a table than this fraction of the rows of a process
+(after an even partitioning) are heavy keys. Their rows stay on their process in the table which
+has most of them and are sent to all processes in the other table, the other keys are partitioned
+by hash. Outer joins and 0 partition all keys by hash
+'''
+
+config_join_skew_sample_size = int(os.getenv('HPAT_CONFIG_JOIN_SKEW_SAMPLE_SIZE', '10000'))
+'''
+Number of rows of each table every process samples to estimate the rows of join keys
+'''
+
+config_join_report_recv = distutils_util.strtobool(os.getenv('HPAT_CONFIG_JOIN_REPORT_RECV', 'False'))
+'''
+Print the rows every process receives in the shuffles of parallel joins and their imbalance
+'''
+
+config_shuffle_max_bytes = int(os.getenv('HPAT_CONFIG_SHUFFLE_MAX_BYTES', str(128 * 1024 * 1024)))
+'''
+Bytes of send buffers of shuffles which pack rows before sending them (e.g. permutation of
+distributed arrays). Rows are sent in rounds, packing to one half of this memory while the
+other half is sent
+'''
@@ -550,6 +550,7 @@ class DistributedPass(object):
             start_var = self._array_starts[arr][0]
             count_var = self._array_counts[arr][0]
             rhs.args += [start_var, count_var]
+            self._pq_readers_set_parallel(rhs.args[0].name)
 
             def f(fname, cindex, arr, out_dtype, start, count):  # pragma: no cover
                 return hpat.io.parquet_pio.read_parquet_parallel(fname, cindex,
@@ -570,6 +571,7 @@ class DistributedPass(object):
             self._array_counts[lhs] = [count_var]
             rhs.args[2] = start_var
             rhs.args.append(count_var)
+            self._pq_readers_set_parallel(rhs.args[0].name)
 
             def f(fname, cindex, start, count):  # pragma: no cover
                 return hpat.io.parquet_pio.read_parquet_str_parallel(fname, cindex,
@@ -583,20 +585,47 @@ class DistributedPass(object):
             out += f_block.body[:-2]
             out[-1].target = assign.target
 
+        if (hpat.config._has_pyarrow
+                and fdef == ('read_parquet_cat', 'hpat.io.parquet_pio')
+                and self._is_1D_arr(lhs)):
+            arr = lhs
+            size_var = rhs.args[2]
+            assert self.typemap[size_var.name] == types.intp
+            self._array_sizes[arr] = [size_var]
+            out, start_var, count_var = self._gen_1D_div(size_var, scope, loc,
+                                                         "$alloc", "get_node_portion", distributed_api.get_node_portion)
+            self._array_starts[lhs] = [start_var]
+            self._array_counts[lhs] = [count_var]
+            self._pq_readers_set_parallel(rhs.args[0].name)
+
+            def f(fname, cindex, start, count, cats):  # pragma: no cover
+                return hpat.io.parquet_pio.read_parquet_cat_parallel(fname, cindex,
+                                                                     start, count, cats)
+
+            f_block = compile_to_numba_ir(f, {'hpat': hpat}, self.typingctx,
+                                          (self.typemap[rhs.args[0].name], types.intp,
+                                           types.intp, types.intp, self.typemap[rhs.args[3].name]),
+                                          self.typemap, self.calltypes).blocks.popitem()[1]
+            replace_arg_nodes(f_block, [rhs.args[0], rhs.args[1], start_var, count_var, rhs.args[3]])
+            out += f_block.body[:-2]
+            out[-1].target = assign.target
+
         # TODO: fix numba.extending
-        if hpat.config._has_xenon and (fdef == ('read_xenon_col', 'numba.extending')
-                                       and self._is_1D_arr(rhs.args[3].name)):
-            arr = rhs.args[3].name
+        if hpat.config._has_xenon and (fdef == ('read_xenon_columns', 'numba.extending')
+                                       and self._is_1D_arr(rhs.args[4].name)):
+            # the columns have the same distribution and so the same division of rows
+            arr = rhs.args[4].name
             assert len(self._array_starts[arr]) == 1, "only 1D arrs in Xenon"
             start_var = self._array_starts[arr][0]
             count_var = self._array_counts[arr][0]
-            rhs.args += [start_var, count_var]
-
-            def f(connect_tp, dset_tp, col_id_tp, column_tp, schema_arr_tp, start, count):  # pragma: no cover
-                return hpat.io.xenon_ext.read_xenon_col_parallel(
-                    connect_tp, dset_tp, col_id_tp, column_tp, schema_arr_tp, start, count)
-
-            return self._replace_func(f, rhs.args)
+            col_args = ", ".join("c{}".format(i) for i in range(len(rhs.args) - 4))
+            func_text = "def f(connect_tp, dset_tp, schema_arr_tp, col_ids_tp, start, count, {}):\n".format(col_args)
+            func_text += "  return hpat.io.xenon_ext.read_xenon_columns_parallel(\n"
+            func_text += "    connect_tp, dset_tp, schema_arr_tp, col_ids_tp, start, count, {})\n".format(col_args)
+            loc_vars = {}
+            exec(func_text, {'hpat': hpat}, loc_vars)
+            f = loc_vars['f']
+            return self._replace_func(f, rhs.args[:4] + [start_var, count_var] + rhs.args[4:])
 
         if hpat.config._has_xenon and (fdef == ('read_xenon_str', 'numba.extending')
                                        and self._is_1D_arr(lhs)):
@@ -1039,6 +1068,40 @@ class DistributedPass(object):
         return out
 
     def _run_call_df(self, lhs, df, func_name, assign, args):
+        if (hpat.config._has_pyarrow and func_name == 'to_parquet'
+                and (self._is_1D_arr(df.name) or self._is_1D_Var_arr(df.name))):
+            # every rank writes its rows as a part file of the output directory
+            # natively, or with pandas if the native writer doesn't support the dataframe
+            df_typ = self.typemap[df.name]
+            rhs = assign.value
+            kws = dict(rhs.kws)
+            fname = self._get_arg('to_parquet', rhs.args, kws, 0, 'fname')
+            if len(rhs.args) > 1 or set(kws.keys()) - {'fname', 'compression'}:
+                raise ValueError("distributed to_parquet() only supports fname and compression arguments")
+            compression = 'snappy'
+            if 'compression' in kws:
+                # the codec is chosen at compile time
+                if self.typemap[kws['compression'].name] == types.none:
+                    compression = None
+                else:
+                    compression = guard(find_const, self.func_ir, kws['compression'])
+                    if not isinstance(compression, str):
+                        raise ValueError("distributed to_parquet() compression should be a constant string or None")
+
+            write_func = hpat.io.parquet_pio.gen_parquet_write_parallel(df_typ, compression)
+            if write_func is not None:
+                f, glbls = write_func
+                return self._replace_func(f, [fname, df], extra_globals=glbls)
+
+            def f(fname, df):  # pragma: no cover
+                rank = hpat.distributed_api.get_rank()
+                err = hpat.io.parquet_pio.pq_write_begin(fname, rank)
+                if err == 0:
+                    err = hpat.io.parquet_pio.to_parquet_part(df, fname, _compression, rank)
+                hpat.io.parquet_pio.pq_write_end(fname, rank, err, False)
+
+            return self._replace_func(f, [fname, df], extra_globals={'_compression': compression})
+
         if func_name == 'to_csv' and self._is_1D_arr(df.name):
             # set index to proper range if None
             # avoid header for non-zero ranks
@@ -1055,6 +1118,15 @@ class DistributedPass(object):
             rhs = assign.value
             fname = args[0]
 
+            # with default arguments, format rows natively and write them at
+            # the byte offset of this rank
+            if (hpat.config.config_csv_native_writer and len(args) == 1
+                    and not rhs.kws and df_typ.index == types.none):
+                write_func = hpat.io.csv_ext.gen_csv_write_parallel(df_typ)
+                if write_func is not None:
+                    f, glbls = write_func
+                    return self._replace_func(f, [fname, df], extra_globals=glbls)
+
             # update df index and get to_csv from new df
             nodes = self._fix_parallel_df_index(df)
             new_df = nodes[-1].target
@@ -1110,10 +1182,6 @@ class DistributedPass(object):
             # self.calltypes[print_node] = signature(types.none, string_type)
             # nodes.append(print_node)
 
-            # TODO: fix lazy IO load
-            from . import hio
-            import llvmlite.binding as ll
-            ll.add_symbol('file_write_parallel', hio.file_write_parallel)
             # HACK use the string in a dummy function to avoid refcount issues
             # TODO: fix string data reference count
             dummy_use = numba.njit(lambda a: None)
@@ -1190,11 +1258,12 @@ class DistributedPass(object):
                        (self._array_counts[lhs.name][0],
                         *self._array_sizes[lhs.name][1:]), dtype, scope, loc)
 
+        # buffer size is read when the function is compiled
         def f(lhs, lhs_len, dtype_size, rhs, idx, idx_len):
             hpat.distributed_lower.dist_permutation_array_index(
-                lhs, lhs_len, dtype_size, rhs, idx, idx_len)
+                lhs, lhs_len, dtype_size, rhs, idx, idx_len, _max_bytes)
 
-        f_block = compile_to_numba_ir(f, {'hpat': hpat},
+        f_block = compile_to_numba_ir(f, {'hpat': hpat, '_max_bytes': hpat.config.config_shuffle_max_bytes},
                                       self.typingctx,
                                       (self.typemap[lhs.name],
                                        types.intp,
@@ -2016,6 +2085,13 @@ class DistributedPass(object):
             new_blocks[block_label] = block
         return new_blocks
 
+    def _pq_readers_set_parallel(self, readers_varname):
+        # rank 0 reads the dataset metadata and broadcasts it in parallel reads
+        readers_def = guard(get_definition, self.func_ir, readers_varname)
+        if (isinstance(readers_def, ir.Expr) and readers_def.op == 'call'
+                and len(readers_def.args) == 2):
+            readers_def.args[1] = self._set1_var
+
     def _file_open_set_parallel(self, file_varname):
         var = file_varname
         while True:
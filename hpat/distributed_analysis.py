@@ -153,7 +153,7 @@ class DistributedAnalysis(object):
             return
         elif (isinstance(rhs, ir.Expr) and rhs.op == 'getattr'
                 and isinstance(self.typemap[rhs.value.name], DataFrameType)
-                and rhs.attr == 'to_csv'):
+                and rhs.attr in ('to_csv', 'to_parquet')):
             return
         elif (isinstance(rhs, ir.Expr) and rhs.op == 'getattr'
                 and rhs.attr in ['shape', 'ndim', 'size', 'strides', 'dtype',
@@ -455,15 +455,23 @@ class DistributedAnalysis(object):
         if hpat.config._has_pyarrow and fdef == ('read_parquet', 'hpat.io.parquet_pio'):
             return
 
-        if hpat.config._has_pyarrow and fdef == ('read_parquet_str', 'hpat.io.parquet_pio'):
-            # string read creates array in output
+        if hpat.config._has_pyarrow and fdef in (('read_parquet_str', 'hpat.io.parquet_pio'),
+                                                 ('read_parquet_cat', 'hpat.io.parquet_pio')):
+            # string and categorical reads create array in output
             if lhs not in array_dists:
                 array_dists[lhs] = Distribution.OneD
             return
 
         # TODO: fix "numba.extending" in function def
-        if hpat.config._has_xenon and fdef == ('read_xenon_col', 'numba.extending'):
-            array_dists[args[4].name] = Distribution.REP
+        if hpat.config._has_xenon and fdef == ('read_xenon_columns', 'numba.extending'):
+            array_dists[args[2].name] = Distribution.REP
+            array_dists[args[3].name] = Distribution.REP
+            # columns read in one pass have the same distribution
+            new_dist = Distribution.OneD
+            for col in args[4:]:
+                new_dist = self._meet_array_dists(args[4].name, col.name, array_dists, new_dist)
+            for col in args[4:]:
+                array_dists[col.name] = new_dist
             return
 
         if hpat.config._has_xenon and fdef == ('read_xenon_str', 'numba.extending'):
@@ -603,8 +611,8 @@ class DistributedAnalysis(object):
         self._analyze_call_set_REP(lhs, args, array_dists, 'array.' + func_name)
 
     def _analyze_call_df(self, lhs, arr, func_name, args, array_dists):
-        # to_csv() can be parallelized
-        if func_name == 'to_csv':
+        # to_csv() and to_parquet() can be parallelized
+        if func_name in ('to_csv', 'to_parquet'):
             return
 
         # set REP if not found
@@ -4,6 +4,7 @@
 The description of the distributed_api module will be here.
 """
 import time
+import ctypes
 from enum import Enum
 import llvmlite.binding as ll
 import operator
@@ -35,6 +36,10 @@ ll.add_symbol('c_bcast', transport.c_bcast)
 ll.add_symbol('c_recv', transport.hpat_dist_recv)
 ll.add_symbol('c_send', transport.hpat_dist_send)
 
+if config.config_transport_mpi_hierarchical:
+    ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_int)(transport.hpat_dist_set_hierarchical)(
+        1, config.config_transport_mpi_node_size)
+
 
 # get size dynamically from C code (mpich 3.2 is 4 bytes but openmpi 1.6 is 8)
 mpi_req_numba_type = getattr(types, "int" + str(8 * transport.mpi_req_num_bytes))
@@ -413,6 +418,7 @@ def local_len(A):
 
 
 # send_data, recv_data, send_counts, recv_counts, send_disp, recv_disp, typ_enum
+# counts and displacements are int64, exchanges can exceed the int counts of MPI
 c_alltoallv = types.ExternalFunction(
     "c_alltoallv",
     types.void(
@@ -425,7 +431,6 @@ c_alltoallv = types.ExternalFunction(
         types.int32))
 
 # TODO: test
-# TODO: big alltoallv
 @numba.njit
 def alltoallv(send_data, out_data, send_counts, recv_counts, send_disp, recv_disp):  # pragma: no cover
     typ_enum = get_type_enum(send_data)
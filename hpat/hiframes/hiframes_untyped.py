@@ -747,6 +747,11 @@ class HiFrames(object):
         names_var = self._get_arg('read_csv', rhs.args, kws, 4, 'names', '')
         dtype_var = self._get_arg('read_csv', rhs.args, kws, 10, 'dtype', '')
         skiprows = self._get_str_arg('read_csv', rhs.args, kws, 16, 'skiprows', 0)
+        # lines are split and fields parsed with the default quote character only
+        if len(rhs.args) > 34 or 'quotechar' in kws:
+            quotechar = self._get_str_arg('read_csv', rhs.args, kws, 34, 'quotechar')
+            if quotechar != '"':
+                raise ValueError("pd.read_csv() supports the default quotechar '\"' only")
 
         col_names = self._get_str_or_list(names_var, default=0)
         if dtype_var is '':
@@ -944,26 +949,88 @@ class HiFrames(object):
         return []
 
     def _handle_pq_to_pandas(self, assign, lhs, rhs, t_var, label):
-        return self._gen_parquet_read(self.arrow_tables[t_var.name], lhs, label)
+        kws = dict(rhs.kws)
+        categories = ()
+        if 'categories' in kws:
+            err_msg = "to_pandas() categories should be constant list of column names"
+            categories = self._get_str_or_list(kws['categories'], list_only=True, err_msg=err_msg)
+        return self._gen_parquet_read(self.arrow_tables[t_var.name], lhs, label, categories=categories)
 
-    def _gen_parquet_read(self, fname, lhs, label):
+    def _gen_parquet_read(self, fname, lhs, label, filters=(), categories=()):
         columns, data_arrs, nodes = self.pq_handler.gen_parquet_read(
-            fname, lhs)
+            fname, lhs, filters, categories)
         n_cols = len(columns)
         data_args = ", ".join('data{}'.format(i) for i in range(n_cols))
 
+        # filter values are passed as arguments if variables, or globals if constants
+        args = list(data_arrs)
+        glbls = {}
+        conds = []
+        for i, (cname, op, value) in enumerate(filters):
+            if isinstance(value, ir.Var):
+                args.append(value)
+                data_args += ", filter_value{}".format(i)
+            else:
+                glbls['filter_value{}'.format(i)] = value
+            op = '==' if op == '=' else op
+            conds.append("(df['{}'] {} filter_value{})".format(cname, op, i))
+
         func_text = "def _init_df({}):\n".format(data_args)
-        func_text += "  return hpat.hiframes.pd_dataframe_ext.init_dataframe({}, None, {})\n".format(
-            data_args, ", ".join("'{}'".format(c) for c in columns))
+        func_text += "  df = hpat.hiframes.pd_dataframe_ext.init_dataframe({}, None, {})\n".format(
+            ", ".join('data{}'.format(i) for i in range(n_cols)), ", ".join("'{}'".format(c) for c in columns))
+        # skipping row groups is only based on statistics, matching rows are selected here
+        if conds:
+            func_text += "  df = df[{}]\n".format(" & ".join(conds))
+        func_text += "  return df\n"
         loc_vars = {}
         exec(func_text, {}, loc_vars)
         _init_df = loc_vars['_init_df']
 
-        return self._replace_func(_init_df, data_arrs, pre_nodes=nodes)
+        return self._replace_func(_init_df, args, pre_nodes=nodes, extra_globals=glbls)
 
     def _handle_pd_read_parquet(self, assign, lhs, rhs, label):
-        fname = rhs.args[0]
-        return self._gen_parquet_read(fname, lhs, label)
+        kws = dict(rhs.kws)
+        fname = self._get_arg('read_parquet', rhs.args, kws, 0, 'path')
+        filters = self._get_parquet_filters(kws.get('filters', None))
+        return self._gen_parquet_read(fname, lhs, label, filters)
+
+    def _get_parquet_filters(self, filters_var):
+        """get filters=[(column, op, value), ...] of read_parquet() as a list of
+        (column name, operator, value variable or constant), all terms combined with 'and'
+        """
+        if filters_var is None:
+            return []
+        err_msg = ("read_parquet() filters should be a constant list of (column, op, value) "
+                   "tuples with op in {}".format(list(parquet_pio._pq_filter_ops.keys())))
+        filters_def = guard(get_definition, self.func_ir, filters_var)
+        if isinstance(filters_def, ir.Const) and isinstance(filters_def.value, (list, tuple)):
+            terms = [tuple(f) for f in filters_def.value]
+        elif isinstance(filters_def, ir.Expr) and filters_def.op in ('build_list', 'build_tuple'):
+            terms = []
+            for f in filters_def.items:
+                f_def = guard(get_definition, self.func_ir, f)
+                if isinstance(f_def, ir.Const) and isinstance(f_def.value, tuple):
+                    terms.append(f_def.value)
+                elif isinstance(f_def, ir.Expr) and f_def.op == 'build_tuple':
+                    terms.append(tuple(f_def.items))
+                else:
+                    raise ValueError(err_msg)
+        else:
+            raise ValueError(err_msg)
+
+        filters = []
+        for term in terms:
+            if len(term) != 3:
+                raise ValueError(err_msg)
+            cname, op, value = term
+            if isinstance(cname, ir.Var):
+                cname = guard(find_const, self.func_ir, cname)
+            if isinstance(op, ir.Var):
+                op = guard(find_const, self.func_ir, op)
+            if not isinstance(cname, str) or op not in parquet_pio._pq_filter_ops:
+                raise ValueError(err_msg)
+            filters.append((cname, op, value))
+        return filters
 
     def _handle_concat(self, assign, lhs, rhs, label):
         # converting build_list to build_tuple before type inference to avoid
@@ -14,7 +14,7 @@ import numpy as np
 
 import numba
 from numba import typeinfer, ir, ir_utils, config, types, generated_jit
-from numba.extending import overload
+from numba.extending import overload, intrinsic
 from numba.ir_utils import (visit_vars_inner, replace_vars_inner,
                             compile_to_numba_ir, replace_arg_nodes,
                             mk_unique_var)
@@ -28,7 +28,7 @@ from hpat.str_arr_ext import (string_array_type, to_string_list,
                               get_offset_ptr, get_data_ptr, convert_len_arr_to_offset,
                               pre_alloc_string_array, num_total_chars,
                               getitem_str_offset, copy_str_arr_slice,
-                              str_copy_ptr, get_utf8_size,
+                              str_copy_ptr, get_utf8_size, get_data_ptr_ind,
                               setitem_str_offset, str_arr_set_na)
 from hpat.str_ext import string_type
 from hpat.timsort import copyElement_tup, getitem_arr_tup, setitem_arr_tup
@@ -354,10 +354,21 @@ def join_distributed_run(join_node, array_dists, typemap, calltypes, typingctx,
             # only the right key needs to be aligned
             func_text += "    t2_keys, data_right = parallel_asof_comm(t1_keys, t2_keys, data_right)\n"
     else:
-        if left_parallel:
-            func_text += "    t1_keys, data_left = parallel_join(t1_keys, data_left)\n"
-        if right_parallel:
-            func_text += "    t2_keys, data_right = parallel_join(t2_keys, data_right)\n"
+        # both tables have to be shuffled with the same hash
+        key_typs = tuple(typemap[v.name] for v in left_key_vars + right_key_vars)
+        hash_keys_supported = all(_is_hash_key_type(t) for t in key_typs)
+        parallel_join_func = 'parallel_join' if hash_keys_supported else 'parallel_join_py_hash'
+        skew_local_sides = _get_skew_local_sides(join_node.how)
+        if (left_parallel and right_parallel and hash_keys_supported and skew_local_sides != 0
+                and hpat_config.config_join_skew_threshold > 0):
+            func_text += ("    t1_keys, data_left, t2_keys, data_right"
+                          " = parallel_join_skew(t1_keys, data_left, t2_keys, data_right, {})\n").format(
+                              skew_local_sides)
+        else:
+            if left_parallel:
+                func_text += "    t1_keys, data_left = {}(t1_keys, data_left)\n".format(parallel_join_func)
+            if right_parallel:
+                func_text += "    t2_keys, data_right = {}(t2_keys, data_right)\n".format(parallel_join_func)
         #func_text += "    print(t2_key, data_right)\n"
 
     if method == 'sort' and join_node.how != 'asof':
@@ -437,6 +448,8 @@ def join_distributed_run(join_node, array_dists, typemap, calltypes, typingctx,
         'to_string_list': to_string_list,
         'cp_str_list_to_array': cp_str_list_to_array,
         'parallel_join': parallel_join,
+        'parallel_join_py_hash': parallel_join_py_hash,
+        'parallel_join_skew': parallel_join_skew,
         'parallel_asof_comm': parallel_asof_comm}
 
     f_block = compile_to_numba_ir(join_impl,
@@ -472,27 +485,80 @@ def _get_table_parallel_flags(join_node, array_dists):
     return left_parallel, right_parallel
 
 
+def _get_skew_local_sides(how):
+    """tables of a join which can keep the rows of heavy keys on their node (bit 0 left, bit 1 right)
+
+    The other table sends the rows of the key to all nodes, so its rows can't be unmatched rows
+    of the output. Outer joins are partitioned by hash.
+    """
+    return {'inner': 3, 'left': 1, 'right': 2}.get(how, 0)
+
+
 # @numba.njit
 def parallel_join_impl(key_arrs, data):
     # alloc shuffle meta
     n_pes = hpat.distributed_api.get_size()
     pre_shuffle_meta = alloc_pre_shuffle_metadata(key_arrs, data, n_pes, False)
 
-    # calc send/recv counts
+    # node of every row and send counts in one pass over the keys
+    node_ids = np.empty(len(key_arrs[0]), np.int32)
+    hash_shuffle_keys(key_arrs, pre_shuffle_meta.send_counts, node_ids)
+
+    return shuffle_join_table(key_arrs, data, pre_shuffle_meta, node_ids, n_pes, 0)
+
+
+# @numba.njit
+def parallel_join_py_hash_impl(key_arrs, data):
+    # alloc shuffle meta
+    n_pes = hpat.distributed_api.get_size()
+    pre_shuffle_meta = alloc_pre_shuffle_metadata(key_arrs, data, n_pes, False)
+
+    # calc send counts with Python's hash for keys hash_shuffle_keys doesn't support
+    node_ids = np.empty(len(key_arrs[0]), np.int32)
     for i in range(len(key_arrs[0])):
         val = getitem_arr_tup_single(key_arrs, i)
         node_id = hash(val) % n_pes
-        update_shuffle_meta(pre_shuffle_meta, node_id, i, val_to_tup(val), getitem_arr_tup(data, i), False)
+        node_ids[i] = node_id
+        pre_shuffle_meta.send_counts[node_id] += 1
+
+    return shuffle_join_table(key_arrs, data, pre_shuffle_meta, node_ids, n_pes, 0)
+
 
+# @numba.njit
+def parallel_join_skew_impl(t1_keys, data_left, t2_keys, data_right, local_sides):
+    n_pes = hpat.distributed_api.get_size()
+    rank = hpat.distributed_api.get_rank()
+
+    # heavy keys from the key hashes of both tables
+    hashes1 = np.empty(len(t1_keys[0]), np.uint64)
+    hash_keys(t1_keys, hashes1)
+    hashes2 = np.empty(len(t2_keys[0]), np.uint64)
+    hash_keys(t2_keys, hashes2)
+    heavy_hashes = np.empty(_max_heavy_keys, np.uint64)
+    heavy_local = np.empty(_max_heavy_keys, np.int32)
+    n_heavy = join_heavy_keys(hashes1, hashes2, local_sides, heavy_hashes, heavy_local)
+
+    pre_shuffle_meta1 = alloc_pre_shuffle_metadata(t1_keys, data_left, n_pes, False)
+    node_ids1 = np.empty(len(hashes1), np.int32)
+    skew_shuffle_keys(hashes1, heavy_hashes, heavy_local, n_heavy, 0, rank, pre_shuffle_meta1.send_counts, node_ids1)
+    out_keys1, out_data1 = shuffle_join_table(t1_keys, data_left, pre_shuffle_meta1, node_ids1, n_pes, n_heavy)
+
+    pre_shuffle_meta2 = alloc_pre_shuffle_metadata(t2_keys, data_right, n_pes, False)
+    node_ids2 = np.empty(len(hashes2), np.int32)
+    skew_shuffle_keys(hashes2, heavy_hashes, heavy_local, n_heavy, 1, rank, pre_shuffle_meta2.send_counts, node_ids2)
+    out_keys2, out_data2 = shuffle_join_table(t2_keys, data_right, pre_shuffle_meta2, node_ids2, n_pes, n_heavy)
+
+    return out_keys1, out_data1, out_keys2, out_data2
+
+
+@numba.njit
+def shuffle_join_table(key_arrs, data, pre_shuffle_meta, node_ids, n_pes, n_heavy):
+    update_shuffle_meta_chars(pre_shuffle_meta, node_ids, key_arrs, data)
     shuffle_meta = finalize_shuffle_meta(key_arrs, data, pre_shuffle_meta, n_pes, False)
+    join_report_recv(shuffle_meta.n_out, n_heavy)
 
     # write send buffers
-    for i in range(len(key_arrs[0])):
-        val = getitem_arr_tup_single(key_arrs, i)
-        node_id = hash(val) % n_pes
-        write_send_buff(shuffle_meta, node_id, i, val_to_tup(val), data)
-        # update last since it is reused in data
-        shuffle_meta.tmp_offset[node_id] += 1
+    write_send_buffs(shuffle_meta, node_ids, key_arrs, data)
 
     # shuffle
     recvs = alltoallv_tup(key_arrs + data, shuffle_meta)
@@ -507,6 +573,16 @@ def parallel_join(key_arrs, data):
     return parallel_join_impl
 
 
+@generated_jit(nopython=True, cache=True)
+def parallel_join_py_hash(key_arrs, data):
+    return parallel_join_py_hash_impl
+
+
+@generated_jit(nopython=True, cache=True)
+def parallel_join_skew(t1_keys, data_left, t2_keys, data_right, local_sides):
+    return parallel_join_skew_impl
+
+
 @numba.njit
 def parallel_asof_comm(left_key_arrs, right_key_arrs, right_data):
     # align the left and right intervals
@@ -519,9 +595,9 @@ def parallel_asof_comm(left_key_arrs, right_key_arrs, right_data):
     hpat.distributed_api.allgather(bnd_starts, left_key_arrs[0][0])
     hpat.distributed_api.allgather(bnd_ends, left_key_arrs[0][-1])
 
-    send_counts = np.zeros(n_pes, np.int32)
-    send_disp = np.zeros(n_pes, np.int32)
-    recv_counts = np.zeros(n_pes, np.int32)
+    send_counts = np.zeros(n_pes, np.int64)
+    send_disp = np.zeros(n_pes, np.int64)
+    recv_counts = np.zeros(n_pes, np.int64)
     my_start = right_key_arrs[0][0]
     my_end = right_key_arrs[0][-1]
 
@@ -676,8 +752,261 @@ else:
 
 ll.add_symbol('get_join_sendrecv_counts', transport.get_join_sendrecv_counts)
 ll.add_symbol('c_alltoallv', transport.c_alltoallv)
+ll.add_symbol('join_heavy_keys', transport.join_heavy_keys)
+ll.add_symbol('join_report_recv', transport.join_report_recv)
 
 ll.add_symbol('timsort', chiframes.timsort)
+ll.add_symbol('hash_shuffle_keys', chiframes.hash_shuffle_keys)
+ll.add_symbol('shuffle_pack', chiframes.shuffle_pack)
+ll.add_symbol('hash_keys', chiframes.hash_keys)
+ll.add_symbol('skew_shuffle_keys', chiframes.skew_shuffle_keys)
+
+# key type of string arrays in hash_shuffle_keys, HPAT_HASH_KEY_STRING in _hpat_hash.h
+_hash_key_string_typ_enum = 100
+
+# most keys of a skewed join handled as heavy keys
+_max_heavy_keys = 64
+
+
+def _is_hash_key_type(typ):
+    """key arrays hash_shuffle_keys supports"""
+    return typ == string_array_type or (isinstance(typ, types.Array) and typ.dtype in _numba_to_c_type_map)
+
+
+def _gen_key_arr_ptrs(context, builder, key_arrs_t, key_arrs):
+    """arrays of the type enums, data pointers and offsets (NULL if not strings) of key arrays"""
+    n_keys = len(key_arrs_t.types)
+    i8_ptr = lir.IntType(8).as_pointer()
+    i32_ptr = lir.IntType(32).as_pointer()
+    key_types = cgutils.alloca_once(builder, lir.IntType(32), n_keys)
+    key_datas = cgutils.alloca_once(builder, i8_ptr, n_keys)
+    key_offsets = cgutils.alloca_once(builder, i32_ptr, n_keys)
+    n_rows = None
+    for i, typ in enumerate(key_arrs_t.types):
+        arr = builder.extract_value(key_arrs, i)
+        if typ == string_array_type:
+            str_arr = context.make_helper(builder, string_array_type, arr)
+            type_enum = _hash_key_string_typ_enum
+            data = str_arr.data
+            offsets = builder.bitcast(str_arr.offsets, i32_ptr)
+            n_rows = str_arr.num_items
+        else:
+            arr_struct = make_array(typ)(context, builder, arr)
+            type_enum = _numba_to_c_type_map[typ.dtype]
+            data = arr_struct.data
+            offsets = lir.Constant(i32_ptr, None)
+            n_rows = arr_struct.nitems
+        builder.store(lir.Constant(lir.IntType(32), type_enum), cgutils.gep_inbounds(builder, key_types, i))
+        builder.store(builder.bitcast(data, i8_ptr), cgutils.gep_inbounds(builder, key_datas, i))
+        builder.store(offsets, cgutils.gep_inbounds(builder, key_offsets, i))
+    return n_rows, lir.Constant(lir.IntType(32), n_keys), key_types, key_datas, key_offsets
+
+
+@intrinsic
+def hash_shuffle_keys(typingctx, key_arrs_t, send_counts_t, node_ids_t):
+    """set the node of every row by a hash of its keys and count the rows of every node"""
+    assert all(_is_hash_key_type(t) for t in key_arrs_t.types)
+
+    def codegen(context, builder, sig, args):
+        key_arrs, send_counts, node_ids = args
+        i8_ptr = lir.IntType(8).as_pointer()
+        i32_ptr = lir.IntType(32).as_pointer()
+        key_args = _gen_key_arr_ptrs(context, builder, key_arrs_t, key_arrs)
+        send_counts_struct = make_array(send_counts_t)(context, builder, send_counts)
+        node_ids_struct = make_array(node_ids_t)(context, builder, node_ids)
+        fnty = lir.FunctionType(lir.VoidType(),
+                                [lir.IntType(64), lir.IntType(32), i32_ptr, i8_ptr.as_pointer(),
+                                 i32_ptr.as_pointer(), lir.IntType(32), i32_ptr, lir.IntType(64).as_pointer()])
+        fn = builder.module.get_or_insert_function(fnty, name="hash_shuffle_keys")
+        builder.call(fn, list(key_args) + [builder.trunc(send_counts_struct.nitems, lir.IntType(32)),
+                                           node_ids_struct.data, send_counts_struct.data])
+        return context.get_dummy_value()
+
+    return signature(types.none, key_arrs_t, send_counts_t, node_ids_t), codegen
+
+
+@intrinsic
+def hash_keys(typingctx, key_arrs_t, hashes_t):
+    """set the hash of the keys of every row, the same hash hash_shuffle_keys uses"""
+    assert all(_is_hash_key_type(t) for t in key_arrs_t.types)
+
+    def codegen(context, builder, sig, args):
+        key_arrs, hashes = args
+        i8_ptr = lir.IntType(8).as_pointer()
+        i32_ptr = lir.IntType(32).as_pointer()
+        key_args = _gen_key_arr_ptrs(context, builder, key_arrs_t, key_arrs)
+        hashes_struct = make_array(hashes_t)(context, builder, hashes)
+        fnty = lir.FunctionType(lir.VoidType(),
+                                [lir.IntType(64), lir.IntType(32), i32_ptr, i8_ptr.as_pointer(),
+                                 i32_ptr.as_pointer(), lir.IntType(64).as_pointer()])
+        fn = builder.module.get_or_insert_function(fnty, name="hash_keys")
+        builder.call(fn, list(key_args) + [hashes_struct.data])
+        return context.get_dummy_value()
+
+    return signature(types.none, key_arrs_t, hashes_t), codegen
+
+
+@intrinsic
+def join_heavy_keys(typingctx, hashes1_t, hashes2_t, local_sides_t, heavy_hashes_t, heavy_local_t):
+    """find the heavy keys of a join by the key hashes of its tables on all nodes, return their number"""
+    def codegen(context, builder, sig, args):
+        hashes1, hashes2, _, heavy_hashes, heavy_local = [
+            make_array(t)(context, builder, a) if isinstance(t, types.Array) else None
+            for t, a in zip(sig.args, args)]
+        local_sides = context.cast(builder, args[2], sig.args[2], types.int32)
+        i32_ptr = lir.IntType(32).as_pointer()
+        i64_ptr = lir.IntType(64).as_pointer()
+        fnty = lir.FunctionType(lir.IntType(64),
+                                [i64_ptr, lir.IntType(64), i64_ptr, lir.IntType(64), lir.IntType(64),
+                                 lir.DoubleType(), lir.IntType(32), lir.IntType(64), i64_ptr, i32_ptr])
+        fn = builder.module.get_or_insert_function(fnty, name="join_heavy_keys")
+        return builder.call(fn, [hashes1.data, hashes1.nitems, hashes2.data, hashes2.nitems,
+                                 lir.Constant(lir.IntType(64), hpat_config.config_join_skew_sample_size),
+                                 lir.Constant(lir.DoubleType(), hpat_config.config_join_skew_threshold),
+                                 local_sides, heavy_hashes.nitems, heavy_hashes.data, heavy_local.data])
+
+    return signature(types.int64, hashes1_t, hashes2_t, local_sides_t, heavy_hashes_t, heavy_local_t), codegen
+
+
+@intrinsic
+def skew_shuffle_keys(typingctx, hashes_t, heavy_hashes_t, heavy_local_t, n_heavy_t, side_t, rank_t,
+                      send_counts_t, node_ids_t):
+    """set the node of every row of a table of a skewed join (side 0 left, 1 right) and count the rows
+    of every node. Rows sent to all nodes have node -1
+    """
+    def codegen(context, builder, sig, args):
+        hashes, heavy_hashes, heavy_local, _, _, _, send_counts, node_ids = [
+            make_array(t)(context, builder, a) if isinstance(t, types.Array) else None
+            for t, a in zip(sig.args, args)]
+        n_heavy = context.cast(builder, args[3], sig.args[3], types.int64)
+        side = context.cast(builder, args[4], sig.args[4], types.int32)
+        rank = context.cast(builder, args[5], sig.args[5], types.int32)
+        i32_ptr = lir.IntType(32).as_pointer()
+        i64_ptr = lir.IntType(64).as_pointer()
+        fnty = lir.FunctionType(lir.VoidType(),
+                                [lir.IntType(64), i64_ptr, lir.IntType(64), i64_ptr, i32_ptr, lir.IntType(32),
+                                 lir.IntType(32), lir.IntType(32), i32_ptr, i64_ptr])
+        fn = builder.module.get_or_insert_function(fnty, name="skew_shuffle_keys")
+        builder.call(fn, [hashes.nitems, hashes.data, n_heavy, heavy_hashes.data, heavy_local.data, side, rank,
+                          builder.trunc(send_counts.nitems, lir.IntType(32)), node_ids.data, send_counts.data])
+        return context.get_dummy_value()
+
+    return signature(types.none, hashes_t, heavy_hashes_t, heavy_local_t, n_heavy_t, side_t, rank_t,
+                     send_counts_t, node_ids_t), codegen
+
+
+@intrinsic
+def join_report_recv(typingctx, n_recv_t, n_heavy_t):
+    """print the rows every node received in a join shuffle if config_join_report_recv is set"""
+    def codegen(context, builder, sig, args):
+        if not hpat_config.config_join_report_recv:
+            return context.get_dummy_value()
+        n_recv = context.cast(builder, args[0], sig.args[0], types.int64)
+        n_heavy = context.cast(builder, args[1], sig.args[1], types.int64)
+        fnty = lir.FunctionType(lir.VoidType(), [lir.IntType(64), lir.IntType(64)])
+        fn = builder.module.get_or_insert_function(fnty, name="join_report_recv")
+        builder.call(fn, [n_recv, n_heavy])
+        return context.get_dummy_value()
+
+    return signature(types.none, n_recv_t, n_heavy_t), codegen
+
+
+@intrinsic
+def shuffle_pack(typingctx, arr_t, node_ids_t, send_disp_t, send_buff_t):
+    """write the values of arr to send_buff in node order, node n starting at send_disp[n]"""
+    def codegen(context, builder, sig, args):
+        arr, node_ids, send_disp, send_buff = [make_array(t)(context, builder, a) for t, a in zip(sig.args, args)]
+        i8_ptr = lir.IntType(8).as_pointer()
+        i32_ptr = lir.IntType(32).as_pointer()
+        elem_size = context.get_abi_sizeof(context.get_data_type(arr_t.dtype))
+        fnty = lir.FunctionType(lir.VoidType(), [lir.IntType(64), i32_ptr, lir.IntType(64).as_pointer(),
+                                                 lir.IntType(32), lir.IntType(64), i8_ptr, i8_ptr])
+        fn = builder.module.get_or_insert_function(fnty, name="shuffle_pack")
+        builder.call(fn, [arr.nitems, node_ids.data, send_disp.data,
+                          builder.trunc(send_disp.nitems, lir.IntType(32)),
+                          lir.Constant(lir.IntType(64), elem_size),
+                          builder.bitcast(arr.data, i8_ptr), builder.bitcast(send_buff.data, i8_ptr)])
+        return context.get_dummy_value()
+
+    return signature(types.none, arr_t, node_ids_t, send_disp_t, send_buff_t), codegen
+
+
+def _gen_row_nodes(n_pes):
+    """func_text of the range of nodes of row i, all nodes if its node is -1 (skewed joins)"""
+    func_text = "    first_node = node_ids[i]\n"
+    func_text += "    last_node = first_node + 1\n"
+    func_text += "    if first_node == -1:\n"
+    func_text += "      first_node = 0\n"
+    func_text += "      last_node = {}\n".format(n_pes)
+    return func_text
+
+
+def update_shuffle_meta_chars(pre_shuffle_meta, node_ids, key_arrs, data):  # pragma: no cover
+    return
+
+
+@overload(update_shuffle_meta_chars)
+def update_shuffle_meta_chars_overload(pre_shuffle_meta, node_ids, key_arrs, data):
+    """update 'send_counts_char' of string columns, like update_shuffle_meta for all rows"""
+    func_text = "def f(pre_shuffle_meta, node_ids, key_arrs, data):\n"
+    n_keys = len(key_arrs.types)
+    str_cols = [i for i, typ in enumerate(key_arrs.types + data.types) if typ == string_array_type]
+    if str_cols:
+        func_text += "  for i in range(len(node_ids)):\n"
+        func_text += _gen_row_nodes("len(pre_shuffle_meta.send_counts)")
+    for n_str, i in enumerate(str_cols):
+        arr = "key_arrs[{}]".format(i) if i < n_keys else "data[{}]".format(i - n_keys)
+        func_text += "    n_chars = getitem_str_offset({0}, i + 1) - getitem_str_offset({0}, i)\n".format(arr)
+        func_text += "    for node_id in range(first_node, last_node):\n"
+        func_text += "      pre_shuffle_meta.send_counts_char_tup[{}][node_id] += n_chars\n".format(n_str)
+    func_text += "  return\n"
+
+    loc_vars = {}
+    exec(func_text, {'getitem_str_offset': getitem_str_offset}, loc_vars)
+    update_impl = loc_vars['f']
+    return update_impl
+
+
+def write_send_buffs(shuffle_meta, node_ids, key_arrs, data):  # pragma: no cover
+    return
+
+
+@overload(write_send_buffs)
+def write_send_buffs_overload(meta, node_ids, key_arrs, data):
+    """write all rows to the send buffers, column by column for array columns"""
+    func_text = "def f(meta, node_ids, key_arrs, data):\n"
+    n_keys = len(key_arrs.types)
+    str_cols = []
+    for i, typ in enumerate(key_arrs.types + data.types):
+        arr = "key_arrs[{}]".format(i) if i < n_keys else "data[{}]".format(i - n_keys)
+        if isinstance(typ, types.Array):
+            func_text += "  shuffle_pack({}, node_ids, meta.send_disp, meta.send_buff_tup[{}])\n".format(arr, i)
+        else:
+            assert typ == string_array_type
+            str_cols.append(arr)
+    if str_cols:
+        func_text += "  for i in range(len(node_ids)):\n"
+        func_text += _gen_row_nodes("len(meta.send_disp)")
+        func_text += "    for node_id in range(first_node, last_node):\n"
+        func_text += "      w_ind = meta.send_disp[node_id] + meta.tmp_offset[node_id]\n"
+    for n_str, arr in enumerate(str_cols):
+        func_text += "      start = getitem_str_offset({}, i)\n".format(arr)
+        func_text += "      n_chars = getitem_str_offset({}, i + 1) - start\n".format(arr)
+        func_text += "      meta.send_arr_lens_tup[{}][w_ind] = n_chars\n".format(n_str)
+        func_text += "      indc = meta.send_disp_char_tup[{0}][node_id]".format(n_str)
+        func_text += " + meta.tmp_offset_char_tup[{0}][node_id]\n".format(n_str)
+        func_text += "      str_copy_ptr(meta.send_arr_chars_tup[{}], indc,".format(n_str)
+        func_text += " get_data_ptr_ind({}, start), n_chars)\n".format(arr)
+        func_text += "      meta.tmp_offset_char_tup[{}][node_id] += n_chars\n".format(n_str)
+    if str_cols:
+        func_text += "      meta.tmp_offset[node_id] += 1\n"
+    func_text += "  return\n"
+
+    loc_vars = {}
+    exec(func_text, {'shuffle_pack': shuffle_pack, 'getitem_str_offset': getitem_str_offset,
+                     'str_copy_ptr': str_copy_ptr, 'get_data_ptr_ind': get_data_ptr_ind}, loc_vars)
+    write_impl = loc_vars['f']
+    return write_impl
 
 
 @numba.njit
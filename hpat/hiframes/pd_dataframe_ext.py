@@ -1599,6 +1599,18 @@ def lower_count_dummy(context, builder, sig, args):
         sig.return_type)(context, builder)
     return out_obj._getvalue()
 
+
+@overload_method(DataFrameType, 'to_parquet')
+def to_parquet_overload(df, fname, engine='auto', compression='snappy', index=None, partition_cols=None):
+    # distributed dataframes are written in parallel by the distributed pass
+
+    def _impl(df, fname, engine='auto', compression='snappy', index=None, partition_cols=None):
+        with numba.objmode:
+            df.to_parquet(fname, engine, compression, index, partition_cols)
+
+    return _impl
+
+
 # TODO: other Pandas versions (0.24 defaults are different than 0.23)
 @overload_method(DataFrameType, 'to_csv')
 def to_csv_overload(df, path_or_buf=None, sep=',', na_rep='', float_format=None,
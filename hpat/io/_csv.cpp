@@ -6,7 +6,12 @@
   When called in a parallel/distributed setup, each process owns a
   chunk of the csv file only. The chunks are balanced by number of
   lines (not neessarily number of bytes). The actual file read is
-  done lazily in the objects read method.
+  done lazily in the objects read method. For files the chunk is
+  mmapped: read/readbytes/readinto copy straight out of the mapping
+  and the buffer protocol gives zero-copy access to the whole chunk.
+
+  For the column types it supports, the native parser reads the same
+  chunk directly into column buffers instead (see _csv_parser.h).
 */
 #include <Python.h>
 #include <boost/filesystem/operations.hpp>
@@ -14,6 +19,7 @@
 #include <cinttypes>
 #include <cstdint>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -22,6 +28,9 @@
 
 #include "../_datetime_ext.h"
 #include "_csv.h"
+#include "_csv_lines.h"
+#include "_csv_parser.h"
+#include "_csv_writer.h"
 
 //TODO This function must be deleted or corresponding code should be refactored
 static void* get_py_registered_symbold(const char* module, const char* name)
@@ -56,11 +65,12 @@ typedef struct
 {
     PyObject_HEAD;
     /* Your internal buffer, size and pos */
-    std::istream* ifs;     // input stream
-    size_t chunk_start;    // start of our chunk
-    size_t chunk_size;     // size of our chunk
-    size_t chunk_pos;      // current position in our chunk
-    std::vector<char> buf; // internal buffer for converting stream input to Unicode object
+    std::istream* ifs;        // input stream
+    csv_mapped_range* mapped; // mmap of our chunk if backed by a file, reads bypass ifs then
+    size_t chunk_start;       // start of our chunk
+    size_t chunk_size;        // size of our chunk
+    size_t chunk_pos;         // current position in our chunk
+    std::vector<char> buf;    // internal buffer for converting stream input to Unicode object
 } stream_reader;
 
 static void stream_reader_dealloc(stream_reader* self)
@@ -70,6 +80,10 @@ static void stream_reader_dealloc(stream_reader* self)
     {
         delete self->ifs;
     }
+    if (self->mapped)
+    {
+        delete self->mapped;
+    }
 
     Py_TYPE(self)->tp_free(self);
 }
@@ -84,6 +98,7 @@ static PyObject* stream_reader_new(PyTypeObject* type, PyObject* args, PyObject*
         return NULL;
     }
     self->ifs = NULL;
+    self->mapped = NULL;
     self->chunk_start = 0;
     self->chunk_size = 0;
     self->chunk_pos = 0;
@@ -120,8 +135,8 @@ static int stream_reader_pyinit(PyObject* self, PyObject* args, PyObject* kwds)
 }
 
 // We use this (and not the above) from C to init our StreamReader object
-// Will seek to chunk beginning
-static void stream_reader_init(stream_reader* self, std::istream* ifs, size_t start, size_t sz)
+// Will seek to chunk beginning, and mmap the chunk if the stream is file fname
+static void stream_reader_init(stream_reader* self, std::istream* ifs, const char* fname, size_t start, size_t sz)
 {
     if (!ifs)
     {
@@ -144,54 +159,88 @@ static void stream_reader_init(stream_reader* self, std::istream* ifs, size_t st
     self->chunk_start = start;
     self->chunk_size = sz;
     self->chunk_pos = 0;
+
+    if (fname != NULL)
+    {
+        self->mapped = new csv_mapped_range(fname, start, sz);
+        if (self->mapped->data() == NULL)
+        {
+            delete self->mapped;
+            self->mapped = NULL;
+        }
+    }
 }
 
-// read given number of bytes from our chunk and return a Unicode Object
-// returns NULL if an error occured.
-// does not read beyond end of our chunk (even if file continues)
-static PyObject* stream_reader_read(stream_reader* self, PyObject* args)
+// clip requested number of bytes to what is left in our chunk, negative means all
+static Py_ssize_t stream_reader_remaining(stream_reader* self, Py_ssize_t size)
 {
-    // partially copied from from CPython's stringio.c
-
-    if (self->ifs == NULL)
+    Py_ssize_t n = self->chunk_size - self->chunk_pos;
+    if (size < 0 || size > n)
     {
-        PyErr_SetString(PyExc_ValueError, "I/O operation on uninitialized StreamReader object");
-        return NULL;
+        size = n;
+        if (size < 0)
+            size = 0;
     }
+    return size;
+}
 
-    Py_ssize_t size, n;
-
+// parse optional size argument of read methods, -1 if absent or None
+static bool stream_reader_parse_size(PyObject* args, const char* format, Py_ssize_t* size)
+{
     PyObject* arg = Py_None;
-    if (!PyArg_ParseTuple(args, "|O:read", &arg))
+    if (!PyArg_ParseTuple(args, format, &arg))
     {
-        return NULL;
+        return false;
     }
     if (PyNumber_Check(arg))
     {
-        size = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
-        if (size == -1 && PyErr_Occurred())
+        *size = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+        if (*size == -1 && PyErr_Occurred())
         {
-            return NULL;
+            return false;
         }
     }
     else if (arg == Py_None)
     {
         /* Read until EOF is reached, by default. */
-        size = -1;
+        *size = -1;
     }
     else
     {
         PyErr_Format(PyExc_TypeError, "integer argument expected, got '%s'", Py_TYPE(arg)->tp_name);
+        return false;
+    }
+    return true;
+}
+
+// read given number of bytes from our chunk and return a Unicode Object
+// returns NULL if an error occured.
+// does not read beyond end of our chunk (even if file continues)
+static PyObject* stream_reader_read(stream_reader* self, PyObject* args)
+{
+    // partially copied from from CPython's stringio.c
+
+    if (self->ifs == NULL)
+    {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on uninitialized StreamReader object");
+        return NULL;
+    }
+
+    Py_ssize_t size;
+    if (!stream_reader_parse_size(args, "|O:read", &size))
+    {
         return NULL;
     }
 
     /* adjust invalid sizes */
-    n = self->chunk_size - self->chunk_pos;
-    if (size < 0 || size > n)
+    size = stream_reader_remaining(self, size);
+
+    // decode straight from the mapped chunk
+    if (self->mapped)
     {
-        size = n;
-        if (size < 0)
-            size = 0;
+        PyObject* res = PyUnicode_FromStringAndSize(self->mapped->data() + self->chunk_pos, size);
+        self->chunk_pos += size;
+        return res;
     }
 
     self->buf.resize(size);
@@ -206,6 +255,103 @@ static PyObject* stream_reader_read(stream_reader* self, PyObject* args)
     return PyUnicode_FromStringAndSize(self->buf.data(), size);
 }
 
+// read given number of bytes from our chunk and return a bytes object, no decoding involved
+static PyObject* stream_reader_readbytes(stream_reader* self, PyObject* args)
+{
+    if (self->ifs == NULL)
+    {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on uninitialized StreamReader object");
+        return NULL;
+    }
+
+    Py_ssize_t size;
+    if (!stream_reader_parse_size(args, "|O:readbytes", &size))
+    {
+        return NULL;
+    }
+    size = stream_reader_remaining(self, size);
+
+    if (self->mapped)
+    {
+        PyObject* res = PyBytes_FromStringAndSize(self->mapped->data() + self->chunk_pos, size);
+        self->chunk_pos += size;
+        return res;
+    }
+
+    // read into the bytes object directly
+    PyObject* res = PyBytes_FromStringAndSize(NULL, size);
+    if (res == NULL)
+    {
+        return NULL;
+    }
+    self->ifs->read(PyBytes_AS_STRING(res), size);
+    self->chunk_pos += size;
+    if (!*self->ifs)
+    {
+        Py_DECREF(res);
+        PyErr_Format(PyExc_IOError, "Failed reading %zd bytes", size);
+        return NULL;
+    }
+    return res;
+}
+
+// read from our chunk into a writable buffer (e.g. bytearray, numpy array), returns number of bytes read
+static PyObject* stream_reader_readinto(stream_reader* self, PyObject* args)
+{
+    if (self->ifs == NULL)
+    {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on uninitialized StreamReader object");
+        return NULL;
+    }
+
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "w*:readinto", &view))
+    {
+        return NULL;
+    }
+    Py_ssize_t size = stream_reader_remaining(self, view.len);
+
+    if (self->mapped)
+    {
+        memcpy(view.buf, self->mapped->data() + self->chunk_pos, size);
+    }
+    else
+    {
+        self->ifs->read((char*)view.buf, size);
+        if (!*self->ifs)
+        {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_IOError, "Failed reading %zd bytes", size);
+            return NULL;
+        }
+    }
+    self->chunk_pos += size;
+    PyBuffer_Release(&view);
+    return PyLong_FromSsize_t(size);
+}
+
+static PyObject* stream_reader_readable(stream_reader* self, PyObject* args)
+{
+    Py_RETURN_TRUE;
+}
+
+// buffer protocol: read-only view of the whole chunk, only available if it is mapped
+static int stream_reader_getbuffer(stream_reader* self, Py_buffer* view, int flags)
+{
+    if (self->mapped == NULL)
+    {
+        PyErr_SetString(PyExc_BufferError, "StreamReader is not backed by a memory mapped file");
+        view->obj = NULL;
+        return -1;
+    }
+    return PyBuffer_FillInfo(view, (PyObject*)self, (void*)self->mapped->data(), self->chunk_size, 1, flags);
+}
+
+static PyBufferProcs stream_reader_as_buffer = {
+    (getbufferproc)stream_reader_getbuffer, /* bf_getbuffer */
+    0,                                      /* bf_releasebuffer */
+};
+
 // Needed to make Pandas accept it, never used
 static PyObject* stream_reader_iternext(PyObject* self)
 {
@@ -213,7 +359,6 @@ static PyObject* stream_reader_iternext(PyObject* self)
     return NULL;
 };
 
-// our class has only one method
 static PyMethodDef stream_reader_methods[] = {
     {
         "read",
@@ -221,6 +366,24 @@ static PyMethodDef stream_reader_methods[] = {
         METH_VARARGS,
         "Read at most n characters, returned as a unicode.",
     },
+    {
+        "readbytes",
+        (PyCFunction)stream_reader_readbytes,
+        METH_VARARGS,
+        "Read at most n bytes, returned as bytes.",
+    },
+    {
+        "readinto",
+        (PyCFunction)stream_reader_readinto,
+        METH_VARARGS,
+        "Read bytes into a pre-allocated, writable buffer, returns number of bytes read.",
+    },
+    {
+        "readable",
+        (PyCFunction)stream_reader_readable,
+        METH_NOARGS,
+        "Always True.",
+    },
     {NULL} /* Sentinel */
 };
 
@@ -243,7 +406,7 @@ static PyTypeObject stream_reader_type = {
     0,                                                /*tp_str*/
     0,                                                /*tp_getattro*/
     0,                                                /*tp_setattro*/
-    0,                                                /*tp_as_buffer*/
+    &stream_reader_as_buffer,                         /*tp_as_buffer*/
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,         /*tp_flags*/
     "stream_reader objects",                          /* tp_doc */
     0,                                                /* tp_traverse */
@@ -269,37 +432,51 @@ static PyTypeObject stream_reader_type = {
 // C interface for getting the file-like chunk reader
 // ***********************************************************************************
 
+// quote character of pandas.read_csv, chunks are only split at newlines outside of quotes
+#define CSV_QUOTECHAR '"'
+
 typedef void (*hpat_mpi_csv_get_offsets)(std::istream* f,
+                                         const char* fname,
                                          size_t fsz,
                                          bool is_parallel,
                                          int64_t skiprows,
                                          int64_t nrows,
+                                         char quotechar,
                                          size_t& my_off_start,
                                          size_t& my_off_end);
 
 /**
- * Split stream into chunks and return a file-like object per rank. The returned object
- * represents the data to be read on each process.
+ * Compute the byte range of the lines of stream f owned by this rank.
  *
  * We evenly distribute by number of lines by working on byte-chunks in parallel
- *   * counting new-lines and allreducing and exscaning numbers
+ *   * counting new-lines (outside of quoted fields) and allreducing and exscaning numbers
  *   * computing start/end points of desired chunks-of-lines and sending them to corresponding ranks.
  *
- * @param[in]  f   the input stream
- * @param[in]  fsz total number of bytes in stream
- * @return     StreamReader file-like object to read the owned chunk through pandas.read_csv
+ * @param[in]  f            the input stream
+ * @param[in]  fname        name of the file behind f (its chunk is mmapped for line counting), NULL for strings
+ * @param[in]  fsz          total number of bytes in stream
+ * @param[out] my_off_start first byte of the owned lines
+ * @param[out] my_off_end   end of the owned lines (exclusive)
+ * @return     false if the transport is not available
  **/
-static PyObject* csv_chunk_reader(std::istream* f, size_t fsz, bool is_parallel, int64_t skiprows, int64_t nrows)
+static bool csv_chunk_offsets(std::istream* f,
+                              const char* fname,
+                              size_t fsz,
+                              bool is_parallel,
+                              int64_t skiprows,
+                              int64_t nrows,
+                              size_t& my_off_start,
+                              size_t& my_off_end)
 {
     if (skiprows < 0)
     {
         std::cerr << "Invalid skiprows argument: " << skiprows << std::endl;
-        return NULL;
+        return false;
     }
     // printf("rank %d skiprows %d nrows %d\n", hpat_dist_get_rank(), skiprows, nrows);
 
-    size_t my_off_start = 0;
-    size_t my_off_end = fsz;
+    my_off_start = 0;
+    my_off_end = fsz;
 
     std::string transport_func_name;
     if (is_parallel)
@@ -315,10 +492,31 @@ static PyObject* csv_chunk_reader(std::istream* f, size_t fsz, bool is_parallel,
         (hpat_mpi_csv_get_offsets)get_py_registered_symbold(transport_func_name.c_str(), "hpat_mpi_csv_get_offsets");
     if (!hpat_mpi_csv_get_offsets_ptr)
     {
-        return NULL;
+        return false;
     }
 
-    hpat_mpi_csv_get_offsets_ptr(f, fsz, is_parallel, skiprows, nrows, my_off_start, my_off_end);
+    hpat_mpi_csv_get_offsets_ptr(f, fname, fsz, is_parallel, skiprows, nrows, CSV_QUOTECHAR, my_off_start, my_off_end);
+    return true;
+}
+
+/**
+ * Split stream into chunks and return a file-like object per rank. The returned object
+ * represents the data to be read on each process.
+ *
+ * @param[in]  f     the input stream
+ * @param[in]  fname name of the file behind f (its chunk is mmapped for line counting), NULL for strings
+ * @param[in]  fsz   total number of bytes in stream
+ * @return     StreamReader file-like object to read the owned chunk through pandas.read_csv
+ **/
+static PyObject* csv_chunk_reader(
+    std::istream* f, const char* fname, size_t fsz, bool is_parallel, int64_t skiprows, int64_t nrows)
+{
+    size_t my_off_start = 0;
+    size_t my_off_end = fsz;
+    if (!csv_chunk_offsets(f, fname, fsz, is_parallel, skiprows, nrows, my_off_start, my_off_end))
+    {
+        return NULL;
+    }
 
     // Here we now know exactly what chunk to read: [my_off_start,my_off_end[
     // let's create our file-like reader
@@ -337,7 +535,7 @@ static PyObject* csv_chunk_reader(std::istream* f, size_t fsz, bool is_parallel,
     }
     else
     {
-        stream_reader_init(reinterpret_cast<stream_reader*>(reader), f, my_off_start, my_off_end - my_off_start);
+        stream_reader_init(reinterpret_cast<stream_reader*>(reader), f, fname, my_off_start, my_off_end - my_off_start);
     }
 
     return reader;
@@ -365,7 +563,7 @@ PyObject* csv_file_chunk_reader(const char* fname, bool is_parallel, int64_t ski
     size_t fsz = boost::filesystem::file_size(fname);
     std::ifstream* f = new std::ifstream(fname, std::ifstream::binary);
     CHECK(f->good() && !f->eof() && f->is_open(), "could not open file.");
-    return csv_chunk_reader(f, fsz, is_parallel, skiprows, nrows);
+    return csv_chunk_reader(f, fname, fsz, is_parallel, skiprows, nrows);
 }
 
 /**
@@ -382,7 +580,348 @@ PyObject* csv_string_chunk_reader(const std::string* str, bool is_parallel)
     // get total file-size
     std::istringstream* f = new std::istringstream(*str);
     CHECK(f->good(), "could not create istrstream from string.");
-    return csv_chunk_reader(f, str->size(), is_parallel, 0, -1);
+    return csv_chunk_reader(f, NULL, str->size(), is_parallel, 0, -1);
+}
+
+// ***********************************************************************************
+// Native parser filling column buffers directly (no pandas, no Python objects)
+// ***********************************************************************************
+
+static void csv_report_errors(const csv_parsed_chunk* chunk)
+{
+    for (size_t field = 0; field < chunk->field_to_col.size(); ++field)
+    {
+        int64_t col_idx = chunk->field_to_col[field];
+        if (col_idx < 0 || chunk->columns[col_idx].n_errors == 0)
+            continue;
+        const csv_column& col = chunk->columns[col_idx];
+        std::cerr << "Error in csv_read: " << col.n_errors << " values of column " << field
+                  << " could not be parsed, first: ";
+        if (col.first_error.empty())
+            std::cerr << "missing value";
+        else
+            std::cerr << "'" << col.first_error << "'";
+        if (col.type == CSV_COL_DATETIME)
+            std::cerr << " (dates have to be ISO 8601)";
+        else if (col.type != CSV_COL_STRING && col.type != HPAT_CTypes::FLOAT32 && col.type != HPAT_CTypes::FLOAT64)
+            std::cerr << " (integer columns can't have missing values, use a float dtype)";
+        std::cerr << std::endl;
+    }
+}
+
+void* csv_file_chunk_parse(const char* fname,
+                           bool is_parallel,
+                           int64_t skiprows,
+                           int64_t nrows,
+                           char sep,
+                           int64_t n_cols,
+                           const int64_t* usecols,
+                           const int32_t* col_types,
+                           int64_t n_threads)
+{
+    CHECK(fname != NULL, "NULL filename provided.");
+    boost::system::error_code size_error;
+    size_t fsz = boost::filesystem::file_size(fname, size_error);
+    CHECK(!size_error, "could not open file " << fname << ": " << size_error.message());
+    std::ifstream f(fname, std::ifstream::binary);
+    CHECK(f.good() && !f.eof() && f.is_open(), "could not open file.");
+
+    size_t my_off_start = 0;
+    size_t my_off_end = fsz;
+    if (!csv_chunk_offsets(&f, fname, fsz, is_parallel, skiprows, nrows, my_off_start, my_off_end))
+    {
+        return NULL;
+    }
+
+    // parse straight from the page cache if possible
+    size_t size = my_off_end - my_off_start;
+    csv_mapped_range mapped(fname, my_off_start, size);
+    const char* data = mapped.data();
+    std::vector<char> buff;
+    if (data == NULL && size > 0)
+    {
+        buff.resize(size);
+        f.clear();
+        f.seekg(my_off_start, std::ios_base::beg);
+        f.read(buff.data(), size);
+        CHECK((size_t)f.gcount() == size, "could not read chunk of " << size << " bytes.");
+        data = buff.data();
+    }
+
+    if (n_threads <= 0)
+    {
+        n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    csv_parsed_chunk* chunk = new csv_parsed_chunk(n_cols, usecols, col_types);
+    csv_parse_range_parallel(data, size, sep, CSV_QUOTECHAR, (int)n_threads, chunk);
+    csv_report_errors(chunk);
+    return chunk;
+}
+
+// a NULL chunk (file not read) reads as empty columns, csv_get_num_errors fails the read
+
+int64_t csv_get_num_rows(void* chunk)
+{
+    return chunk ? ((csv_parsed_chunk*)chunk)->n_rows : 0;
+}
+
+/// number of values that could not be parsed, -1 if the chunk could not be read
+int64_t csv_get_num_errors(void* chunk)
+{
+    if (chunk == NULL || ((csv_parsed_chunk*)chunk)->read_failed)
+    {
+        return -1;
+    }
+    int64_t n_errors = 0;
+    for (const csv_column& col : ((csv_parsed_chunk*)chunk)->columns)
+        n_errors += col.n_errors;
+    return n_errors;
+}
+
+void csv_read_column(void* chunk, int64_t col_idx, void* out)
+{
+    if (chunk)
+    {
+        csv_copy_column((csv_parsed_chunk*)chunk, col_idx, out);
+    }
+}
+
+void csv_read_string_column(
+    void* chunk, int64_t col_idx, uint32_t** out_offsets, uint8_t** out_data, uint8_t** out_nulls)
+{
+    const csv_parsed_chunk* parsed = (csv_parsed_chunk*)chunk;
+    int64_t n_rows = csv_get_num_rows(chunk);
+    int64_t null_size = (n_rows + 7) / 8;
+    int64_t n_chars = parsed ? parsed->columns[col_idx].chars.size() : 0;
+    // ownership goes to the string array, which frees with delete[]
+    *out_offsets = new uint32_t[n_rows + 1];
+    *out_data = new uint8_t[n_chars];
+    *out_nulls = new uint8_t[null_size];
+    if (!parsed)
+    {
+        (*out_offsets)[0] = 0;
+        return;
+    }
+    const csv_column& col = parsed->columns[col_idx];
+    memcpy(*out_offsets, col.offsets.data(), (n_rows + 1) * sizeof(uint32_t));
+    memcpy(*out_data, col.chars.data(), n_chars);
+    memcpy(*out_nulls, col.null_bitmap.data(), null_size);
+}
+
+void csv_del_chunk(void* chunk)
+{
+    delete (csv_parsed_chunk*)chunk;
+}
+
+// ***********************************************************************************
+// Streaming reader parsing a rank's chunk in batches of rows
+// ***********************************************************************************
+
+// bytes read from the file at once by the batch reader
+#define CSV_BATCH_BLOCK_SIZE (1 << 22)
+
+/*
+  The chunk is read block by block, the next block is prefetched by a background
+  thread while the rows of the current one are parsed. Parsed bytes are dropped
+  from the window, so memory is bounded by the block and batch size, not by the
+  size of the chunk. All batches are parsed into the same column buffers.
+*/
+struct csv_batch_reader
+{
+    std::ifstream f;
+    size_t read_pos;              // next byte of the chunk to read
+    size_t read_end;              // end of the chunk
+    std::vector<char> window;     // bytes read from the chunk, starting at a row
+    size_t window_pos;            // bytes of window already parsed
+    size_t window_rows_end;       // end of the complete rows in window
+    std::vector<char> block;      // target of the prefetch
+    std::future<size_t> prefetch; // number of bytes read into block
+    char sep;
+    int64_t batch_rows;
+    csv_parsed_chunk batch;
+
+    csv_batch_reader(const char* fname,
+                     size_t start,
+                     size_t end,
+                     char _sep,
+                     int64_t _batch_rows,
+                     int64_t n_cols,
+                     const int64_t* usecols,
+                     const int32_t* col_types)
+        : f(fname, std::ifstream::binary)
+        , read_pos(start)
+        , read_end(end)
+        , window_pos(0)
+        , window_rows_end(0)
+        , sep(_sep)
+        , batch_rows(_batch_rows)
+        , batch(n_cols, usecols, col_types)
+    {
+        f.seekg(start, std::ios_base::beg);
+        if (read_pos < read_end)
+            start_prefetch();
+    }
+
+    ~csv_batch_reader()
+    {
+        if (prefetch.valid())
+            prefetch.wait();
+    }
+
+    void start_prefetch()
+    {
+        size_t size = std::min((size_t)CSV_BATCH_BLOCK_SIZE, read_end - read_pos);
+        block.resize(size);
+        read_pos += size;
+        prefetch = std::async(std::launch::async, [this, size]() {
+            f.read(block.data(), size);
+            return (size_t)f.gcount();
+        });
+    }
+
+    /// append the prefetched block to the window, returns false at the end of the chunk
+    bool refill()
+    {
+        if (!prefetch.valid())
+            return false;
+        size_t size = prefetch.get();
+        if (size != block.size())
+        {
+            std::cerr << "Error in csv_read: could not read block of " << block.size() << " bytes" << std::endl;
+            batch.read_failed = true;
+            return false;
+        }
+        window.erase(window.begin(), window.begin() + window_pos);
+        window_pos = 0;
+        window.insert(window.end(), block.begin(), block.end());
+
+        // the remaining bytes of the chunk are all complete rows
+        if (read_pos == read_end)
+        {
+            window_rows_end = window.size();
+            return true;
+        }
+        start_prefetch();
+        window_rows_end = csv_last_line_end(window.data(), window.size(), CSV_QUOTECHAR);
+        return true;
+    }
+
+    /// parse the next batch_rows rows (less at the end of the chunk) into batch
+    void read_batch()
+    {
+        batch.clear();
+        while (batch.n_rows < batch_rows)
+        {
+            if (window_pos < window_rows_end)
+            {
+                window_pos += csv_parse_range(window.data() + window_pos,
+                                              window_rows_end - window_pos,
+                                              sep,
+                                              CSV_QUOTECHAR,
+                                              &batch,
+                                              batch_rows);
+                continue;
+            }
+            if (!refill())
+                break;
+        }
+        csv_report_errors(&batch);
+    }
+};
+
+void* csv_file_batch_reader(const char* fname,
+                            bool is_parallel,
+                            int64_t skiprows,
+                            int64_t nrows,
+                            char sep,
+                            int64_t n_cols,
+                            const int64_t* usecols,
+                            const int32_t* col_types,
+                            int64_t batch_rows)
+{
+    CHECK(fname != NULL, "NULL filename provided.");
+    CHECK(batch_rows > 0, "invalid batch size " << batch_rows);
+    boost::system::error_code size_error;
+    size_t fsz = boost::filesystem::file_size(fname, size_error);
+    CHECK(!size_error, "could not open file " << fname << ": " << size_error.message());
+    std::ifstream f(fname, std::ifstream::binary);
+    CHECK(f.good() && !f.eof() && f.is_open(), "could not open file.");
+
+    size_t my_off_start = 0;
+    size_t my_off_end = fsz;
+    if (!csv_chunk_offsets(&f, fname, fsz, is_parallel, skiprows, nrows, my_off_start, my_off_end))
+    {
+        return NULL;
+    }
+    return new csv_batch_reader(fname, my_off_start, my_off_end, sep, batch_rows, n_cols, usecols, col_types);
+}
+
+void* csv_read_batch(void* reader)
+{
+    if (reader == NULL)
+    {
+        return NULL;
+    }
+    csv_batch_reader* batch_reader = (csv_batch_reader*)reader;
+    batch_reader->read_batch();
+    return &batch_reader->batch;
+}
+
+void csv_del_batch_reader(void* reader)
+{
+    delete (csv_batch_reader*)reader;
+}
+
+void* csv_writer_new(int64_t n_rows, int64_t index_start, char sep)
+{
+    csv_writer* writer = new csv_writer();
+    writer->n_rows = n_rows;
+    writer->index_start = index_start;
+    writer->sep = sep;
+    return writer;
+}
+
+void csv_writer_add_column(void* writer, int32_t col_type, const void* data, int32_t dt_reso)
+{
+    csv_write_column col = {col_type, data, dt_reso, NULL, NULL, NULL};
+    ((csv_writer*)writer)->columns.push_back(col);
+}
+
+void csv_writer_add_string_column(void* writer,
+                                  const uint32_t* offsets,
+                                  const char* chars,
+                                  const uint8_t* null_bitmap)
+{
+    csv_write_column col = {CSV_COL_STRING, NULL, 0, offsets, chars, null_bitmap};
+    ((csv_writer*)writer)->columns.push_back(col);
+}
+
+int32_t csv_datetime_column_resolution(const int64_t* data, int64_t n)
+{
+    return csv_datetime_resolution(data, n);
+}
+
+int64_t csv_writer_format(void* writer, const char* header, int64_t header_len, int64_t n_threads)
+{
+    csv_writer* csv_out = (csv_writer*)writer;
+    if (n_threads <= 0)
+    {
+        n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    csv_out->buffer.assign(header, header + header_len);
+    csv_format_rows_parallel(csv_out, CSV_QUOTECHAR, (int)n_threads);
+    return (int64_t)csv_out->buffer.size();
+}
+
+char* csv_writer_data(void* writer)
+{
+    return ((csv_writer*)writer)->buffer.data();
+}
+
+void csv_del_writer(void* writer)
+{
+    delete (csv_writer*)writer;
 }
 
 #undef CHECK
@@ -400,4 +939,20 @@ void PyInit_csv(PyObject* m)
     PyModule_AddObject(m, "StreamReader", (PyObject*)&stream_reader_type);
     PyObject_SetAttrString(m, "csv_file_chunk_reader", PyLong_FromVoidPtr((void*)(&csv_file_chunk_reader)));
     PyObject_SetAttrString(m, "csv_string_chunk_reader", PyLong_FromVoidPtr((void*)(&csv_string_chunk_reader)));
+    PyObject_SetAttrString(m, "csv_file_chunk_parse", PyLong_FromVoidPtr((void*)(&csv_file_chunk_parse)));
+    PyObject_SetAttrString(m, "csv_get_num_rows", PyLong_FromVoidPtr((void*)(&csv_get_num_rows)));
+    PyObject_SetAttrString(m, "csv_get_num_errors", PyLong_FromVoidPtr((void*)(&csv_get_num_errors)));
+    PyObject_SetAttrString(m, "csv_read_column", PyLong_FromVoidPtr((void*)(&csv_read_column)));
+    PyObject_SetAttrString(m, "csv_read_string_column", PyLong_FromVoidPtr((void*)(&csv_read_string_column)));
+    PyObject_SetAttrString(m, "csv_del_chunk", PyLong_FromVoidPtr((void*)(&csv_del_chunk)));
+    PyObject_SetAttrString(m, "csv_file_batch_reader", PyLong_FromVoidPtr((void*)(&csv_file_batch_reader)));
+    PyObject_SetAttrString(m, "csv_read_batch", PyLong_FromVoidPtr((void*)(&csv_read_batch)));
+    PyObject_SetAttrString(m, "csv_del_batch_reader", PyLong_FromVoidPtr((void*)(&csv_del_batch_reader)));
+    PyObject_SetAttrString(m, "csv_writer_new", PyLong_FromVoidPtr((void*)(&csv_writer_new)));
+    PyObject_SetAttrString(m, "csv_writer_add_column", PyLong_FromVoidPtr((void*)(&csv_writer_add_column)));
+    PyObject_SetAttrString(m, "csv_writer_add_string_column", PyLong_FromVoidPtr((void*)(&csv_writer_add_string_column)));
+    PyObject_SetAttrString(m, "csv_datetime_column_resolution", PyLong_FromVoidPtr((void*)(&csv_datetime_column_resolution)));
+    PyObject_SetAttrString(m, "csv_writer_format", PyLong_FromVoidPtr((void*)(&csv_writer_format)));
+    PyObject_SetAttrString(m, "csv_writer_data", PyLong_FromVoidPtr((void*)(&csv_writer_data)));
+    PyObject_SetAttrString(m, "csv_del_writer", PyLong_FromVoidPtr((void*)(&csv_del_writer)));
 }
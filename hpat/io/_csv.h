@@ -2,6 +2,7 @@
 #define _CSV_H_INCLUDED
 
 #include <Python.h>
+#include <cstdint>
 #include <string>
 
 // CSV exports some stuff to the io module
@@ -27,4 +28,97 @@ extern "C" PyObject* csv_file_chunk_reader(const char* fname, bool is_parallel,
  **/
 extern "C" PyObject* csv_string_chunk_reader(const std::string* str, bool is_parallel);
 
+/**
+ * Parse the chunk of lines of a CSV file owned by this rank into column buffers.
+ * Chunks are computed like for csv_file_chunk_reader.
+ *
+ * @param[in]  fname       the input file name
+ * @param[in]  is_parallel if parallel read of different chunks required
+ * @param[in]  sep         field separator
+ * @param[in]  n_cols      number of columns to read
+ * @param[in]  usecols     field index in a row of each column to read
+ * @param[in]  col_types   HPAT_CTypes, CSV_COL_DATETIME or CSV_COL_STRING type of each column
+ * @param[in]  n_threads   number of threads parsing the chunk, <= 0 for all hardware threads
+ * @return     handle of the parsed chunk, to be released with csv_del_chunk
+ **/
+extern "C" void* csv_file_chunk_parse(const char* fname,
+                                      bool is_parallel,
+                                      int64_t skiprows,
+                                      int64_t nrows,
+                                      char sep,
+                                      int64_t n_cols,
+                                      const int64_t* usecols,
+                                      const int32_t* col_types,
+                                      int64_t n_threads);
+
+/// number of rows in a parsed chunk
+extern "C" int64_t csv_get_num_rows(void* chunk);
+
+/// number of values of a parsed chunk which could not be parsed as the type of their column
+extern "C" int64_t csv_get_num_errors(void* chunk);
+
+/// copy numeric/datetime column col_idx of a parsed chunk to out (with csv_get_num_rows elements)
+extern "C" void csv_read_column(void* chunk, int64_t col_idx, void* out);
+
+/// create str_arr_payload buffers of string column col_idx of a parsed chunk
+extern "C" void csv_read_string_column(
+    void* chunk, int64_t col_idx, uint32_t** out_offsets, uint8_t** out_data, uint8_t** out_nulls);
+
+/// release a parsed chunk
+extern "C" void csv_del_chunk(void* chunk);
+
+/**
+ * Open a streaming reader of the chunk of lines of a CSV file owned by this rank,
+ * which parses batch_rows rows at a time. Arguments as for csv_file_chunk_parse.
+ *
+ * @return     handle of the reader, to be released with csv_del_batch_reader
+ **/
+extern "C" void* csv_file_batch_reader(const char* fname,
+                                       bool is_parallel,
+                                       int64_t skiprows,
+                                       int64_t nrows,
+                                       char sep,
+                                       int64_t n_cols,
+                                       const int64_t* usecols,
+                                       const int32_t* col_types,
+                                       int64_t batch_rows);
+
+/// parse the next batch, returns a parsed chunk (owned by the reader, valid until the next call) with 0 rows at the end
+extern "C" void* csv_read_batch(void* reader);
+
+/// release a batch reader
+extern "C" void csv_del_batch_reader(void* reader);
+
+/// create a writer formatting n_rows rows of columns, indexed from index_start, to CSV
+extern "C" void* csv_writer_new(int64_t n_rows, int64_t index_start, char sep);
+
+/// add a numeric (HPAT_CTypes), bool (102) or datetime column to a writer, dt_reso is the precision of datetimes
+extern "C" void csv_writer_add_column(void* writer, int32_t col_type, const void* data, int32_t dt_reso);
+
+/// add a string column in str_arr_payload layout to a writer
+extern "C" void csv_writer_add_string_column(void* writer,
+                                             const uint32_t* offsets,
+                                             const char* chars,
+                                             const uint8_t* null_bitmap);
+
+/// precision of the datetime64[ns] values of a column as chosen by pandas.to_csv, to be reduced across ranks
+extern "C" int32_t csv_datetime_column_resolution(const int64_t* data, int64_t n);
+
+/**
+ * Format header followed by the rows of the columns of a writer into its buffer.
+ *
+ * @param[in]  writer      handle of the writer
+ * @param[in]  header      header line (including its newline), only given on the first rank
+ * @param[in]  header_len  number of bytes of header
+ * @param[in]  n_threads   number of threads formatting the rows, <= 0 for all hardware threads
+ * @return     number of bytes of the buffer
+ **/
+extern "C" int64_t csv_writer_format(void* writer, const char* header, int64_t header_len, int64_t n_threads);
+
+/// buffer with the formatted rows of a writer
+extern "C" char* csv_writer_data(void* writer);
+
+/// release a writer
+extern "C" void csv_del_writer(void* writer);
+
 #endif // _CSV_H_INCLUDED
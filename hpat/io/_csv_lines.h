@@ -0,0 +1,373 @@
+#ifndef _CSV_LINES_H_INCLUDED
+#define _CSV_LINES_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <istream>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HPAT_CSV_LINES_X86
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+  Newline search used to find line boundaries of CSV data before the
+  byte range of each rank is turned into a range of lines.
+
+  The scan runs over a contiguous buffer, either an mmap of the rank's
+  byte range or blocks read from the input stream. On x86 the AVX2 or
+  SSE2 kernel is picked at runtime, everything else goes through memchr.
+
+  Quoted fields may contain newlines, so with a quote character the scan
+  is speculative: a rank does not know whether its byte range starts
+  inside a quoted field. Every newline is recorded under the parity of
+  the quotes seen before it in the range, which gives the line ends for
+  both possible starting states in a single pass. Once the quote parity
+  of all previous ranks is known (exscan) the matching set is used.
+  Quotes are toggles as in RFC 4180, escaped quotes ("") cancel out.
+*/
+
+// block size used when the input can only be read through a stream
+#define CSV_LINES_BLOCK_SIZE (1 << 20)
+
+/// append offsets (relative to buff + base) of newlines in buff[0, n) to pos, stop after max_lines in total
+static inline void
+    scan_newlines_scalar(const char* buff, size_t n, size_t base, std::vector<size_t>& pos, size_t max_lines)
+{
+    const char* curr = buff;
+    const char* end = buff + n;
+    while (curr < end && pos.size() < max_lines)
+    {
+        const char* nl = (const char*)memchr(curr, '\n', end - curr);
+        if (nl == NULL)
+            break;
+        pos.push_back(base + (nl - buff));
+        curr = nl + 1;
+    }
+}
+
+#ifdef HPAT_CSV_LINES_X86
+
+__attribute__((target("avx2"))) static void
+    scan_newlines_avx2(const char* buff, size_t n, size_t base, std::vector<size_t>& pos, size_t max_lines)
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= n && pos.size() < max_lines; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(buff + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, nl));
+        while (mask != 0 && pos.size() < max_lines)
+        {
+            pos.push_back(base + i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    if (pos.size() < max_lines)
+        scan_newlines_scalar(buff + i, n - i, base + i, pos, max_lines);
+}
+
+__attribute__((target("sse2"))) static void
+    scan_newlines_sse2(const char* buff, size_t n, size_t base, std::vector<size_t>& pos, size_t max_lines)
+{
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= n && pos.size() < max_lines; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(buff + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, nl));
+        while (mask != 0 && pos.size() < max_lines)
+        {
+            pos.push_back(base + i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    if (pos.size() < max_lines)
+        scan_newlines_scalar(buff + i, n - i, base + i, pos, max_lines);
+}
+
+#endif // HPAT_CSV_LINES_X86
+
+/// append offsets of newlines in buff[0, n) to pos[p], p being the parity of quotes seen before the newline
+static inline void scan_newlines_quoted_scalar(
+    const char* buff, size_t n, size_t base, char quotechar, std::vector<size_t>* pos, int& parity)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (buff[i] == quotechar)
+            parity ^= 1;
+        else if (buff[i] == '\n')
+            pos[parity].push_back(base + i);
+    }
+}
+
+#ifdef HPAT_CSV_LINES_X86
+
+/// walk the set bits of a block's newline/quote masks in order
+static inline void
+    consume_quoted_masks(uint32_t nl_mask, uint32_t q_mask, size_t base, std::vector<size_t>* pos, int& parity)
+{
+    // common case: no quotes in block, all newlines belong to the current state
+    if (q_mask == 0)
+    {
+        while (nl_mask != 0)
+        {
+            pos[parity].push_back(base + __builtin_ctz(nl_mask));
+            nl_mask &= nl_mask - 1;
+        }
+        return;
+    }
+    uint32_t mask = nl_mask | q_mask;
+    while (mask != 0)
+    {
+        uint32_t bit = mask & (~mask + 1);
+        if (q_mask & bit)
+            parity ^= 1;
+        else
+            pos[parity].push_back(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+}
+
+__attribute__((target("avx2"))) static void scan_newlines_quoted_avx2(
+    const char* buff, size_t n, size_t base, char quotechar, std::vector<size_t>* pos, int& parity)
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i q = _mm256_set1_epi8(quotechar);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(buff + i));
+        uint32_t nl_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, nl));
+        uint32_t q_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, q));
+        consume_quoted_masks(nl_mask, q_mask, base + i, pos, parity);
+    }
+    scan_newlines_quoted_scalar(buff + i, n - i, base + i, quotechar, pos, parity);
+}
+
+__attribute__((target("sse2"))) static void scan_newlines_quoted_sse2(
+    const char* buff, size_t n, size_t base, char quotechar, std::vector<size_t>* pos, int& parity)
+{
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i q = _mm_set1_epi8(quotechar);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(buff + i));
+        uint32_t nl_mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, nl));
+        uint32_t q_mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, q));
+        consume_quoted_masks(nl_mask, q_mask, base + i, pos, parity);
+    }
+    scan_newlines_quoted_scalar(buff + i, n - i, base + i, quotechar, pos, parity);
+}
+
+#endif // HPAT_CSV_LINES_X86
+
+/// append offsets of newlines in buff[0, n) to pos using the widest vector unit available
+static inline void scan_newlines(const char* buff, size_t n, size_t base, std::vector<size_t>& pos, size_t max_lines)
+{
+#ifdef HPAT_CSV_LINES_X86
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    static const bool has_sse2 = __builtin_cpu_supports("sse2");
+    if (has_avx2)
+        return scan_newlines_avx2(buff, n, base, pos, max_lines);
+    if (has_sse2)
+        return scan_newlines_sse2(buff, n, base, pos, max_lines);
+#endif
+    scan_newlines_scalar(buff, n, base, pos, max_lines);
+}
+
+/// quote-aware version of scan_newlines, see scan_newlines_quoted_scalar
+static inline void scan_newlines_quoted(
+    const char* buff, size_t n, size_t base, char quotechar, std::vector<size_t>* pos, int& parity)
+{
+#ifdef HPAT_CSV_LINES_X86
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    static const bool has_sse2 = __builtin_cpu_supports("sse2");
+    if (has_avx2)
+        return scan_newlines_quoted_avx2(buff, n, base, quotechar, pos, parity);
+    if (has_sse2)
+        return scan_newlines_quoted_sse2(buff, n, base, quotechar, pos, parity);
+#endif
+    scan_newlines_quoted_scalar(buff, n, base, quotechar, pos, parity);
+}
+
+/**
+ * Read-only mapping of the byte range [offset, offset+size) of a file.
+ * data() is NULL if the file could not be mapped (or on Windows), callers
+ * are expected to fall back to reading the range through a stream.
+ **/
+struct csv_mapped_range
+{
+    csv_mapped_range(const char* fname, size_t offset, size_t size)
+        : map_addr(NULL)
+        , map_len(0)
+        , begin(NULL)
+        , len(size)
+    {
+#ifndef _WIN32
+        if (fname == NULL || size == 0)
+            return;
+        int fd = open(fname, O_RDONLY);
+        if (fd == -1)
+            return;
+        // mmap offset needs to be a multiple of page size
+        size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+        size_t map_offset = offset - offset % page_size;
+        map_len = size + (offset - map_offset);
+        void* addr = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, (off_t)map_offset);
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            map_len = 0;
+            return;
+        }
+        // lines are scanned front to back exactly once
+        madvise(addr, map_len, MADV_SEQUENTIAL);
+        map_addr = addr;
+        begin = (const char*)addr + (offset - map_offset);
+#endif
+    }
+
+    ~csv_mapped_range()
+    {
+#ifndef _WIN32
+        if (map_addr != NULL)
+            munmap(map_addr, map_len);
+#endif
+    }
+
+    const char* data() const { return begin; }
+    size_t size() const { return len; }
+
+private:
+    csv_mapped_range(const csv_mapped_range&);
+    csv_mapped_range& operator=(const csv_mapped_range&);
+
+    void* map_addr;
+    size_t map_len;
+    const char* begin;
+    size_t len;
+};
+
+/**
+ * Call scan(buff, size, base) on consecutive pieces of the n bytes starting at
+ * byte_offset, base being the offset of buff relative to byte_offset. Stops
+ * early if scan returns false.
+ *
+ * If fname is given the range is mmapped, otherwise (or if mapping fails) it is
+ * read in blocks from f, which has to be positioned at byte_offset already.
+ **/
+template <typename F>
+static void csv_scan_range(std::istream* f, const char* fname, size_t byte_offset, size_t n, F scan)
+{
+    csv_mapped_range range(fname, byte_offset, n);
+    if (range.data() != NULL)
+    {
+        // in pieces of a block too, so that the scan can stop early
+        for (size_t i = 0; i < n; i += CSV_LINES_BLOCK_SIZE)
+        {
+            if (!scan(range.data() + i, std::min(n - i, (size_t)CSV_LINES_BLOCK_SIZE), i))
+                break;
+        }
+        return;
+    }
+
+    std::vector<char> buff(std::min(n, (size_t)CSV_LINES_BLOCK_SIZE));
+    size_t i = 0;
+    bool more = true;
+    while (i < n && more)
+    {
+        size_t block_size = std::min(n - i, buff.size());
+        f->read(buff.data(), block_size);
+        size_t n_read = (size_t)f->gcount();
+        more = scan(buff.data(), n_read, i);
+        i += n_read;
+        if (n_read < block_size)
+            break;
+    }
+
+    if (i < n && more)
+        std::cerr << "Warning, read only " << i << " bytes out of " << n << "requested\n";
+}
+
+/**
+ * Return offsets of the newlines in the n bytes starting at byte_offset.
+ * Offsets are relative to byte_offset and counting stops after max_lines newlines.
+ *
+ * @param[in]  f           the input stream, positioned at byte_offset
+ * @param[in]  fname       name of the file behind f (range is mmapped), NULL if there is none
+ * @param[in]  byte_offset start of the range in the input
+ * @param[in]  n           number of bytes to scan
+ * @param[in]  max_lines   stop after this many newlines have been found
+ * @return     vector of newline offsets relative to byte_offset
+ **/
+static inline std::vector<size_t>
+    csv_count_lines(std::istream* f, const char* fname, size_t byte_offset, size_t n, size_t max_lines = SIZE_MAX)
+{
+    std::vector<size_t> pos;
+    csv_scan_range(f, fname, byte_offset, n, [&](const char* buff, size_t size, size_t base) {
+        scan_newlines(buff, size, base, pos, max_lines);
+        return pos.size() < max_lines;
+    });
+    return pos;
+}
+
+/**
+ * Speculative quote-aware line counting of the n bytes starting at byte_offset.
+ *
+ * pos[0] receives the line ends assuming the range starts outside a quoted field,
+ * pos[1] the line ends assuming it starts inside one. Without quotechar ('\0')
+ * every newline ends a line and only pos[0] is filled.
+ *
+ * Counting stops once both sets have max_lines entries; the returned parity is
+ * then partial, which is fine since no later line is needed. A range starting
+ * the input (byte_offset 0) is outside quotes, so counting stops as soon as
+ * pos[0] is full, e.g. right after the first lines of an unquoted file.
+ *
+ * @param[in]  f           the input stream, positioned at byte_offset
+ * @param[in]  fname       name of the file behind f (range is mmapped), NULL if there is none
+ * @param[in]  byte_offset start of the range in the input
+ * @param[in]  n           number of bytes to scan
+ * @param[in]  max_lines   stop after this many newlines have been found for both states
+ * @param[in]  quotechar   quote character, '\0' to disable quote handling
+ * @param[out] pos         the two sets of newline offsets relative to byte_offset
+ * @return     parity of the number of quote characters in the range
+ **/
+static inline int csv_count_lines_quoted(std::istream* f,
+                                         const char* fname,
+                                         size_t byte_offset,
+                                         size_t n,
+                                         size_t max_lines,
+                                         char quotechar,
+                                         std::vector<size_t>* pos)
+{
+    if (quotechar == '\0')
+    {
+        pos[0] = csv_count_lines(f, fname, byte_offset, n, max_lines);
+        return 0;
+    }
+
+    int parity = 0;
+    csv_scan_range(f, fname, byte_offset, n, [&](const char* buff, size_t size, size_t base) {
+        scan_newlines_quoted(buff, size, base, quotechar, pos, parity);
+        return pos[0].size() < max_lines || (byte_offset != 0 && pos[1].size() < max_lines);
+    });
+    // one piece may overshoot max_lines
+    for (int i = 0; i < 2; i++)
+        if (pos[i].size() > max_lines)
+            pos[i].resize(max_lines);
+    return parity;
+}
+
+#endif // _CSV_LINES_H_INCLUDED
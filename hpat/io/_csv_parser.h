@@ -0,0 +1,556 @@
+#ifndef _CSV_PARSER_H_INCLUDED
+#define _CSV_PARSER_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../_datetime_ext.h"
+#include "../_hpat_common.h"
+
+/*
+  Native CSV tokenizer/parser.
+
+  Parses a byte range of CSV data (one rank's chunk of lines) straight into
+  per-column buffers without creating any Python objects. Numeric columns are
+  parsed into int64/float64 buffers and converted to the requested numpy dtype
+  when copied out, datetime columns are parsed as ISO 8601 into datetime64[ns]
+  and string columns are built in the str_arr_payload layout (uint32 offsets,
+  characters, null bitmap with a set bit for valid entries).
+
+  Semantics follow pandas.read_csv with header=None as used by HPAT: blank
+  lines are skipped, fields may be quoted with doubled quotes as escapes, and
+  the default pandas NA values result in NaN/NaT/null. Values which can't be
+  parsed as the column type (including missing values of integer columns,
+  integers out of the int64 range and non ISO 8601 dates) are counted as
+  errors of the column, which fail the read.
+
+  A range can be parsed by several threads: it is cut into line-aligned
+  sub-chunks (quote-aware, like the split across ranks) which are handed
+  out dynamically to the threads and their columns are concatenated in
+  order afterwards.
+*/
+
+// sub-chunks per thread, more than one lets idle threads pick up work of slow ones
+#define CSV_PARSE_TASKS_PER_THREAD 4
+// minimum size of sub-chunks in bytes
+#define CSV_PARSE_MIN_TASK_SIZE (1 << 20)
+
+// column types of the native parser besides numeric HPAT_CTypes, keep in sync with csv_ext.py
+#define CSV_COL_DATETIME 100
+#define CSV_COL_STRING 101
+
+struct csv_column
+{
+    int type;                         // HPAT_CTypes value, CSV_COL_DATETIME or CSV_COL_STRING
+    std::vector<int64_t> ints;        // integer and datetime64[ns] values
+    std::vector<double> floats;       // floating point values
+    std::vector<uint32_t> offsets;    // string offsets
+    std::vector<char> chars;          // string characters
+    std::vector<uint8_t> null_bitmap; // string null bitmap
+    int64_t n_errors;                 // number of fields which could not be parsed
+    std::string first_error;          // first of these fields, empty if missing
+};
+
+struct csv_parsed_chunk
+{
+    int64_t n_rows;
+    std::vector<csv_column> columns;
+    std::vector<int64_t> field_to_col; // output column of every field index of a row, -1 if not used
+    bool read_failed;                  // the input couldn't be read completely, kept by clear()
+
+    csv_parsed_chunk(int64_t n_cols, const int64_t* usecols, const int32_t* col_types)
+        : n_rows(0)
+        , columns(n_cols)
+        , read_failed(false)
+    {
+        for (int64_t i = 0; i < n_cols; ++i)
+        {
+            columns[i].type = col_types[i];
+            columns[i].n_errors = 0;
+            if (col_types[i] == CSV_COL_STRING)
+                columns[i].offsets.push_back(0);
+            if ((size_t)usecols[i] >= field_to_col.size())
+                field_to_col.resize(usecols[i] + 1, -1);
+            field_to_col[usecols[i]] = i;
+        }
+    }
+
+    /// remove all rows, keeps the allocated buffers for reuse
+    void clear()
+    {
+        n_rows = 0;
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            csv_column& col = columns[i];
+            col.ints.clear();
+            col.floats.clear();
+            col.chars.clear();
+            col.null_bitmap.clear();
+            col.n_errors = 0;
+            col.first_error.clear();
+            if (col.type == CSV_COL_STRING)
+                col.offsets.resize(1);
+        }
+    }
+};
+
+/// check if a field is one of the default NA values of pandas.read_csv
+static inline bool csv_is_na(const char* s, size_t len)
+{
+    static const char* na_values[] = {"NA",
+                                      "N/A",
+                                      "n/a",
+                                      "NaN",
+                                      "nan",
+                                      "-NaN",
+                                      "-nan",
+                                      "NULL",
+                                      "null",
+                                      "#N/A",
+                                      "#NA",
+                                      "#N/A N/A",
+                                      "1.#IND",
+                                      "-1.#IND",
+                                      "1.#QNAN",
+                                      "-1.#QNAN",
+                                      "<NA>"};
+    if (len == 0)
+        return true;
+    // all NA values are short and start with one of these characters
+    if (len > 8 || (s[0] != 'N' && s[0] != 'n' && s[0] != '#' && s[0] != '-' && s[0] != '1' && s[0] != '<'))
+        return false;
+    for (size_t i = 0; i < sizeof(na_values) / sizeof(na_values[0]); ++i)
+    {
+        if (strlen(na_values[i]) == len && memcmp(na_values[i], s, len) == 0)
+            return true;
+    }
+    return false;
+}
+
+/// parse an optionally signed decimal integer surrounded by optional spaces, false if it's out of
+/// the range of int64 (or of uint64 if is_unsigned, out has the bits of the value then)
+static inline bool csv_parse_int64(const char* s, size_t len, bool is_unsigned, int64_t& out)
+{
+    const char* end = s + len;
+    while (s < end && *s == ' ')
+        ++s;
+    while (end > s && end[-1] == ' ')
+        --end;
+    bool neg = false;
+    if (s < end && (*s == '-' || *s == '+'))
+    {
+        neg = *s == '-';
+        ++s;
+    }
+    if (s == end)
+        return false;
+    // magnitude of INT64_MIN is one more than INT64_MAX
+    uint64_t max_val = neg ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if (is_unsigned)
+        max_val = neg ? 0 : UINT64_MAX;
+    uint64_t val = 0;
+    for (; s < end; ++s)
+    {
+        unsigned digit = (unsigned)(*s - '0');
+        if (digit > 9 || digit > max_val || val > (max_val - digit) / 10)
+            return false;
+        val = val * 10 + digit;
+    }
+    out = neg ? (int64_t)(0 - val) : (int64_t)val;
+    return true;
+}
+
+/// check if integer val fits in integer type col_type
+static inline bool csv_int_in_range(int col_type, int64_t val)
+{
+    switch (col_type)
+    {
+    case HPAT_CTypes::INT8: return val >= INT8_MIN && val <= INT8_MAX;
+    case HPAT_CTypes::UINT8: return val >= 0 && val <= UINT8_MAX;
+    case HPAT_CTypes::INT16: return val >= INT16_MIN && val <= INT16_MAX;
+    case HPAT_CTypes::UINT16: return val >= 0 && val <= UINT16_MAX;
+    case HPAT_CTypes::INT32: return val >= INT32_MIN && val <= INT32_MAX;
+    case HPAT_CTypes::UINT32: return val >= 0 && val <= UINT32_MAX;
+    default: return true;
+    }
+}
+
+static inline bool csv_parse_float64(const char* s, size_t len, double& out)
+{
+    // strtod needs a null terminated string, fields are short
+    char small_buf[64];
+    std::string large_buf;
+    char* str = small_buf;
+    if (len >= sizeof(small_buf))
+    {
+        large_buf.assign(s, len);
+        str = &large_buf[0];
+    }
+    else
+    {
+        memcpy(small_buf, s, len);
+        small_buf[len] = '\0';
+    }
+    char* end = NULL;
+    out = strtod(str, &end);
+    while (*end == ' ')
+        ++end;
+    return end != str && *end == '\0';
+}
+
+static inline bool csv_parse_datetime64(const char* s, size_t len, int64_t& out)
+{
+    // the parser prints the string on errors and expects it to be null terminated
+    char str[64];
+    if (len >= sizeof(str))
+        return false;
+    memcpy(str, s, len);
+    str[len] = '\0';
+    pandas_datetimestruct dts;
+    int out_local = 0;
+    int out_tzoffset = 0;
+    npy_datetime dt = 0;
+    if (parse_iso_8601_datetime(str, (int)len, &dts, &out_local, &out_tzoffset) != 0)
+        return false;
+    if (convert_datetimestruct_to_datetime(PANDAS_FR_ns, &dts, &dt) != 0)
+        return false;
+    out = dt;
+    return true;
+}
+
+/// count field s[0, len) of column col as not parsable
+static inline void csv_add_error(csv_column& col, const char* s, size_t len)
+{
+    if (col.n_errors++ == 0)
+        col.first_error.assign(s, std::min(len, (size_t)64));
+}
+
+/// append field s[0, len) of the current row to column col, na marks missing fields
+static inline void csv_append_value(csv_column& col, int64_t row, const char* s, size_t len, bool na)
+{
+    switch (col.type)
+    {
+    case CSV_COL_STRING:
+    {
+        if (col.null_bitmap.size() * 8 <= (size_t)row)
+            col.null_bitmap.push_back(0);
+        if (!na)
+        {
+            col.chars.insert(col.chars.end(), s, s + len);
+            col.null_bitmap[row / 8] |= (uint8_t)(1 << (row % 8));
+        }
+        col.offsets.push_back((uint32_t)col.chars.size());
+        return;
+    }
+    case CSV_COL_DATETIME:
+    {
+        int64_t val = INT64_MIN; // NaT
+        if (!na && !csv_parse_datetime64(s, len, val))
+        {
+            csv_add_error(col, s, len);
+            val = INT64_MIN;
+        }
+        col.ints.push_back(val);
+        return;
+    }
+    case HPAT_CTypes::FLOAT32:
+    case HPAT_CTypes::FLOAT64:
+    {
+        double val = std::nan("");
+        if (!na && !csv_parse_float64(s, len, val))
+        {
+            csv_add_error(col, s, len);
+            val = std::nan("");
+        }
+        col.floats.push_back(val);
+        return;
+    }
+    default:
+    {
+        // integer columns can't represent missing values
+        int64_t val = 0;
+        if (na || !csv_parse_int64(s, len, col.type == HPAT_CTypes::UINT64, val) || !csv_int_in_range(col.type, val))
+        {
+            csv_add_error(col, s, len);
+            val = 0;
+        }
+        col.ints.push_back(val);
+        return;
+    }
+    }
+}
+
+/**
+ * Parse all rows of buff[0, n) into the columns of chunk.
+ *
+ * @param[in]  buff      CSV data starting at a line boundary
+ * @param[in]  n         number of bytes in buff
+ * @param[in]  sep       field separator
+ * @param[in]  quotechar quote character of fields
+ * @param[out] chunk     parsed rows are appended to its columns
+ * @param[in]  max_rows  stop once chunk has this many rows
+ * @return     number of bytes consumed
+ **/
+static inline size_t csv_parse_range(
+    const char* buff, size_t n, char sep, char quotechar, csv_parsed_chunk* chunk, int64_t max_rows = INT64_MAX)
+{
+    const int64_t n_fields = chunk->field_to_col.size();
+    std::string unescaped; // quoted fields with escaped quotes
+    size_t pos = 0;
+    while (pos < n && chunk->n_rows < max_rows)
+    {
+        // skip blank lines like pandas
+        if (buff[pos] == '\n' || buff[pos] == '\r')
+        {
+            ++pos;
+            continue;
+        }
+        int64_t field = 0;
+        bool row_end = false;
+        while (!row_end)
+        {
+            const char* val = buff + pos;
+            size_t len = 0;
+            bool quoted = pos < n && buff[pos] == quotechar;
+            if (quoted)
+            {
+                size_t start = ++pos;
+                bool escaped = false;
+                while (pos < n)
+                {
+                    if (buff[pos] == quotechar)
+                    {
+                        if (pos + 1 < n && buff[pos + 1] == quotechar)
+                        {
+                            escaped = true;
+                            pos += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    ++pos;
+                }
+                val = buff + start;
+                len = pos - start;
+                if (escaped)
+                {
+                    unescaped.clear();
+                    for (size_t i = start; i < pos; ++i)
+                    {
+                        unescaped.push_back(buff[i]);
+                        if (buff[i] == quotechar)
+                            ++i;
+                    }
+                    val = unescaped.data();
+                    len = unescaped.size();
+                }
+                // closing quote, anything up to the next separator is ignored
+                while (pos < n && buff[pos] != sep && buff[pos] != '\n' && buff[pos] != '\r')
+                    ++pos;
+            }
+            else
+            {
+                while (pos < n && buff[pos] != sep && buff[pos] != '\n' && buff[pos] != '\r')
+                    ++pos;
+                len = (buff + pos) - val;
+            }
+
+            if (field < n_fields && chunk->field_to_col[field] >= 0)
+            {
+                csv_column& col = chunk->columns[chunk->field_to_col[field]];
+                csv_append_value(col, chunk->n_rows, val, len, csv_is_na(val, len));
+            }
+            ++field;
+
+            if (pos < n && buff[pos] == sep)
+            {
+                ++pos;
+            }
+            else
+            {
+                row_end = true;
+                if (pos < n && buff[pos] == '\r')
+                    ++pos;
+                if (pos < n && buff[pos] == '\n')
+                    ++pos;
+            }
+        }
+        // short rows are filled with missing values
+        for (; field < n_fields; ++field)
+        {
+            if (chunk->field_to_col[field] >= 0)
+                csv_append_value(chunk->columns[chunk->field_to_col[field]], chunk->n_rows, NULL, 0, true);
+        }
+        chunk->n_rows++;
+    }
+    return pos;
+}
+
+/// offset after the last newline outside of quotes in buff[0, n) which starts outside of quotes, 0 if none
+static inline size_t csv_last_line_end(const char* buff, size_t n, char quotechar)
+{
+    size_t line_end = 0;
+    int parity = 0;
+    for (const char* curr = buff; curr < buff + n; ++curr)
+    {
+        if (*curr == quotechar)
+            parity ^= 1;
+        else if (*curr == '\n' && parity == 0)
+            line_end = curr + 1 - buff;
+    }
+    return line_end;
+}
+
+/// run func(0) ... func(n_tasks - 1) on n_threads threads (including the calling one), tasks are taken in order
+template <typename F>
+static void csv_parallel_for(int64_t n_tasks, int n_threads, F func)
+{
+    std::atomic<int64_t> next_task(0);
+    auto worker = [&]() {
+        for (int64_t i = next_task++; i < n_tasks; i = next_task++)
+            func(i);
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < n_threads; ++i)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+}
+
+/// append the rows of part to chunk
+static inline void csv_append_chunk(csv_parsed_chunk* chunk, const csv_parsed_chunk& part)
+{
+    const int64_t n_rows = chunk->n_rows;
+    for (size_t i = 0; i < chunk->columns.size(); ++i)
+    {
+        csv_column& dst = chunk->columns[i];
+        const csv_column& src = part.columns[i];
+        if (dst.n_errors == 0)
+            dst.first_error = src.first_error;
+        dst.n_errors += src.n_errors;
+        dst.ints.insert(dst.ints.end(), src.ints.begin(), src.ints.end());
+        dst.floats.insert(dst.floats.end(), src.floats.begin(), src.floats.end());
+        if (dst.type != CSV_COL_STRING)
+            continue;
+
+        uint32_t char_base = (uint32_t)dst.chars.size();
+        dst.chars.insert(dst.chars.end(), src.chars.begin(), src.chars.end());
+        for (size_t j = 1; j < src.offsets.size(); ++j)
+            dst.offsets.push_back(char_base + src.offsets[j]);
+
+        // null bits of part start at bit n_rows
+        dst.null_bitmap.resize((n_rows + part.n_rows + 7) / 8, 0);
+        if (n_rows % 8 == 0)
+        {
+            std::copy(src.null_bitmap.begin(), src.null_bitmap.end(), dst.null_bitmap.begin() + n_rows / 8);
+            continue;
+        }
+        for (int64_t j = 0; j < part.n_rows; ++j)
+        {
+            if (src.null_bitmap[j / 8] & (1 << (j % 8)))
+                dst.null_bitmap[(n_rows + j) / 8] |= (uint8_t)(1 << ((n_rows + j) % 8));
+        }
+    }
+    chunk->n_rows += part.n_rows;
+}
+
+/// offset of the first byte after a newline outside of quotes at or after start, given the quote parity at start
+static inline size_t csv_next_line_start(const char* buff, size_t n, size_t start, char quotechar, int parity)
+{
+    for (size_t i = start; i < n; ++i)
+    {
+        if (buff[i] == quotechar)
+            parity ^= 1;
+        else if (buff[i] == '\n' && parity == 0)
+            return i + 1;
+    }
+    return n;
+}
+
+/**
+ * Parse all rows of buff[0, n) into the columns of chunk using n_threads threads.
+ * Same as csv_parse_range, chunk has to be empty.
+ **/
+static inline void
+    csv_parse_range_parallel(const char* buff, size_t n, char sep, char quotechar, int n_threads, csv_parsed_chunk* chunk)
+{
+    int64_t n_tasks = std::min((int64_t)n_threads * CSV_PARSE_TASKS_PER_THREAD, (int64_t)(n / CSV_PARSE_MIN_TASK_SIZE));
+    if (n_threads <= 1 || n_tasks <= 1)
+    {
+        csv_parse_range(buff, n, sep, quotechar, chunk);
+        return;
+    }
+
+    // quote parity of each equal sized piece, in parallel
+    size_t piece_size = n / n_tasks;
+    std::vector<int> piece_parity(n_tasks, 0);
+    csv_parallel_for(n_tasks, n_threads, [&](int64_t i) {
+        const char* begin = buff + i * piece_size;
+        const char* end = i == n_tasks - 1 ? buff + n : begin + piece_size;
+        piece_parity[i] = std::count(begin, end, quotechar) & 1;
+    });
+
+    // move the start of every piece to the next line start outside of quotes
+    std::vector<size_t> task_start(n_tasks + 1, n);
+    task_start[0] = 0;
+    int parity = 0;
+    for (int64_t i = 1; i < n_tasks; ++i)
+    {
+        parity ^= piece_parity[i - 1];
+        // the line of the previous task may extend past this piece, which leaves that task empty
+        if (task_start[i - 1] >= i * piece_size)
+        {
+            task_start[i] = task_start[i - 1];
+            continue;
+        }
+        task_start[i] = csv_next_line_start(buff, n, i * piece_size, quotechar, parity);
+    }
+
+    std::vector<csv_parsed_chunk> parts(n_tasks, *chunk);
+    csv_parallel_for(n_tasks, n_threads, [&](int64_t i) {
+        csv_parse_range(buff + task_start[i], task_start[i + 1] - task_start[i], sep, quotechar, &parts[i]);
+    });
+
+    for (int64_t i = 0; i < n_tasks; ++i)
+        csv_append_chunk(chunk, parts[i]);
+}
+
+template <typename T, typename S>
+static inline void csv_copy_values(const S* vals, int64_t n, void* out)
+{
+    for (int64_t i = 0; i < n; ++i)
+        ((T*)out)[i] = (T)vals[i];
+}
+
+/// copy numeric or datetime column col_idx of chunk to out, converting to the column's dtype
+static inline void csv_copy_column(const csv_parsed_chunk* chunk, int64_t col_idx, void* out)
+{
+    const csv_column& col = chunk->columns[col_idx];
+    const int64_t n = chunk->n_rows;
+    switch (col.type)
+    {
+    case HPAT_CTypes::INT8: csv_copy_values<int8_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::UINT8: csv_copy_values<uint8_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::INT16: csv_copy_values<int16_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::UINT16: csv_copy_values<uint16_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::INT32: csv_copy_values<int32_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::UINT32: csv_copy_values<uint32_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::INT64:
+    case HPAT_CTypes::UINT64:
+    case CSV_COL_DATETIME: csv_copy_values<int64_t>(col.ints.data(), n, out); return;
+    case HPAT_CTypes::FLOAT32: csv_copy_values<float>(col.floats.data(), n, out); return;
+    case HPAT_CTypes::FLOAT64: csv_copy_values<double>(col.floats.data(), n, out); return;
+    default: std::cerr << "Error in csv_read: invalid column type " << col.type << std::endl;
+    }
+}
+
+#endif // _CSV_PARSER_H_INCLUDED
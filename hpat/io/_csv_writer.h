@@ -0,0 +1,346 @@
+#ifndef _CSV_WRITER_H_INCLUDED
+#define _CSV_WRITER_H_INCLUDED
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../_hpat_common.h"
+#include "_csv_parser.h"
+
+/*
+  Native CSV formatter.
+
+  Renders the rows of one rank's columns into a byte buffer the way
+  DataFrame.to_csv() does with default arguments: an integer index column,
+  floats in their shortest round-trip repr, NaN/NaT/null as empty fields,
+  datetime64 in ISO format with a precision common to the whole column, and
+  strings quoted only when they contain the separator, a quote or a newline.
+
+  Rows can be formatted by several threads, each formatting a contiguous
+  range of rows into its own buffer which are concatenated in order.
+*/
+
+// bool column type of the writer, numba bool arrays map to HPAT_CTypes::UINT8 otherwise
+#define CSV_COL_BOOL 102
+
+// minimum number of rows formatted by a thread
+#define CSV_FORMAT_MIN_TASK_ROWS (1 << 14)
+
+// datetime precision of a column, as chosen by pandas for all its values
+#define CSV_DT_RESO_DATE 0
+#define CSV_DT_RESO_S 1
+#define CSV_DT_RESO_MS 2
+#define CSV_DT_RESO_US 3
+#define CSV_DT_RESO_NS 4
+
+struct csv_write_column
+{
+    int type;                   // HPAT_CTypes value, CSV_COL_DATETIME, CSV_COL_STRING or CSV_COL_BOOL
+    const void* data;           // values of non-string columns
+    int dt_reso;                // CSV_DT_RESO_* of datetime columns
+    const uint32_t* offsets;    // string offsets
+    const char* chars;          // string characters
+    const uint8_t* null_bitmap; // string null bitmap, NULL if there are no nulls
+};
+
+struct csv_writer
+{
+    int64_t n_rows;
+    int64_t index_start; // global index of the first row
+    char sep;
+    std::vector<csv_write_column> columns;
+    std::vector<char> buffer; // formatted header and rows
+};
+
+/// write the decimal digits of v to out, returns the number of characters
+static inline int csv_format_uint64(uint64_t v, char* out)
+{
+    char tmp[20];
+    int n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    for (int i = 0; i < n; ++i)
+        out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+static inline int csv_format_int64(int64_t v, char* out)
+{
+    if (v >= 0)
+        return csv_format_uint64((uint64_t)v, out);
+    out[0] = '-';
+    return 1 + csv_format_uint64(~(uint64_t)v + 1, out + 1);
+}
+
+/**
+ * Write the shortest representation of v which reads back as the same value, laid
+ * out like numpy's conversion of floats to strings used by pandas: positional with
+ * at least one fractional digit for magnitudes in [1e-4, 1e16) ([1e-4, 1e6) for
+ * float32), scientific otherwise. NaN is written as an empty field.
+ *
+ * @param[in]  v       value
+ * @param[in]  single  v is a float32 value, which needs at most 9 digits
+ * @param[out] out     at least 32 characters
+ * @return     number of characters written
+ **/
+static inline int csv_format_float(double v, bool single, char* out)
+{
+    if (std::isnan(v))
+        return 0;
+    if (std::isinf(v))
+    {
+        const char* s = v < 0 ? "-inf" : "inf";
+        memcpy(out, s, strlen(s));
+        return (int)strlen(s);
+    }
+    const double abs_v = std::fabs(v);
+    const bool positional = v == 0 || (abs_v >= 1e-4 && abs_v < (single ? 1e6 : 1e16));
+
+    // integral values which are exact in all their digits are common, format them directly
+    if (v == std::floor(v) && abs_v < (single ? 1e6 : 1e15) && !(v == 0 && std::signbit(v)))
+    {
+        int n = csv_format_int64((int64_t)v, out);
+        out[n++] = '.';
+        out[n++] = '0';
+        return n;
+    }
+
+    // the correctly rounded value with fewest digits that reads back as v, a shorter
+    // one is found by dropping trailing zeros of the first precision to try (subnormals
+    // have fewer significant bits so all precisions are tried)
+    char sci[32];
+    int prec = abs_v < (single ? FLT_MIN : DBL_MIN) ? 1 : single ? 6 : 15;
+    const int max_prec = single ? 9 : 17;
+    for (; prec < max_prec; ++prec)
+    {
+        snprintf(sci, sizeof(sci), "%.*e", prec - 1, v);
+        if (single ? strtof(sci, NULL) == (float)v : strtod(sci, NULL) == v)
+            break;
+    }
+    if (prec == max_prec)
+        snprintf(sci, sizeof(sci), "%.*e", prec - 1, v);
+
+    // split "-d.ddde+xx" into sign, significant digits and exponent
+    const char* s = sci;
+    bool neg = *s == '-';
+    if (neg)
+        ++s;
+    char digits[24];
+    int n_digits = 0;
+    for (; *s != 'e'; ++s)
+    {
+        if (*s != '.')
+            digits[n_digits++] = *s;
+    }
+    int exp = atoi(s + 1);
+    while (n_digits > 1 && digits[n_digits - 1] == '0')
+        --n_digits;
+
+    int n = 0;
+    if (neg)
+        out[n++] = '-';
+    if (positional)
+    {
+        if (exp < 0)
+        {
+            out[n++] = '0';
+            out[n++] = '.';
+            for (int i = 0; i < -exp - 1; ++i)
+                out[n++] = '0';
+            memcpy(out + n, digits, n_digits);
+            return n + n_digits;
+        }
+        for (int i = 0; i <= exp; ++i)
+            out[n++] = i < n_digits ? digits[i] : '0';
+        out[n++] = '.';
+        if (n_digits <= exp + 1)
+        {
+            out[n++] = '0';
+            return n;
+        }
+        memcpy(out + n, digits + exp + 1, n_digits - exp - 1);
+        return n + n_digits - exp - 1;
+    }
+    out[n++] = digits[0];
+    if (n_digits > 1)
+    {
+        out[n++] = '.';
+        memcpy(out + n, digits + 1, n_digits - 1);
+        n += n_digits - 1;
+    }
+    return n + snprintf(out + n, 8, "e%c%02d", exp < 0 ? '-' : '+', std::abs(exp));
+}
+
+static inline int64_t csv_floor_div(int64_t a, int64_t b)
+{
+    return a / b - (a % b != 0 && (a % b < 0));
+}
+
+/// precision pandas uses when formatting the datetime64[ns] values of a column, NaT is ignored
+static inline int csv_datetime_resolution(const int64_t* vals, int64_t n)
+{
+    const int64_t day_ns = 86400LL * 1000000000LL;
+    int reso = CSV_DT_RESO_DATE;
+    for (int64_t i = 0; i < n && reso < CSV_DT_RESO_NS; ++i)
+    {
+        if (vals[i] == INT64_MIN)
+            continue;
+        int64_t day_part = vals[i] - csv_floor_div(vals[i], day_ns) * day_ns;
+        if (day_part == 0)
+            continue;
+        int r = day_part % 1000 ? CSV_DT_RESO_NS
+                                : day_part % 1000000 ? CSV_DT_RESO_US
+                                                     : day_part % 1000000000 ? CSV_DT_RESO_MS : CSV_DT_RESO_S;
+        reso = std::max(reso, r);
+    }
+    return reso;
+}
+
+/// write datetime64[ns] value v as "YYYY-MM-DD[ HH:MM:SS[.fff[fff[fff]]]]", NaT is written as an empty field
+static inline int csv_format_datetime64(int64_t v, int reso, char* out)
+{
+    if (v == INT64_MIN)
+        return 0;
+    const int64_t day_ns = 86400LL * 1000000000LL;
+    int64_t days = csv_floor_div(v, day_ns);
+    int64_t day_part = v - days * day_ns;
+
+    // civil date of days since epoch
+    int64_t z = days + 719468;
+    int64_t era = csv_floor_div(z, 146097);
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = yoe + era * 400 + (month <= 2);
+
+    int n = snprintf(out, 32, "%04lld-%02d-%02d", (long long)year, (int)month, (int)day);
+    if (reso == CSV_DT_RESO_DATE)
+        return n;
+    int64_t secs = day_part / 1000000000;
+    int64_t frac = day_part % 1000000000;
+    n += snprintf(
+        out + n, 32, " %02d:%02d:%02d", (int)(secs / 3600), (int)(secs / 60 % 60), (int)(secs % 60));
+    if (reso == CSV_DT_RESO_MS)
+        n += snprintf(out + n, 16, ".%03d", (int)(frac / 1000000));
+    else if (reso == CSV_DT_RESO_US)
+        n += snprintf(out + n, 16, ".%06d", (int)(frac / 1000));
+    else if (reso == CSV_DT_RESO_NS)
+        n += snprintf(out + n, 16, ".%09d", (int)frac);
+    return n;
+}
+
+/// append a string field to out, quoted (with doubled quotes) if it contains sep, a quote or a line break
+/// ('\r' too since readers take it as a line terminator)
+static inline void csv_append_string_field(std::string& out, const char* s, size_t len, char sep, char quotechar)
+{
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; ++i)
+        quote = s[i] == sep || s[i] == quotechar || s[i] == '\n' || s[i] == '\r';
+    if (!quote)
+    {
+        out.append(s, len);
+        return;
+    }
+    out.push_back(quotechar);
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (s[i] == quotechar)
+            out.push_back(quotechar);
+        out.push_back(s[i]);
+    }
+    out.push_back(quotechar);
+}
+
+template <typename T>
+static inline int csv_format_int_value(const void* data, int64_t i, char* out)
+{
+    return csv_format_int64((int64_t)((const T*)data)[i], out);
+}
+
+/// append field of row i of column col to out
+static inline void
+    csv_append_field(std::string& out, const csv_write_column& col, int64_t i, char sep, char quotechar)
+{
+    char tmp[64];
+    int n = 0;
+    switch (col.type)
+    {
+    case HPAT_CTypes::INT8: n = csv_format_int_value<int8_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::UINT8: n = csv_format_int_value<uint8_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::INT16: n = csv_format_int_value<int16_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::UINT16: n = csv_format_int_value<uint16_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::INT32: n = csv_format_int_value<int32_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::UINT32: n = csv_format_int_value<uint32_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::INT64: n = csv_format_int_value<int64_t>(col.data, i, tmp); break;
+    case HPAT_CTypes::UINT64: n = csv_format_uint64(((const uint64_t*)col.data)[i], tmp); break;
+    case HPAT_CTypes::FLOAT32: n = csv_format_float(((const float*)col.data)[i], true, tmp); break;
+    case HPAT_CTypes::FLOAT64: n = csv_format_float(((const double*)col.data)[i], false, tmp); break;
+    case CSV_COL_DATETIME: n = csv_format_datetime64(((const int64_t*)col.data)[i], col.dt_reso, tmp); break;
+    case CSV_COL_BOOL: out.append(((const uint8_t*)col.data)[i] ? "True" : "False"); return;
+    case CSV_COL_STRING:
+        if (col.null_bitmap == NULL || (col.null_bitmap[i / 8] & (1 << (i % 8))))
+            csv_append_string_field(
+                out, col.chars + col.offsets[i], col.offsets[i + 1] - col.offsets[i], sep, quotechar);
+        return;
+    default: std::cerr << "Error in csv_write: invalid column type " << col.type << std::endl; return;
+    }
+    out.append(tmp, n);
+}
+
+/// append rows [start, end) of the columns of writer to out, each row starts with its index
+static inline void
+    csv_format_rows(const csv_writer* writer, int64_t start, int64_t end, char quotechar, std::string& out)
+{
+    char tmp[24];
+    for (int64_t i = start; i < end; ++i)
+    {
+        out.append(tmp, csv_format_int64(writer->index_start + i, tmp));
+        for (size_t j = 0; j < writer->columns.size(); ++j)
+        {
+            out.push_back(writer->sep);
+            csv_append_field(out, writer->columns[j], i, writer->sep, quotechar);
+        }
+        out.push_back('\n');
+    }
+}
+
+/// format all rows of writer after its buffer contents using n_threads threads
+static inline void csv_format_rows_parallel(csv_writer* writer, char quotechar, int n_threads)
+{
+    const int64_t n_rows = writer->n_rows;
+    int64_t n_tasks = std::min((int64_t)n_threads, n_rows / CSV_FORMAT_MIN_TASK_ROWS);
+    if (n_tasks <= 1)
+    {
+        std::string out;
+        csv_format_rows(writer, 0, n_rows, quotechar, out);
+        writer->buffer.insert(writer->buffer.end(), out.begin(), out.end());
+        return;
+    }
+
+    std::vector<std::string> parts(n_tasks);
+    csv_parallel_for(n_tasks, n_threads, [&](int64_t i) {
+        csv_format_rows(writer, n_rows * i / n_tasks, n_rows * (i + 1) / n_tasks, quotechar, parts[i]);
+    });
+    size_t total = writer->buffer.size();
+    for (int64_t i = 0; i < n_tasks; ++i)
+        total += parts[i].size();
+    writer->buffer.reserve(total);
+    for (int64_t i = 0; i < n_tasks; ++i)
+        writer->buffer.insert(writer->buffer.end(), parts[i].begin(), parts[i].end());
+}
+
+#endif // _CSV_WRITER_H_INCLUDED
@@ -1,8 +1,11 @@
 #include <Python.h>
+#include <algorithm>
 #include <climits>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "hdf5.h"
 
 hid_t hpat_h5_open(char* file_name, char* mode, int64_t is_parallel);
@@ -20,7 +23,15 @@ int hpat_h5_read_filter(hid_t dataset_id,
                         int64_t* indices,
                         int n_indices);
 int hpat_h5_close(hid_t file_id);
-hid_t hpat_h5_create_dset(hid_t file_id, char* dset_name, int ndims, int64_t* counts, int typ_enum);
+hid_t hpat_h5_create_dset(hid_t file_id,
+                          char* dset_name,
+                          int ndims,
+                          int64_t* counts,
+                          int typ_enum,
+                          int filter,
+                          int level,
+                          int shuffle,
+                          int64_t chunk_bytes);
 hid_t hpat_h5_create_group(hid_t file_id, char* group_name);
 int hpat_h5_write(
     hid_t dataset_id, int ndims, int64_t* starts, int64_t* counts, int64_t is_parallel, void* out, int typ_enum);
@@ -82,14 +93,16 @@ hid_t hpat_h5_open(char* file_name, char* mode, int64_t is_parallel)
     hid_t file_id = -1;
     unsigned flag = H5F_ACC_RDWR;
 
-    //int num_pes;
-    //MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
-    // TODO: enable MPIO after fixing address overflow issues
-    // if(false && is_parallel && num_pes>1)
-    // {
-    //     ret = H5Pset_fapl_mpio(plist_id, MPI_COMM_WORLD, MPI_INFO_NULL);
-    //     CHECK(ret != -1, "h5 open MPI driver set error");
-    // }
+#ifdef H5_HAVE_PARALLEL
+    // parallel opens are collective, see h5_transfer_hyperslab for transfers
+    int num_pes;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
+    if (is_parallel && num_pes > 1)
+    {
+        ret = H5Pset_fapl_mpio(plist_id, MPI_COMM_WORLD, MPI_INFO_NULL);
+        CHECK(ret != -1, "h5 open MPI driver set error");
+    }
+#endif
 
     // TODO: handle 'a' mode
     if (strcmp(mode, "r") == 0)
@@ -120,6 +133,92 @@ hid_t hpat_h5_open(char* file_name, char* mode, int64_t is_parallel)
     return file_id;
 }
 
+// ***********************************************************************************
+// Chunked datasets
+//
+// HDF5 caches the decompressed chunks of a dataset (1 MB by default, chunks larger
+// than the cache aren't cached at all). Reads split into several H5Dread calls, like
+// dense filtered reads and split transfers, decompress the chunks at their boundaries
+// again if they are evicted in between. Datasets are read in ranges of rows, so the
+// cache is sized to hold the chunks of a row of chunks (chunks intersecting the same
+// rows) twice.
+
+// limit of the chunk cache of a dataset
+#define H5_CHUNK_CACHE_MAX_BYTES (256 * 1024 * 1024)
+// limit of the hash table slots of a chunk cache
+#define H5_CHUNK_CACHE_MAX_SLOTS 1000000
+
+static size_t h5_next_prime(size_t n)
+{
+    for (;; n++)
+    {
+        bool is_prime = n > 1;
+        for (size_t d = 2; d * d <= n && is_prime; d++)
+        {
+            is_prime = n % d != 0;
+        }
+        if (is_prime)
+        {
+            return n;
+        }
+    }
+}
+
+/// chunk dimensions of the dataset, empty if it isn't chunked
+std::vector<hsize_t> h5_get_chunk_dims(hid_t dataset_id)
+{
+    std::vector<hsize_t> chunk_dims;
+    hid_t dcpl_id = H5Dget_create_plist(dataset_id);
+    if (H5Pget_layout(dcpl_id) == H5D_CHUNKED)
+    {
+        chunk_dims.resize(H5S_MAX_RANK);
+        int ndims = H5Pget_chunk(dcpl_id, H5S_MAX_RANK, chunk_dims.data());
+        chunk_dims.resize(std::max(ndims, 0));
+    }
+    H5Pclose(dcpl_id);
+    return chunk_dims;
+}
+
+/// access properties with a chunk cache for reading rows of the dataset, H5P_DEFAULT if it isn't chunked
+hid_t h5_get_dset_access_plist(hid_t dataset_id)
+{
+    std::vector<hsize_t> chunk_dims = h5_get_chunk_dims(dataset_id);
+    if (chunk_dims.empty())
+    {
+        return H5P_DEFAULT;
+    }
+    hid_t space_id = H5Dget_space(dataset_id);
+    std::vector<hsize_t> dims(chunk_dims.size());
+    H5Sget_simple_extent_dims(space_id, dims.data(), NULL);
+    H5Sclose(space_id);
+    hid_t type_id = H5Dget_type(dataset_id);
+    size_t chunk_bytes = H5Tget_size(type_id);
+    H5Tclose(type_id);
+
+    size_t n_row_chunks = 1;
+    for (size_t i = 0; i < chunk_dims.size(); i++)
+    {
+        chunk_bytes *= chunk_dims[i];
+        if (i > 0)
+        {
+            n_row_chunks *= (dims[i] + chunk_dims[i] - 1) / chunk_dims[i];
+        }
+    }
+    size_t cache_bytes = std::min((size_t)H5_CHUNK_CACHE_MAX_BYTES, 2 * n_row_chunks * chunk_bytes);
+    cache_bytes = std::max(cache_bytes, std::max(chunk_bytes, (size_t)1024 * 1024));
+    // HDF5 suggests a prime number of slots about 100 times the number of chunks in the cache
+    size_t n_cache_chunks = cache_bytes / std::max(chunk_bytes, (size_t)1);
+    size_t n_slots = std::min((size_t)H5_CHUNK_CACHE_MAX_SLOTS, 100 * n_cache_chunks);
+    n_slots = h5_next_prime(n_slots);
+
+    hid_t dapl_id = H5Pcreate(H5P_DATASET_ACCESS);
+    CHECK(dapl_id != -1, "h5 dataset access property create error");
+    // rows are read in order, so fully read chunks are evicted first
+    herr_t ret = H5Pset_chunk_cache(dapl_id, n_slots, cache_bytes, 1.0);
+    CHECK(ret != -1, "h5 set chunk cache error");
+    return dapl_id;
+}
+
 hid_t hpat_h5_open_dset_or_group_obj(hid_t file_or_group_id, char* obj_name)
 {
     // handle obj['A'] call, the output can be group or dataset
@@ -137,6 +236,14 @@ hid_t hpat_h5_open_dset_or_group_obj(hid_t file_or_group_id, char* obj_name)
     {
         // printf("open dset: %s\n", obj_name);
         obj_id = H5Dopen2(file_or_group_id, obj_name, H5P_DEFAULT);
+        // reopen chunked datasets with a chunk cache sized for them
+        hid_t dapl_id = obj_id == -1 ? H5P_DEFAULT : h5_get_dset_access_plist(obj_id);
+        if (dapl_id != H5P_DEFAULT)
+        {
+            H5Dclose(obj_id);
+            obj_id = H5Dopen2(file_or_group_id, obj_name, dapl_id);
+            H5Pclose(dapl_id);
+        }
     }
     CHECK(obj_id != -1, "h5 open dset or group error");
     return obj_id;
@@ -156,43 +263,286 @@ int64_t hpat_h5_size(hid_t dataset_id, int dim)
     return ret;
 }
 
-hid_t get_dset_space_from_range(hid_t dataset_id, int64_t* starts, int64_t* counts)
+// ***********************************************************************************
+// Hyperslab transfers
+//
+// Reads and writes of a hyperslab are split along the first dimension into transfers
+// of at most H5_MAX_TRANSFER_BYTES, since MPI-IO addresses the bytes of a transfer
+// with int counts. On files opened in parallel with MPI-IO, ranks agree on the number
+// of transfers (some can be empty) and on the transfer mode: collective if any rank's
+// selection is small or isn't contiguous in the file, where MPI-IO aggregating the
+// requests of ranks pays off, and independent if all ranks transfer large contiguous
+// blocks, which collective buffering would only copy around.
+
+// largest transfer of a single H5Dread or H5Dwrite call, in bytes
+#define H5_MAX_TRANSFER_BYTES (1024LL * 1024 * 1024)
+// parallel transfers smaller than this on any rank are collective
+#define H5_COLLECTIVE_MAX_BYTES (4 * 1024 * 1024)
+
+#ifdef H5_HAVE_PARALLEL
+/// true if the file of the dataset is opened with the MPI-IO driver
+bool h5_is_mpio(hid_t dataset_id)
+{
+    hid_t file_id = H5Iget_file_id(dataset_id);
+    hid_t fapl_id = H5Fget_access_plist(file_id);
+    bool is_mpio = H5Pget_driver(fapl_id) == H5FD_MPIO;
+    H5Pclose(fapl_id);
+    H5Fclose(file_id);
+    return is_mpio;
+}
+
+/// true if this rank prefers collective transfer for its selection of n_bytes
+bool h5_prefer_collective(hid_t dataset_id, int ndims, int64_t* starts, int64_t* counts, hsize_t n_bytes)
 {
+    // ranks with nothing to transfer don't decide
+    if (n_bytes == 0)
+    {
+        return false;
+    }
+    if (n_bytes < H5_COLLECTIVE_MAX_BYTES)
+    {
+        return true;
+    }
+    // chunks of chunked datasets can be shared by ranks
+    hid_t dcpl_id = H5Dget_create_plist(dataset_id);
+    H5D_layout_t layout = H5Pget_layout(dcpl_id);
+    H5Pclose(dcpl_id);
+    if (layout != H5D_CONTIGUOUS)
+    {
+        return true;
+    }
+    // rows are contiguous in the file if the selection spans the other dimensions
     hid_t space_id = H5Dget_space(dataset_id);
-    CHECK(space_id != -1, "h5 read get_space error");
+    std::vector<hsize_t> dims(ndims);
+    H5Sget_simple_extent_dims(space_id, dims.data(), NULL);
+    H5Sclose(space_id);
+    for (int i = 1; i < ndims; i++)
+    {
+        if (starts[i] != 0 || (hsize_t)counts[i] != dims[i])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
 
-    hsize_t* HDF5_start = (hsize_t*)starts;
-    hsize_t* HDF5_count = (hsize_t*)counts;
-    herr_t ret = H5Sselect_hyperslab(space_id, H5S_SELECT_SET, HDF5_start, NULL, HDF5_count, NULL);
-    CHECK(ret != -1, "h5 read select_hyperslab error");
-    return space_id;
+/// read (or write) the hyperslab of the dataset given by starts and counts from (to) buf
+herr_t h5_transfer_hyperslab(hid_t dataset_id,
+                             int ndims,
+                             int64_t* starts,
+                             int64_t* counts,
+                             int64_t is_parallel,
+                             void* buf,
+                             int typ_enum,
+                             bool is_write)
+{
+    hid_t h5_typ = get_h5_typ(typ_enum);
+    hsize_t row_bytes = H5Tget_size(h5_typ);
+    for (int i = 1; i < ndims; i++)
+    {
+        row_bytes *= counts[i];
+    }
+    hsize_t n_rows = counts[0];
+    hsize_t max_rows = std::max((hsize_t)1, (hsize_t)H5_MAX_TRANSFER_BYTES / std::max(row_bytes, (hsize_t)1));
+    int64_t n_transfers = std::max((hsize_t)1, (n_rows + max_rows - 1) / max_rows);
+
+    hid_t xfer_plist_id = H5P_DEFAULT;
+#ifdef H5_HAVE_PARALLEL
+    int num_pes;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
+    if (is_parallel && num_pes > 1 && h5_is_mpio(dataset_id))
+    {
+        // collective calls need all ranks, which all do as many transfers as the rank with the most
+        int64_t transfer_params[2] = {n_transfers,
+                                      h5_prefer_collective(dataset_id, ndims, starts, counts, n_rows * row_bytes)};
+        MPI_Allreduce(MPI_IN_PLACE, transfer_params, 2, MPI_LONG_LONG_INT, MPI_MAX, MPI_COMM_WORLD);
+        n_transfers = transfer_params[0];
+        xfer_plist_id = H5Pcreate(H5P_DATASET_XFER);
+        CHECK(xfer_plist_id != -1, "h5 transfer property create error");
+        herr_t ret =
+            H5Pset_dxpl_mpio(xfer_plist_id, transfer_params[1] ? H5FD_MPIO_COLLECTIVE : H5FD_MPIO_INDEPENDENT);
+        CHECK(ret != -1, "h5 transfer MPI mode set error");
+    }
+#endif
+
+    std::vector<hsize_t> HDF5_start(starts, starts + ndims);
+    std::vector<hsize_t> HDF5_count(counts, counts + ndims);
+    herr_t status = 0;
+    for (int64_t i = 0; i < n_transfers; i++)
+    {
+        hsize_t first_row = std::min(i * max_rows, n_rows);
+        HDF5_start[0] = starts[0] + first_row;
+        HDF5_count[0] = std::min(max_rows, n_rows - first_row);
+
+        herr_t ret;
+        hid_t space_id = H5Dget_space(dataset_id);
+        CHECK(space_id != -1, "h5 transfer get_space error");
+        hid_t mem_dataspace;
+        if (HDF5_count[0] == 0)
+        {
+            // empty transfer in collective calls
+            hsize_t one = 1;
+            H5Sselect_none(space_id);
+            mem_dataspace = H5Screate_simple(1, &one, NULL);
+            H5Sselect_none(mem_dataspace);
+        }
+        else
+        {
+            ret = H5Sselect_hyperslab(space_id, H5S_SELECT_SET, HDF5_start.data(), NULL, HDF5_count.data(), NULL);
+            CHECK(ret != -1, "h5 transfer select_hyperslab error");
+            mem_dataspace = H5Screate_simple((hsize_t)ndims, HDF5_count.data(), NULL);
+        }
+        CHECK(mem_dataspace != -1, "h5 transfer create_simple error");
+
+        // later transfers are still done after errors since other ranks can wait in collective calls
+        char* transfer_buf = (char*)buf + first_row * row_bytes;
+        if (is_write)
+        {
+            ret = H5Dwrite(dataset_id, h5_typ, mem_dataspace, space_id, xfer_plist_id, transfer_buf);
+        }
+        else
+        {
+            ret = H5Dread(dataset_id, h5_typ, mem_dataspace, space_id, xfer_plist_id, transfer_buf);
+        }
+        if (ret < 0)
+        {
+            status = ret;
+        }
+        H5Sclose(mem_dataspace);
+        H5Sclose(space_id);
+    }
+
+    if (xfer_plist_id != H5P_DEFAULT)
+    {
+        H5Pclose(xfer_plist_id);
+    }
+    return status;
 }
 
+#ifdef H5_HAVE_PARALLEL
+// largest increase of the rows of the largest block allowed when aligning blocks to chunks
+#define H5_ALIGN_MAX_IMBALANCE 0.1
+
+/**
+ * Read the 1D block of this rank of a parallel read of a compressed chunked dataset
+ * with the boundaries of the blocks of ranks moved to the nearest chunk boundaries,
+ * so that no chunk is decompressed by two ranks. The rows read for other ranks are
+ * then exchanged with them.
+ *
+ * @return false if not applicable (and nothing is read): the dataset isn't compressed,
+ *         the blocks aren't consecutive, or aligning them would unbalance the ranks
+ **/
+bool h5_read_chunk_aligned(
+    hid_t dataset_id, int ndims, int64_t* starts, int64_t* counts, void* out, int typ_enum, herr_t* ret)
+{
+    int num_pes;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    // same on all ranks, so they all decide the same
+    std::vector<hsize_t> chunk_dims = h5_get_chunk_dims(dataset_id);
+    hid_t dcpl_id = H5Dget_create_plist(dataset_id);
+    bool is_compressed = H5Pget_nfilters(dcpl_id) > 0;
+    H5Pclose(dcpl_id);
+    if (num_pes == 1 || chunk_dims.empty() || chunk_dims[0] <= 1 || !is_compressed)
+    {
+        return false;
+    }
+    int64_t chunk_rows = chunk_dims[0];
+
+    int64_t block[2] = {starts[0], counts[0]};
+    std::vector<int64_t> blocks(2 * num_pes);
+    MPI_Allgather(block, 2, MPI_LONG_LONG_INT, blocks.data(), 2, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+    std::vector<int64_t> bounds(num_pes + 1, blocks[0]);
+    for (int i = 0; i < num_pes; i++)
+    {
+        if (blocks[2 * i] != bounds[i])
+        {
+            return false;
+        }
+        bounds[i + 1] = blocks[2 * i] + blocks[2 * i + 1];
+    }
+    std::vector<int64_t> aligned(bounds);
+    int64_t max_block = 0;
+    int64_t max_aligned = 0;
+    for (int i = 0; i < num_pes; i++)
+    {
+        if (i > 0)
+        {
+            int64_t chunk_bound = (bounds[i] + chunk_rows / 2) / chunk_rows * chunk_rows;
+            aligned[i] = std::min(std::max(chunk_bound, aligned[i - 1]), bounds[num_pes]);
+        }
+        max_block = std::max(max_block, bounds[i + 1] - bounds[i]);
+    }
+    for (int i = 0; i < num_pes; i++)
+    {
+        max_aligned = std::max(max_aligned, aligned[i + 1] - aligned[i]);
+    }
+    if (aligned == bounds || max_aligned > max_block * (1 + H5_ALIGN_MAX_IMBALANCE))
+    {
+        return false;
+    }
+
+    hid_t h5_typ = get_h5_typ(typ_enum);
+    hsize_t row_bytes = H5Tget_size(h5_typ);
+    for (int i = 1; i < ndims; i++)
+    {
+        row_bytes *= counts[i];
+    }
+    std::vector<int64_t> aligned_starts(starts, starts + ndims);
+    std::vector<int64_t> aligned_counts(counts, counts + ndims);
+    aligned_starts[0] = aligned[rank];
+    aligned_counts[0] = aligned[rank + 1] - aligned[rank];
+    std::vector<char> aligned_rows(aligned_counts[0] * row_bytes);
+    *ret = h5_transfer_hyperslab(
+        dataset_id, ndims, aligned_starts.data(), aligned_counts.data(), 1, aligned_rows.data(), typ_enum, false);
+
+    // rows of the aligned range go to the ranks whose blocks contain them
+    std::vector<int> send_counts(num_pes);
+    std::vector<int> recv_counts(num_pes);
+    std::vector<int> send_disp(num_pes);
+    std::vector<int> recv_disp(num_pes);
+    for (int i = 0; i < num_pes; i++)
+    {
+        int64_t send_start = std::max(aligned[rank], bounds[i]);
+        int64_t recv_start = std::max(bounds[rank], aligned[i]);
+        send_counts[i] = std::max((int64_t)0, std::min(aligned[rank + 1], bounds[i + 1]) - send_start);
+        recv_counts[i] = std::max((int64_t)0, std::min(bounds[rank + 1], aligned[i + 1]) - recv_start);
+        send_disp[i] = send_counts[i] == 0 ? 0 : send_start - aligned[rank];
+        recv_disp[i] = recv_counts[i] == 0 ? 0 : recv_start - bounds[rank];
+    }
+    MPI_Datatype row_type;
+    MPI_Type_contiguous((int)row_bytes, MPI_BYTE, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_Alltoallv(aligned_rows.data(),
+                  send_counts.data(),
+                  send_disp.data(),
+                  row_type,
+                  out,
+                  recv_counts.data(),
+                  recv_disp.data(),
+                  row_type,
+                  MPI_COMM_WORLD);
+    MPI_Type_free(&row_type);
+    return true;
+}
+#endif
+
 int hpat_h5_read(
     hid_t dataset_id, int ndims, int64_t* starts, int64_t* counts, int64_t is_parallel, void* out, int typ_enum)
 {
     // printf("h5read ndims:%d size:%d typ:%d\n", ndims, counts[0], typ_enum);
     // fflush(stdout);
     // printf("start %lld end %lld\n", start_ind, end_ind);
-    herr_t ret;
     CHECK(dataset_id != -1, "h5 read invalid dataset_id");
-
-    hid_t space_id = get_dset_space_from_range(dataset_id, starts, counts);
-
-    //int num_pes;
-    //MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
-    hid_t xfer_plist_id = H5P_DEFAULT;
-    // TODO: enable MPIO after fixing address overflow issues
-    // if(false && is_parallel && num_pes>1)
-    // {
-    //     xfer_plist_id = H5Pcreate(H5P_DATASET_XFER);
-    //     H5Pset_dxpl_mpio(xfer_plist_id, H5FD_MPIO_COLLECTIVE);
-    // }
-
-    hid_t mem_dataspace = H5Screate_simple((hsize_t)ndims, (hsize_t*)counts, NULL);
-    CHECK(mem_dataspace != -1, "h5 read create_simple error");
-    hid_t h5_typ = get_h5_typ(typ_enum);
-    ret = H5Dread(dataset_id, h5_typ, mem_dataspace, space_id, xfer_plist_id, out);
+    herr_t ret;
+#ifdef H5_HAVE_PARALLEL
+    if (!(is_parallel && h5_read_chunk_aligned(dataset_id, ndims, starts, counts, out, typ_enum, &ret)))
+#endif
+    {
+        ret = h5_transfer_hyperslab(dataset_id, ndims, starts, counts, is_parallel, out, typ_enum, false);
+    }
     CHECK(ret != -1, "h5 read call error");
     // printf("out: %lf %lf ...\n", ((double*)out)[0], ((double*)out)[1]);
     // TODO: close here?
@@ -200,48 +550,223 @@ int hpat_h5_read(
     return ret;
 }
 
-hid_t get_dset_space_from_indices(
-    hid_t dataset_id, int ndims, int64_t* starts, int64_t* counts, int64_t* indices, int n_indices)
+// ***********************************************************************************
+// Filtered reads
+//
+// The selected rows are coalesced into runs of consecutive rows and read either as
+// a union of hyperslab blocks (one per run) in a single H5Dread, or densely: the
+// rows spanned by the runs are read in contiguous windows (skipping gaps larger than
+// a window) and the selected rows are copied out of them. HDF5 processes unions one
+// block at a time, so many short runs are cheaper to read densely, while sparse
+// selections are cheaper as unions. The strategy is picked by estimating both costs
+// in bytes read, with per block and per read call overheads as byte equivalents.
+// Merging a block into a union gets slower as the union grows, so the overhead of
+// unions grows quadratically with the number of blocks.
+
+// estimated overhead of a block of a hyperslab union, in bytes read
+#define H5_SELECT_BLOCK_COST 8192
+// estimated overhead of merging a block into a union, per block in the union
+#define H5_SELECT_MERGE_COST 16
+// estimated overhead of an H5Dread call, in bytes read
+#define H5_READ_CALL_COST (64 * 1024)
+// size of the windows of dense reads
+#define H5_DENSE_READ_WINDOW_BYTES (64 * 1024 * 1024)
+
+// rows [start, start + count) of the first dimension selected by a filtered read
+struct h5_row_run
+{
+    hsize_t start;
+    hsize_t count;
+};
+
+/// runs of consecutive rows of the indices, which are sorted and deduplicated if needed
+std::vector<h5_row_run> get_index_runs(int64_t* indices, int n_indices)
+{
+    std::vector<h5_row_run> runs;
+    std::vector<int64_t> sorted_indices;
+    if (!std::is_sorted(indices, indices + n_indices))
+    {
+        sorted_indices.assign(indices, indices + n_indices);
+        std::sort(sorted_indices.begin(), sorted_indices.end());
+        indices = sorted_indices.data();
+    }
+    for (int i = 0; i < n_indices; i++)
+    {
+        hsize_t row = indices[i];
+        if (!runs.empty() && row < runs.back().start + runs.back().count)
+        {
+            // duplicate
+            continue;
+        }
+        if (!runs.empty() && row == runs.back().start + runs.back().count)
+        {
+            runs.back().count++;
+        }
+        else
+        {
+            runs.push_back({row, 1});
+        }
+    }
+    return runs;
+}
+
+/// rows read by a dense read of the runs, and the number of windows (read calls)
+void get_dense_read_size(const std::vector<h5_row_run>& runs,
+                         hsize_t window_rows,
+                         hsize_t* read_rows,
+                         hsize_t* n_windows)
+{
+    *read_rows = 0;
+    *n_windows = 0;
+    hsize_t window_end = 0;
+    for (const h5_row_run& run : runs)
+    {
+        hsize_t run_end = run.start + run.count;
+        if (*n_windows > 0 && run.start < window_end)
+        {
+            if (run_end <= window_end)
+            {
+                continue;
+            }
+            // the rest of the run starts windows right after the current one
+            hsize_t n_new = (run_end - window_end + window_rows - 1) / window_rows;
+            *read_rows += n_new * window_rows;
+            *n_windows += n_new;
+            window_end += n_new * window_rows;
+            continue;
+        }
+        // a gap larger than the windows read so far, windows start at the run
+        hsize_t n_new = (run.count + window_rows - 1) / window_rows;
+        *read_rows += n_new * window_rows;
+        *n_windows += n_new;
+        window_end = run.start + n_new * window_rows;
+    }
+    // the last window ends with the last run
+    if (!runs.empty())
+    {
+        *read_rows -= window_end - (runs.back().start + runs.back().count);
+    }
+}
+
+/// true if reading the runs densely is estimated to be cheaper than a hyperslab union
+bool use_dense_filter_read(const std::vector<h5_row_run>& runs, hsize_t row_bytes)
+{
+    if (runs.size() <= 1)
+    {
+        return false;
+    }
+    hsize_t window_rows = std::max((hsize_t)1, (hsize_t)H5_DENSE_READ_WINDOW_BYTES / row_bytes);
+    hsize_t read_rows;
+    hsize_t n_windows;
+    get_dense_read_size(runs, window_rows, &read_rows, &n_windows);
+    hsize_t selected_rows = 0;
+    for (const h5_row_run& run : runs)
+    {
+        selected_rows += run.count;
+    }
+    // dense reads copy the selected rows once more
+    double dense_cost = (double)n_windows * H5_READ_CALL_COST + (double)(read_rows + selected_rows) * row_bytes;
+    double n_blocks = runs.size();
+    double union_cost = H5_READ_CALL_COST + n_blocks * H5_SELECT_BLOCK_COST +
+                        n_blocks * n_blocks * H5_SELECT_MERGE_COST + (double)selected_rows * row_bytes;
+    return dense_cost < union_cost;
+}
+
+hid_t get_dset_space_from_indices(hid_t dataset_id, int ndims, int64_t* counts, const std::vector<h5_row_run>& runs)
 {
-    // printf("num ind: %d\n", n_indices);
+    // printf("num runs: %d\n", runs.size());
     hid_t space_id = H5Dget_space(dataset_id);
     CHECK(space_id != -1, "h5 read get_space error");
 
-    hsize_t* HDF5_start = new hsize_t[ndims];
-    hsize_t* HDF5_count = new hsize_t[ndims];
-    hsize_t* HDF5_block = new hsize_t[ndims];
+    // check for empty index list
+    if (runs.empty())
+    {
+        herr_t ret = H5Sselect_none(space_id);
+        CHECK(ret != -1, "h5 read select_none error");
+        return space_id;
+    }
+
+    std::vector<hsize_t> HDF5_start(ndims, 0);
+    std::vector<hsize_t> HDF5_count(ndims, 1);
+    std::vector<hsize_t> HDF5_block(ndims);
     for (int i = 1; i < ndims; i++)
     {
-        HDF5_start[i] = 0;
-        HDF5_count[i] = 1;
         HDF5_block[i] = counts[i];
     }
-    // check for empty index list
-    if (n_indices <= 0)
+    for (size_t i = 0; i < runs.size(); i++)
     {
-        HDF5_start[0] = 0;
-        HDF5_count[0] = 0;
-        HDF5_block[0] = 0;
-        H5Sselect_hyperslab(space_id, H5S_SELECT_SET, HDF5_start, NULL, HDF5_count, HDF5_block);
-        return space_id;
+        HDF5_start[0] = runs[i].start;
+        HDF5_block[0] = runs[i].count;
+        herr_t ret = H5Sselect_hyperslab(space_id,
+                                         i == 0 ? H5S_SELECT_SET : H5S_SELECT_OR,
+                                         HDF5_start.data(),
+                                         NULL,
+                                         HDF5_count.data(),
+                                         HDF5_block.data());
+        CHECK(ret != -1, "h5 read select_hyperslab error");
     }
-    // printf("ind %d\n", indices[0]);
-    HDF5_start[0] = indices[0];
-    HDF5_count[0] = 1;
-    HDF5_block[0] = 1;
-    H5Sselect_hyperslab(space_id, H5S_SELECT_SET, HDF5_start, NULL, HDF5_count, HDF5_block);
-    for (int i = 1; i < n_indices; i++)
+    return space_id;
+}
+
+/// read the rows of the runs in contiguous windows and copy them to out
+herr_t read_dset_runs_dense(hid_t dataset_id,
+                            int ndims,
+                            int64_t* counts,
+                            hid_t h5_typ,
+                            const std::vector<h5_row_run>& runs,
+                            hsize_t row_bytes,
+                            char* out)
+{
+    hsize_t window_rows = std::max((hsize_t)1, (hsize_t)H5_DENSE_READ_WINDOW_BYTES / row_bytes);
+    hsize_t span_end = runs.back().start + runs.back().count;
+    std::vector<char> window;
+    std::vector<hsize_t> HDF5_start(ndims, 0);
+    std::vector<hsize_t> HDF5_count(ndims);
+    for (int i = 1; i < ndims; i++)
     {
-        HDF5_start[0] = indices[i];
-        // printf("ind %d\n", indices[i]);
-        herr_t ret = H5Sselect_hyperslab(space_id, H5S_SELECT_OR, HDF5_start, NULL, HDF5_count, HDF5_block);
-        CHECK(ret != -1, "h5 read select_hyperslab error");
+        HDF5_count[i] = counts[i];
     }
 
-    delete[] HDF5_start;
-    delete[] HDF5_count;
-    delete[] HDF5_block;
-    return space_id;
+    size_t run_ind = 0;
+    hsize_t run_offset = 0; // rows of the current run copied already
+    while (run_ind < runs.size())
+    {
+        hsize_t window_start = runs[run_ind].start + run_offset;
+        hsize_t window_end = std::min(window_start + window_rows, span_end);
+        HDF5_start[0] = window_start;
+        HDF5_count[0] = window_end - window_start;
+        window.resize(HDF5_count[0] * row_bytes);
+
+        hid_t space_id = H5Dget_space(dataset_id);
+        CHECK(space_id != -1, "h5 read get_space error");
+        herr_t ret = H5Sselect_hyperslab(space_id, H5S_SELECT_SET, HDF5_start.data(), NULL, HDF5_count.data(), NULL);
+        CHECK(ret != -1, "h5 read select_hyperslab error");
+        hid_t mem_dataspace = H5Screate_simple((hsize_t)ndims, HDF5_count.data(), NULL);
+        CHECK(mem_dataspace != -1, "h5 read create_simple error");
+        ret = H5Dread(dataset_id, h5_typ, mem_dataspace, space_id, H5P_DEFAULT, window.data());
+        CHECK(ret != -1, "h5 read call error");
+        H5Sclose(mem_dataspace);
+        H5Sclose(space_id);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        while (run_ind < runs.size() && runs[run_ind].start + run_offset < window_end)
+        {
+            hsize_t row = runs[run_ind].start + run_offset;
+            hsize_t n_rows = std::min(runs[run_ind].start + runs[run_ind].count, window_end) - row;
+            memcpy(out, window.data() + (row - window_start) * row_bytes, n_rows * row_bytes);
+            out += n_rows * row_bytes;
+            run_offset += n_rows;
+            if (run_offset == runs[run_ind].count)
+            {
+                run_ind++;
+                run_offset = 0;
+            }
+        }
+    }
+    return 0;
 }
 
 int hpat_h5_read_filter(hid_t dataset_id,
@@ -260,24 +785,33 @@ int hpat_h5_read_filter(hid_t dataset_id,
     herr_t ret;
     CHECK(dataset_id != -1, "h5 read invalid dataset_id");
 
-    hid_t space_id = get_dset_space_from_indices(dataset_id, ndims, starts, counts, indices, n_indices);
+    std::vector<h5_row_run> runs = get_index_runs(indices, n_indices);
+    hid_t h5_typ = get_h5_typ(typ_enum);
+    hsize_t row_bytes = H5Tget_size(h5_typ);
+    for (int i = 1; i < ndims; i++)
+    {
+        row_bytes *= counts[i];
+    }
+
+    if (row_bytes > 0 && use_dense_filter_read(runs, row_bytes))
+    {
+        ret = read_dset_runs_dense(dataset_id, ndims, counts, h5_typ, runs, row_bytes, (char*)out);
+        H5Dclose(dataset_id);
+        return ret;
+    }
 
-    //int num_pes;
-    //MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
+    hid_t space_id = get_dset_space_from_indices(dataset_id, ndims, counts, runs);
+
+    // filtered reads are independent since ranks can do different numbers of reads
     hid_t xfer_plist_id = H5P_DEFAULT;
-    // TODO: enable MPIO after fixing address overflow issues
-    // if(false && is_parallel && num_pes>1)
-    // {
-    //     xfer_plist_id = H5Pcreate(H5P_DATASET_XFER);
-    //     H5Pset_dxpl_mpio(xfer_plist_id, H5FD_MPIO_COLLECTIVE);
-    // }
 
     hid_t mem_dataspace = H5Screate_simple((hsize_t)ndims, (hsize_t*)counts, NULL);
     CHECK(mem_dataspace != -1, "h5 read create_simple error");
-    hid_t h5_typ = get_h5_typ(typ_enum);
     ret = H5Dread(dataset_id, h5_typ, mem_dataspace, space_id, xfer_plist_id, out);
     CHECK(ret != -1, "h5 read call error");
     // printf("out: %lf %lf ...\n", ((double*)out)[0], ((double*)out)[1]);
+    H5Sclose(mem_dataspace);
+    H5Sclose(space_id);
     // TODO: close here?
     H5Dclose(dataset_id);
     return ret;
@@ -404,7 +938,154 @@ int hpat_h5_close(hid_t file_id)
     return 0;
 }
 
-hid_t hpat_h5_create_dset(hid_t file_id, char* dset_name, int ndims, int64_t* counts, int typ_enum)
+// ***********************************************************************************
+// Dataset creation
+//
+// Datasets are contiguous by default. With a filter (compression) or a chunk size, they
+// are created chunked along the first dimension, with the first dimension extendible so
+// rows can be appended later. Chunks span the other dimensions (unless that's above
+// H5_MAX_CHUNK_BYTES) and their rows are about the rows each rank writes divided into
+// chunks of at most chunk_bytes, so a rank's block starts near a chunk boundary and
+// few chunks are written by two ranks. Filtered datasets are written collectively (see
+// h5_prefer_collective), which parallel HDF5 requires since 1.10.2 and doesn't support
+// before, so filters are dropped on files opened with MPI-IO by older versions.
+
+// HDF5 limits chunks to 4 GB; filters can grow incompressible chunks past their raw size and parallel HDF5
+// sends whole chunks in single MPI messages (int counts, 2 GB), so stay well below both at 1 GB
+#define H5_MAX_CHUNK_BYTES ((hsize_t)1024 * 1024 * 1024)
+// chunk size of filtered datasets created without one
+#define H5_DEFAULT_CHUNK_BYTES ((hsize_t)4 * 1024 * 1024)
+
+/// number of ranks writing to the file, 1 unless it is opened with MPI-IO
+static int h5_get_num_writers(hid_t file_id)
+{
+    int num_pes = 1;
+#ifdef H5_HAVE_PARALLEL
+    hid_t fapl_id = H5Fget_access_plist(file_id);
+    if (H5Pget_driver(fapl_id) == H5FD_MPIO)
+    {
+        MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
+    }
+    H5Pclose(fapl_id);
+#endif
+    return num_pes;
+}
+
+/// chunk dimensions of a dataset of dims written in 1D blocks by num_pes ranks
+std::vector<hsize_t>
+    h5_get_create_chunk_dims(int ndims, const hsize_t* dims, size_t type_size, int num_pes, hsize_t chunk_bytes)
+{
+    std::vector<hsize_t> chunk_dims(dims, dims + ndims);
+    hsize_t row_bytes = type_size;
+    for (int i = 1; i < ndims; i++)
+    {
+        row_bytes *= chunk_dims[i];
+    }
+    // split the other dimensions (largest first) if a row is too large for a chunk
+    while (row_bytes > H5_MAX_CHUNK_BYTES)
+    {
+        hsize_t* max_dim = std::max_element(chunk_dims.data() + 1, chunk_dims.data() + ndims);
+        row_bytes = row_bytes / *max_dim * ((*max_dim + 1) / 2);
+        *max_dim = (*max_dim + 1) / 2;
+    }
+    hsize_t rank_rows = std::max((dims[0] + num_pes - 1) / num_pes, (hsize_t)1);
+    hsize_t max_rows = std::max(std::min(chunk_bytes, H5_MAX_CHUNK_BYTES) / row_bytes, (hsize_t)1);
+    hsize_t rank_chunks = (rank_rows + max_rows - 1) / max_rows;
+    chunk_dims[0] = (rank_rows + rank_chunks - 1) / rank_chunks;
+    return chunk_dims;
+}
+
+/// add filter to the pipeline of dcpl_id, false if it isn't available for writing
+static bool h5_set_filter(hid_t dcpl_id, H5Z_filter_t filter, int level)
+{
+    unsigned int filter_info = 0;
+    if (H5Zfilter_avail(filter) <= 0 || H5Zget_filter_info(filter, &filter_info) < 0 ||
+        !(filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED))
+    {
+        return false;
+    }
+    herr_t ret;
+    if (filter == H5Z_FILTER_DEFLATE)
+    {
+        ret = H5Pset_deflate(dcpl_id, std::max(std::min(level, 9), 0));
+    }
+    else if (filter == H5Z_FILTER_SZIP)
+    {
+        ret = H5Pset_szip(dcpl_id, H5_SZIP_NN_OPTION_MASK, 16);
+    }
+    else
+    {
+        // filters registered by plugins (or libraries like h5py) with their default parameters
+        ret = H5Pset_filter(dcpl_id, filter, H5Z_FLAG_OPTIONAL, 0, NULL);
+    }
+    return ret >= 0;
+}
+
+/// creation properties of a dataset, H5P_DEFAULT if it is contiguous
+hid_t h5_get_dset_create_plist(hid_t file_id,
+                               int ndims,
+                               const hsize_t* dims,
+                               hid_t h5_typ,
+                               int filter,
+                               int level,
+                               int shuffle,
+                               int64_t chunk_bytes)
+{
+    if (filter != 0 && h5_get_num_writers(file_id) > 1 && !H5_VERSION_GE(1, 10, 2))
+    {
+        std::cerr << "h5 create dataset: parallel HDF5 before 1.10.2 can't write filtered datasets" << std::endl;
+        filter = 0;
+    }
+    if (ndims == 0 || (filter == 0 && chunk_bytes <= 0))
+    {
+        return H5P_DEFAULT;
+    }
+    // chunks can't be larger than fixed dimensions
+    for (int i = 1; i < ndims; i++)
+    {
+        if (dims[i] == 0)
+        {
+            return H5P_DEFAULT;
+        }
+    }
+    size_t type_size = H5Tget_size(h5_typ);
+    hsize_t target_bytes = chunk_bytes > 0 ? (hsize_t)chunk_bytes : H5_DEFAULT_CHUNK_BYTES;
+    std::vector<hsize_t> chunk_dims =
+        h5_get_create_chunk_dims(ndims, dims, type_size, h5_get_num_writers(file_id), target_bytes);
+
+    hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    CHECK(dcpl_id != -1, "h5 dataset create property create error");
+    herr_t ret = H5Pset_chunk(dcpl_id, ndims, chunk_dims.data());
+    CHECK(ret != -1, "h5 set chunk error");
+    if (filter != 0)
+    {
+        // shuffling bytes of values by significance helps compression of numeric data
+        if (shuffle && type_size > 1)
+        {
+            ret = H5Pset_shuffle(dcpl_id);
+            CHECK(ret != -1, "h5 set shuffle error");
+        }
+        if (!h5_set_filter(dcpl_id, (H5Z_filter_t)filter, level))
+        {
+            std::cerr << "h5 create dataset: filter " << filter << " isn't available, writing uncompressed"
+                      << std::endl;
+            H5Premove_filter(dcpl_id, H5Z_FILTER_ALL);
+        }
+    }
+    // unfilled chunks are written anyway, don't initialize them
+    H5Pset_fill_time(dcpl_id, H5D_FILL_TIME_NEVER);
+    return dcpl_id;
+}
+
+hid_t hpat_h5_create_dset(hid_t file_id,
+                          char* dset_name,
+                          int ndims,
+                          int64_t* counts,
+                          int typ_enum,
+                          int filter,
+                          int level,
+                          int shuffle,
+                          int64_t chunk_bytes)
 {
     // printf("dset_name:%s ndims:%d size:%d typ:%d\n", dset_name, ndims, counts[0], typ_enum);
     // fflush(stdout);
@@ -412,9 +1093,21 @@ hid_t hpat_h5_create_dset(hid_t file_id, char* dset_name, int ndims, int64_t* co
     hid_t dataset_id;
     hid_t filespace;
     hid_t h5_typ = get_h5_typ(typ_enum);
-    filespace = H5Screate_simple(ndims, (const hsize_t*)counts, NULL);
-    dataset_id = H5Dcreate(file_id, dset_name, h5_typ, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    hid_t dcpl_id =
+        h5_get_dset_create_plist(file_id, ndims, (const hsize_t*)counts, h5_typ, filter, level, shuffle, chunk_bytes);
+    std::vector<hsize_t> max_dims(counts, counts + ndims);
+    if (dcpl_id != H5P_DEFAULT)
+    {
+        // chunked datasets can be extended along rows
+        max_dims[0] = H5S_UNLIMITED;
+    }
+    filespace = H5Screate_simple(ndims, (const hsize_t*)counts, max_dims.data());
+    dataset_id = H5Dcreate(file_id, dset_name, h5_typ, filespace, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
     H5Sclose(filespace);
+    if (dcpl_id != H5P_DEFAULT)
+    {
+        H5Pclose(dcpl_id);
+    }
     return dataset_id;
 }
 
@@ -434,30 +1127,8 @@ int hpat_h5_write(
 {
     //printf("dset_id:%s ndims:%d size:%d typ:%d\n", dset_id, ndims, counts[0], typ_enum);
     // fflush(stdout);
-    herr_t ret;
     CHECK(dataset_id != -1, "h5 write invalid dataset_id");
-    hid_t space_id = H5Dget_space(dataset_id);
-    CHECK(space_id != -1, "h5 write get_space error");
-
-    hsize_t* HDF5_start = (hsize_t*)starts;
-    hsize_t* HDF5_count = (hsize_t*)counts;
-
-    //int num_pes;
-    //MPI_Comm_size(MPI_COMM_WORLD, &num_pes);
-    hid_t xfer_plist_id = H5P_DEFAULT;
-    // TODO: enable MPIO after fixing address overflow issues
-    // if(false && is_parallel && num_pes>1)
-    // {
-    //     xfer_plist_id = H5Pcreate(H5P_DATASET_XFER);
-    //     H5Pset_dxpl_mpio(xfer_plist_id, H5FD_MPIO_COLLECTIVE);
-    // }
-
-    ret = H5Sselect_hyperslab(space_id, H5S_SELECT_SET, HDF5_start, NULL, HDF5_count, NULL);
-    CHECK(ret != -1, "h5 write select_hyperslab error");
-    hid_t mem_dataspace = H5Screate_simple((hsize_t)ndims, HDF5_count, NULL);
-    CHECK(mem_dataspace != -1, "h5 write create_simple error");
-    hid_t h5_typ = get_h5_typ(typ_enum);
-    ret = H5Dwrite(dataset_id, h5_typ, mem_dataspace, space_id, xfer_plist_id, out);
+    herr_t ret = h5_transfer_hyperslab(dataset_id, ndims, starts, counts, is_parallel, out, typ_enum, true);
     CHECK(ret != -1, "h5 write call error");
     // XXX fix close properly, refcount dset_id?
     H5Dclose(dataset_id);
@@ -1,17 +1,51 @@
 #include <Python.h>
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <climits>
 #include <cmath>
 #include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #if _MSC_VER >= 1900
 #undef timezone
 #endif
 
+#include "../_distributed.h"
 #include "parquet/arrow/reader.h"
+#include "parquet_reader/hpat_null_bitmap.h"
+#include "_parquet_writer.h"
 using parquet::arrow::FileReader;
 
-typedef std::vector<std::shared_ptr<FileReader>> FileReaderVec;
+// column read into a caller-allocated buffer postponed until pq_read_deferred
+struct pq_column_read
+{
+    int64_t column_idx;
+    uint8_t* out_data;
+    int out_dtype;
+    int64_t start;
+    int64_t count; // -1 for all rows of the dataset
+};
+
+// readers of the dataset files and the column reads to do in one pass over them
+struct FileReaderVec : public std::vector<std::shared_ptr<FileReader>>
+{
+    std::vector<pq_column_read> deferred_reads;
+    // row groups of each file left after pq_add_filter calls, empty if there are no filters
+    std::vector<std::vector<int>> row_groups;
+    // number of row groups and bytes multi-column reads prefetch in the background, 0 disables
+    int prefetch_depth = 0;
+    int64_t prefetch_max_bytes = 0;
+    // readers of parallel reads, every rank has them
+    bool parallel = false;
+    // values categorical reads found outside their categories, see pq_get_num_errors
+    int64_t n_unknown_cats = 0;
+};
 
 // just include parquet reader on Windows since the GCC ABI change issue
 // doesn't exist, and VC linker removes unused lib symbols
@@ -19,11 +53,32 @@ typedef std::vector<std::shared_ptr<FileReader>> FileReaderVec;
 #include <parquet_reader/hpat_parquet_reader.cpp>
 #else
 
-void pq_init_reader(const char* file_name, std::shared_ptr<FileReader>* a_reader);
+void pq_init_reader(const char* file_name,
+                    std::shared_ptr<FileReader>* a_reader,
+                    const std::shared_ptr<parquet::FileMetaData>& metadata = nullptr);
+void pq_get_footer_single_file(std::shared_ptr<FileReader> arrow_reader, std::string* footer);
 int64_t pq_get_size_single_file(std::shared_ptr<FileReader>, int64_t column_idx);
+void pq_get_row_group_sizes_single_file(std::shared_ptr<FileReader>,
+                                        std::vector<int64_t>* rg_rows,
+                                        std::vector<int64_t>* rg_bytes);
 int64_t pq_read_single_file(std::shared_ptr<FileReader>, int64_t column_idx, uint8_t* out, int out_dtype);
-int pq_read_parallel_single_file(
-    std::shared_ptr<FileReader>, int64_t column_idx, uint8_t* out_data, int out_dtype, int64_t start, int64_t count);
+int pq_read_parallel_single_file(std::shared_ptr<FileReader>,
+                                 int64_t column_idx,
+                                 uint8_t* out_data,
+                                 int out_dtype,
+                                 int64_t start,
+                                 int64_t count,
+                                 const std::vector<int>* row_groups = NULL);
+int pq_read_columns_parallel_single_file(std::shared_ptr<FileReader>,
+                                         int64_t n_cols,
+                                         const int64_t* column_idxs,
+                                         uint8_t** out_datas,
+                                         const int* out_dtypes,
+                                         int64_t start,
+                                         int64_t count,
+                                         const std::vector<int>* row_groups = NULL,
+                                         int prefetch_depth = 0,
+                                         int64_t prefetch_max_bytes = 0);
 int64_t pq_read_string_single_file(std::shared_ptr<FileReader>,
                                    int64_t column_idx,
                                    uint32_t** out_offsets,
@@ -31,7 +86,7 @@ int64_t pq_read_string_single_file(std::shared_ptr<FileReader>,
                                    uint8_t** out_nulls,
                                    std::vector<uint32_t>* offset_vec = NULL,
                                    std::vector<uint8_t>* data_vec = NULL,
-                                   std::vector<bool>* null_vec = NULL);
+                                   hpat_null_bitmap* null_vec = NULL);
 int pq_read_string_parallel_single_file(std::shared_ptr<FileReader>,
                                         int64_t column_idx,
                                         uint32_t** out_offsets,
@@ -41,14 +96,34 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader>,
                                         int64_t count,
                                         std::vector<uint32_t>* offset_vec = NULL,
                                         std::vector<uint8_t>* data_vec = NULL,
-                                        std::vector<bool>* null_vec = NULL);
+                                        hpat_null_bitmap* null_vec = NULL,
+                                        const std::vector<int>* row_groups = NULL);
+int64_t pq_read_categorical_single_file(std::shared_ptr<FileReader>,
+                                        int64_t column_idx,
+                                        uint8_t* out_codes,
+                                        int code_size,
+                                        const uint8_t* cat_chars,
+                                        const uint32_t* cat_offsets,
+                                        int64_t n_cats,
+                                        int64_t start,
+                                        int64_t count,
+                                        const std::vector<int>* row_groups = NULL);
+void pq_get_dictionary_single_file(std::shared_ptr<FileReader>, int64_t column_idx, std::vector<std::string>* values);
+void pq_filter_row_groups_single_file(std::shared_ptr<FileReader>,
+                                      int64_t column_idx,
+                                      int op,
+                                      int is_float,
+                                      int64_t int_value,
+                                      double float_value,
+                                      std::vector<int>* row_groups);
 
 #endif // _MSC_VER
 
-FileReaderVec* get_arrow_readers(char* file_name);
+FileReaderVec* get_arrow_readers(char* file_name, int64_t parallel);
 void del_arrow_readers(FileReaderVec* readers);
 
 PyObject* str_list_to_vec(PyObject* self, PyObject* str_list);
+PyObject* pq_get_column_categories(PyObject* self, PyObject* args);
 int64_t pq_get_size(FileReaderVec* readers, int64_t column_idx);
 int64_t pq_read(FileReaderVec* readers, int64_t column_idx, uint8_t* out_data, int out_dtype);
 int pq_read_parallel(
@@ -62,13 +137,56 @@ int pq_read_string_parallel(FileReaderVec* readers,
                             uint8_t** out_nulls,
                             int64_t start,
                             int64_t count);
+int pq_read_parallel_row_groups(
+    FileReaderVec* readers, int64_t column_idx, uint8_t* out_data, int out_dtype, int64_t start, int64_t count);
+int pq_read_string_parallel_row_groups(FileReaderVec* readers,
+                                       int64_t column_idx,
+                                       uint32_t** out_offsets,
+                                       uint8_t** out_data,
+                                       uint8_t** out_nulls,
+                                       int64_t start,
+                                       int64_t count);
+
+int pq_read_columns_parallel(FileReaderVec* readers,
+                             int64_t n_cols,
+                             const int64_t* column_idxs,
+                             uint8_t** out_datas,
+                             const int* out_dtypes,
+                             int64_t start,
+                             int64_t count);
+int64_t pq_defer_read(
+    FileReaderVec* readers, int64_t column_idx, uint8_t* out_data, int out_dtype, int64_t start, int64_t count);
+int pq_read_deferred(FileReaderVec* readers, int row_group_dist, int prefetch_depth, int64_t prefetch_max_bytes);
+int pq_add_filter(
+    FileReaderVec* readers, int64_t column_idx, int op, int is_float, int64_t int_value, double float_value);
+int pq_read_categorical(FileReaderVec* readers,
+                        int64_t column_idx,
+                        uint8_t* out_codes,
+                        int code_size,
+                        const uint8_t* cat_chars,
+                        const uint32_t* cat_offsets,
+                        int64_t n_cats,
+                        int64_t start,
+                        int64_t count);
+int64_t pq_get_num_errors(FileReaderVec* readers);
+void* pq_writer_new(int64_t n_rows);
+void pq_writer_add_column(void* writer, const char* name, int32_t col_type, const uint8_t* data);
+void pq_writer_add_string_column(
+    void* writer, const char* name, const uint32_t* offsets, const uint8_t* chars, const uint8_t* null_bitmap);
+int32_t pq_writer_write(void* writer, const char* path, int32_t rank, int64_t row_group_size, int32_t compression);
+int32_t pq_write_metadata(const char* path, int32_t n_pes);
+int32_t pq_write_clean_dir(const char* path);
+void pq_del_writer(void* writer);
 
-void pack_null_bitmap(uint8_t** out_nulls, std::vector<bool>& null_vec, int64_t n_all_vals);
 
 static PyMethodDef parquet_cpp_methods[] = {{"str_list_to_vec",
                                              str_list_to_vec,
                                              METH_O, // METH_STATIC
                                              "convert Python string list to C++ std vector of strings"},
+                                            {"get_column_categories",
+                                             pq_get_column_categories,
+                                             METH_VARARGS,
+                                             "sorted distinct values of a string column from its dictionary pages"},
                                             {NULL, NULL, 0, NULL}};
 
 PyMODINIT_FUNC PyInit_parquet_cpp(void)
@@ -95,6 +213,22 @@ PyMODINIT_FUNC PyInit_parquet_cpp(void)
     PyObject_SetAttrString(m, "get_size", PyLong_FromVoidPtr((void*)(&pq_get_size)));
     PyObject_SetAttrString(m, "read_string", PyLong_FromVoidPtr((void*)(&pq_read_string)));
     PyObject_SetAttrString(m, "read_string_parallel", PyLong_FromVoidPtr((void*)(&pq_read_string_parallel)));
+    PyObject_SetAttrString(m, "read_parallel_row_groups", PyLong_FromVoidPtr((void*)(&pq_read_parallel_row_groups)));
+    PyObject_SetAttrString(
+        m, "read_string_parallel_row_groups", PyLong_FromVoidPtr((void*)(&pq_read_string_parallel_row_groups)));
+    PyObject_SetAttrString(m, "read_columns_parallel", PyLong_FromVoidPtr((void*)(&pq_read_columns_parallel)));
+    PyObject_SetAttrString(m, "defer_read", PyLong_FromVoidPtr((void*)(&pq_defer_read)));
+    PyObject_SetAttrString(m, "read_deferred", PyLong_FromVoidPtr((void*)(&pq_read_deferred)));
+    PyObject_SetAttrString(m, "add_filter", PyLong_FromVoidPtr((void*)(&pq_add_filter)));
+    PyObject_SetAttrString(m, "read_categorical", PyLong_FromVoidPtr((void*)(&pq_read_categorical)));
+    PyObject_SetAttrString(m, "get_num_errors", PyLong_FromVoidPtr((void*)(&pq_get_num_errors)));
+    PyObject_SetAttrString(m, "writer_new", PyLong_FromVoidPtr((void*)(&pq_writer_new)));
+    PyObject_SetAttrString(m, "writer_add_column", PyLong_FromVoidPtr((void*)(&pq_writer_add_column)));
+    PyObject_SetAttrString(m, "writer_add_string_column", PyLong_FromVoidPtr((void*)(&pq_writer_add_string_column)));
+    PyObject_SetAttrString(m, "writer_write", PyLong_FromVoidPtr((void*)(&pq_writer_write)));
+    PyObject_SetAttrString(m, "write_metadata", PyLong_FromVoidPtr((void*)(&pq_write_metadata)));
+    PyObject_SetAttrString(m, "write_clean_dir", PyLong_FromVoidPtr((void*)(&pq_write_clean_dir)));
+    PyObject_SetAttrString(m, "del_writer", PyLong_FromVoidPtr((void*)(&pq_del_writer)));
 
     return m;
 }
@@ -128,6 +262,31 @@ PyObject* str_list_to_vec(PyObject* self, PyObject* str_list)
     return PyLong_FromVoidPtr((void*)strs_vec);
 }
 
+typedef int (*pq_dist_get_rank_t)();
+typedef int (*pq_dist_get_size_t)();
+typedef void (*pq_bcast_t)(void*, int, int);
+typedef void (*pq_dist_reduce_t)(char*, char*, int, int);
+
+static void* pq_get_transport_symbol(const char* name)
+{
+    void* ptr = nullptr;
+    auto gilstate = PyGILState_Ensure();
+    PyObject* mod = PyImport_ImportModule("hpat.transport_mpi");
+    if (mod != nullptr)
+    {
+        PyObject* obj = PyObject_GetAttrString(mod, name);
+        if (obj != nullptr)
+        {
+            ptr = PyLong_AsVoidPtr(obj);
+            Py_DECREF(obj);
+        }
+        Py_DECREF(mod);
+    }
+    PyErr_Clear();
+    PyGILState_Release(gilstate);
+    return ptr;
+}
+
 std::vector<std::string> get_pq_pieces(char* file_name)
 {
 #define CHECK(expr, msg)                                                                                               \
@@ -184,17 +343,369 @@ std::vector<std::string> get_pq_pieces(char* file_name)
 #undef CHECK
 }
 
-FileReaderVec* get_arrow_readers(char* file_name)
+// ***********************************************************************************
+// Dataset metadata shared by ranks
+//
+// Opening a dataset lists its pieces and parses the footer of each piece, which
+// dominates small reads of datasets with many files when every rank does it. In
+// parallel reads, rank 0 does it alone and broadcasts the serialized footers which
+// the other ranks open the pieces with. Footers are also cached on disk in
+// hpat.config.config_pq_metadata_cache_dir, valid while the size and modification
+// time of their piece don't change, so repeated jobs skip parsing unchanged footers.
+
+// pieces of a dataset and their serialized footers (empty if not read)
+struct pq_dataset_metadata
+{
+    std::vector<std::string> paths;
+    std::vector<std::string> footers;
+    // readers opened while reading footers, NULL for footers read from the cache
+    std::vector<std::shared_ptr<FileReader>> readers;
+};
+
+// footer of a piece in the cache, valid while the piece's size and mtime are the same
+struct pq_metadata_cache_entry
+{
+    int64_t size = -1;
+    int64_t mtime = -1;
+    std::string footer;
+};
+
+#define PQ_METADATA_CACHE_MAGIC "HPATPQM1"
+
+static void pq_put_int64(std::string& out, int64_t value)
+{
+    out.append((const char*)&value, sizeof(int64_t));
+}
+
+static void pq_put_str(std::string& out, const std::string& value)
+{
+    pq_put_int64(out, value.size());
+    out.append(value);
+}
+
+// read values written by pq_put_* at pos, false if the data ends before
+static bool pq_get_int64(const std::string& in, size_t& pos, int64_t* value)
+{
+    if (in.size() - pos < sizeof(int64_t))
+    {
+        return false;
+    }
+    memcpy(value, in.data() + pos, sizeof(int64_t));
+    pos += sizeof(int64_t);
+    return true;
+}
+
+static bool pq_get_str(const std::string& in, size_t& pos, std::string* value)
+{
+    int64_t size;
+    if (!pq_get_int64(in, pos, &size) || size < 0 || (uint64_t)size > in.size() - pos)
+    {
+        return false;
+    }
+    value->assign(in, pos, size);
+    pos += size;
+    return true;
+}
+
+/// number of pieces, then path and footer of each piece
+static std::string pq_serialize_dataset_metadata(const pq_dataset_metadata& metadata)
+{
+    std::string data;
+    pq_put_int64(data, metadata.paths.size());
+    for (size_t i = 0; i < metadata.paths.size(); i++)
+    {
+        pq_put_str(data, metadata.paths[i]);
+        pq_put_str(data, metadata.footers[i]);
+    }
+    return data;
+}
+
+static bool pq_deserialize_dataset_metadata(const std::string& data, pq_dataset_metadata& metadata)
+{
+    size_t pos = 0;
+    int64_t n_pieces;
+    if (!pq_get_int64(data, pos, &n_pieces) || n_pieces < 0)
+    {
+        return false;
+    }
+    metadata.paths.resize(n_pieces);
+    metadata.footers.resize(n_pieces);
+    metadata.readers.assign(n_pieces, nullptr);
+    for (int64_t i = 0; i < n_pieces; i++)
+    {
+        if (!pq_get_str(data, pos, &metadata.paths[i]) || !pq_get_str(data, pos, &metadata.footers[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// hpat.config.config_pq_metadata_cache_dir, empty if the cache is disabled
+static std::string pq_get_metadata_cache_dir()
+{
+    std::string cache_dir;
+    auto gilstate = PyGILState_Ensure();
+    PyObject* mod = PyImport_ImportModule("hpat.config");
+    if (mod != nullptr)
+    {
+        PyObject* obj = PyObject_GetAttrString(mod, "config_pq_metadata_cache_dir");
+        if (obj != nullptr)
+        {
+            const char* c_str = PyUnicode_Check(obj) ? PyUnicode_AsUTF8(obj) : nullptr;
+            if (c_str != nullptr)
+            {
+                cache_dir = c_str;
+            }
+            Py_DECREF(obj);
+        }
+        Py_DECREF(mod);
+    }
+    PyErr_Clear();
+    PyGILState_Release(gilstate);
+    return cache_dir;
+}
+
+/// cache file of a dataset, named after a hash of its absolute path
+static std::string pq_metadata_cache_path(const std::string& cache_dir, const std::string& file_name)
+{
+    boost::filesystem::path abs_path = boost::filesystem::absolute(file_name);
+    char cache_name[64];
+    snprintf(cache_name,
+             sizeof(cache_name),
+             "hpat_pq_%016llx.meta",
+             (unsigned long long)std::hash<std::string>()(abs_path.string()));
+    return (boost::filesystem::path(cache_dir) / cache_name).string();
+}
+
+static bool pq_get_piece_stat(const std::string& path, int64_t* size, int64_t* mtime)
+{
+    boost::system::error_code ec;
+    *size = boost::filesystem::file_size(path, ec);
+    if (ec)
+    {
+        return false;
+    }
+    *mtime = boost::filesystem::last_write_time(path, ec);
+    return !ec;
+}
+
+/// cache entries by piece path, empty if the cache file doesn't exist or is invalid
+static std::unordered_map<std::string, pq_metadata_cache_entry> pq_read_metadata_cache(const std::string& cache_path)
+{
+    std::unordered_map<std::string, pq_metadata_cache_entry> entries;
+    std::ifstream cache_file(cache_path, std::ios::binary);
+    if (!cache_file)
+    {
+        return entries;
+    }
+    std::string data((std::istreambuf_iterator<char>(cache_file)), std::istreambuf_iterator<char>());
+    size_t pos = strlen(PQ_METADATA_CACHE_MAGIC);
+    int64_t n_pieces;
+    if (data.compare(0, pos, PQ_METADATA_CACHE_MAGIC) != 0 || !pq_get_int64(data, pos, &n_pieces))
+    {
+        return entries;
+    }
+    for (int64_t i = 0; i < n_pieces; i++)
+    {
+        std::string path;
+        pq_metadata_cache_entry entry;
+        if (!pq_get_str(data, pos, &path) || !pq_get_int64(data, pos, &entry.size) ||
+            !pq_get_int64(data, pos, &entry.mtime) || !pq_get_str(data, pos, &entry.footer))
+        {
+            entries.clear();
+            return entries;
+        }
+        entries[path] = std::move(entry);
+    }
+    return entries;
+}
+
+static void pq_write_metadata_cache(const std::string& cache_path,
+                                    const std::vector<std::string>& paths,
+                                    const std::vector<pq_metadata_cache_entry>& entries)
+{
+    std::string data(PQ_METADATA_CACHE_MAGIC);
+    int64_t n_pieces = 0;
+    std::string pieces_data;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        // pieces that couldn't be stat'ed or read aren't cached
+        if (entries[i].mtime == -1 || entries[i].footer.empty())
+        {
+            continue;
+        }
+        pq_put_str(pieces_data, paths[i]);
+        pq_put_int64(pieces_data, entries[i].size);
+        pq_put_int64(pieces_data, entries[i].mtime);
+        pq_put_str(pieces_data, entries[i].footer);
+        n_pieces++;
+    }
+    pq_put_int64(data, n_pieces);
+    data.append(pieces_data);
+
+    // write a temporary file and rename it so that concurrent jobs never read a partial cache
+    boost::system::error_code ec;
+    boost::filesystem::path cache_file_path(cache_path);
+    boost::filesystem::create_directories(cache_file_path.parent_path(), ec);
+    boost::filesystem::path tmp_path = cache_file_path;
+    tmp_path += boost::filesystem::unique_path(".%%%%-%%%%-%%%%").string();
+    {
+        std::ofstream tmp_file(tmp_path.string(), std::ios::binary);
+        tmp_file.write(data.data(), data.size());
+        if (!tmp_file)
+        {
+            std::cerr << "cannot write Parquet metadata cache " << tmp_path.string() << std::endl;
+            tmp_file.close();
+            boost::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    boost::filesystem::rename(tmp_path, cache_file_path, ec);
+    if (ec)
+    {
+        boost::filesystem::remove(tmp_path, ec);
+    }
+}
+
+/**
+ * List the pieces of a dataset and get their footers, from the metadata cache if
+ * enabled. Pieces whose footers aren't cached are opened and their footers are read
+ * only if read_footers is set or the cache is enabled (to update it).
+ **/
+static void pq_get_dataset_metadata(char* file_name, bool read_footers, pq_dataset_metadata& metadata)
+{
+    metadata.paths = get_pq_pieces(file_name);
+    size_t n_pieces = metadata.paths.size();
+    metadata.footers.assign(n_pieces, std::string());
+    metadata.readers.assign(n_pieces, nullptr);
+
+    std::string cache_dir = pq_get_metadata_cache_dir();
+    bool use_cache = !cache_dir.empty() && std::string(file_name).find("hdfs://") != 0;
+    if (!read_footers && !use_cache)
+    {
+        return;
+    }
+
+    std::string cache_path;
+    std::unordered_map<std::string, pq_metadata_cache_entry> cache;
+    if (use_cache)
+    {
+        cache_path = pq_metadata_cache_path(cache_dir, file_name);
+        cache = pq_read_metadata_cache(cache_path);
+    }
+    // pieces removed from the dataset are dropped from the cache too
+    bool cache_changed = cache.size() != n_pieces;
+    std::vector<pq_metadata_cache_entry> entries(n_pieces);
+    for (size_t i = 0; i < n_pieces; i++)
+    {
+        const std::string& path = metadata.paths[i];
+        pq_metadata_cache_entry& entry = entries[i];
+        if (use_cache && !pq_get_piece_stat(path, &entry.size, &entry.mtime))
+        {
+            entry.mtime = -1;
+        }
+        auto cached = cache.find(path);
+        if (entry.mtime != -1 && cached != cache.end() && cached->second.size == entry.size &&
+            cached->second.mtime == entry.mtime)
+        {
+            metadata.footers[i] = cached->second.footer;
+            entry.footer = std::move(cached->second.footer);
+            continue;
+        }
+        pq_init_reader(path.c_str(), &metadata.readers[i]);
+        if (metadata.readers[i] != nullptr)
+        {
+            pq_get_footer_single_file(metadata.readers[i], &metadata.footers[i]);
+            entry.footer = metadata.footers[i];
+        }
+        cache_changed = true;
+    }
+    if (use_cache && cache_changed)
+    {
+        pq_write_metadata_cache(cache_path, metadata.paths, entries);
+    }
+}
+
+/// send the dataset metadata of rank 0 to all ranks
+static void pq_bcast_dataset_metadata(pq_dataset_metadata& metadata, int rank, pq_bcast_t bcast)
+{
+    std::string data;
+    if (rank == 0)
+    {
+        data = pq_serialize_dataset_metadata(metadata);
+    }
+    int64_t size = data.size();
+    bcast(&size, 1, HPAT_CTypes::INT64);
+    data.resize(size);
+    // MPI counts are int
+    for (int64_t pos = 0; pos < size; pos += INT_MAX)
+    {
+        bcast(&data[pos], (int)std::min(size - pos, (int64_t)INT_MAX), HPAT_CTypes::UINT8);
+    }
+    if (rank != 0 && !pq_deserialize_dataset_metadata(data, metadata))
+    {
+        std::cerr << "invalid Parquet dataset metadata received" << std::endl;
+        metadata = pq_dataset_metadata();
+    }
+}
+
+FileReaderVec* get_arrow_readers(char* file_name, int64_t parallel)
 {
     FileReaderVec* readers = new FileReaderVec();
 
-    std::vector<std::string> all_files = get_pq_pieces(file_name);
-    for (const auto& inner_file : all_files)
+    // only parallel reads are collective, sequential ones could run on some ranks only
+    int rank = 0;
+    pq_bcast_t bcast = nullptr;
+    if (parallel)
+    {
+        pq_dist_get_rank_t get_rank = (pq_dist_get_rank_t)pq_get_transport_symbol("hpat_dist_get_rank");
+        pq_dist_get_size_t get_size = (pq_dist_get_size_t)pq_get_transport_symbol("hpat_dist_get_size");
+        bcast = (pq_bcast_t)pq_get_transport_symbol("c_bcast");
+        if (get_rank == nullptr || get_size == nullptr || get_size() == 1)
+        {
+            bcast = nullptr;
+        }
+        if (bcast != nullptr)
+        {
+            rank = get_rank();
+        }
+    }
+
+    pq_dataset_metadata metadata;
+    if (rank == 0)
+    {
+        pq_get_dataset_metadata(file_name, bcast != nullptr, metadata);
+    }
+    if (bcast != nullptr)
+    {
+        pq_bcast_dataset_metadata(metadata, rank, bcast);
+    }
+
+    for (size_t i = 0; i < metadata.paths.size(); i++)
     {
-        std::shared_ptr<FileReader> arrow_reader;
-        pq_init_reader(inner_file.c_str(), &arrow_reader);
+        std::shared_ptr<FileReader> arrow_reader = metadata.readers[i];
+        if (arrow_reader == nullptr)
+        {
+            std::shared_ptr<parquet::FileMetaData> file_metadata;
+            if (!metadata.footers[i].empty())
+            {
+                uint32_t footer_len = metadata.footers[i].size();
+                try
+                {
+                    file_metadata = parquet::FileMetaData::Make(metadata.footers[i].data(), &footer_len);
+                }
+                catch (const std::exception&)
+                {
+                    // parse the footer of the file instead
+                    file_metadata = nullptr;
+                }
+            }
+            pq_init_reader(metadata.paths[i].c_str(), &arrow_reader, file_metadata);
+        }
         readers->push_back(arrow_reader);
     }
+    readers->parallel = bcast != nullptr;
 
     return readers;
 }
@@ -205,6 +716,58 @@ void del_arrow_readers(FileReaderVec* readers)
     return;
 }
 
+/// row groups of a file to read, NULL if all
+static const std::vector<int>* pq_file_row_groups(FileReaderVec* readers, size_t file_ind)
+{
+    return readers->row_groups.empty() ? NULL : &readers->row_groups[file_ind];
+}
+
+/// number of rows of a file to read, only the row groups left by filters are counted
+static int64_t pq_file_size(FileReaderVec* readers, size_t file_ind, int64_t column_idx)
+{
+    const std::vector<int>* row_groups = pq_file_row_groups(readers, file_ind);
+    if (row_groups == NULL)
+    {
+        return pq_get_size_single_file(readers->at(file_ind), column_idx);
+    }
+    std::vector<int64_t> rg_rows;
+    std::vector<int64_t> rg_bytes;
+    pq_get_row_group_sizes_single_file(readers->at(file_ind), &rg_rows, &rg_bytes);
+    int64_t size = 0;
+    for (int row_group_index : *row_groups)
+    {
+        size += rg_rows[row_group_index];
+    }
+    return size;
+}
+
+int pq_add_filter(
+    FileReaderVec* readers, int64_t column_idx, int op, int is_float, int64_t int_value, double float_value)
+{
+    if (readers->row_groups.empty())
+    {
+        for (size_t i = 0; i < readers->size(); i++)
+        {
+            std::vector<int64_t> rg_rows;
+            std::vector<int64_t> rg_bytes;
+            pq_get_row_group_sizes_single_file(readers->at(i), &rg_rows, &rg_bytes);
+            std::vector<int> row_groups(rg_rows.size());
+            for (size_t j = 0; j < rg_rows.size(); j++)
+            {
+                row_groups[j] = j;
+            }
+            readers->row_groups.push_back(row_groups);
+        }
+    }
+    // metadata is the same on all ranks so they all keep the same row groups
+    for (size_t i = 0; i < readers->size(); i++)
+    {
+        pq_filter_row_groups_single_file(
+            readers->at(i), column_idx, op, is_float, int_value, float_value, &readers->row_groups[i]);
+    }
+    return 0;
+}
+
 int64_t pq_get_size(FileReaderVec* readers, int64_t column_idx)
 {
     if (readers->size() == 0)
@@ -219,7 +782,7 @@ int64_t pq_get_size(FileReaderVec* readers, int64_t column_idx)
         int64_t ret = 0;
         for (size_t i = 0; i < readers->size(); i++)
         {
-            ret += pq_get_size_single_file(readers->at(i), column_idx);
+            ret += pq_file_size(readers, i, column_idx);
         }
 
         // std::cout << "total pq dir size: " << ret << '\n';
@@ -227,7 +790,7 @@ int64_t pq_get_size(FileReaderVec* readers, int64_t column_idx)
     }
     else
     {
-        return pq_get_size_single_file(readers->at(0), column_idx);
+        return pq_file_size(readers, 0, column_idx);
     }
     return 0;
 }
@@ -240,6 +803,14 @@ int64_t pq_read(FileReaderVec* readers, int64_t column_idx, uint8_t* out_data, i
         return 0;
     }
 
+    if (!readers->row_groups.empty())
+    {
+        // only the row groups left by filters
+        int64_t n_rows = pq_get_size(readers, column_idx);
+        pq_read_parallel(readers, column_idx, out_data, out_dtype, 0, n_rows);
+        return n_rows * pq_type_sizes[out_dtype];
+    }
+
     if (readers->size() > 1)
     {
         // std::cout << "pq path is dir" << '\n';
@@ -284,12 +855,12 @@ int pq_read_parallel(
 
         // skip whole files if no need to read any rows
         int file_ind = 0;
-        int64_t file_size = pq_get_size_single_file(readers->at(0), column_idx);
+        int64_t file_size = pq_file_size(readers, 0, column_idx);
         while (start >= file_size)
         {
             start -= file_size;
             file_ind++;
-            file_size = pq_get_size_single_file(readers->at(file_ind), column_idx);
+            file_size = pq_file_size(readers, file_ind, column_idx);
         }
 
         int dtype_size = pq_type_sizes[out_dtype];
@@ -300,15 +871,20 @@ int pq_read_parallel(
         while (read_rows < count)
         {
             int64_t rows_to_read = std::min(count - read_rows, file_size - start);
-            pq_read_parallel_single_file(
-                readers->at(file_ind), column_idx, out_data + read_rows * dtype_size, out_dtype, start, rows_to_read);
+            pq_read_parallel_single_file(readers->at(file_ind),
+                                         column_idx,
+                                         out_data + read_rows * dtype_size,
+                                         out_dtype,
+                                         start,
+                                         rows_to_read,
+                                         pq_file_row_groups(readers, file_ind));
             read_rows += rows_to_read;
             start = 0; // start becomes 0 after reading non-empty first chunk
             file_ind++;
             // std::cout << "next file: " << all_files[file_ind] << '\n';
             if (read_rows < count)
             {
-                file_size = pq_get_size_single_file(readers->at(file_ind), column_idx);
+                file_size = pq_file_size(readers, file_ind, column_idx);
             }
         }
         return 0;
@@ -316,7 +892,8 @@ int pq_read_parallel(
     }
     else
     {
-        return pq_read_parallel_single_file(readers->at(0), column_idx, out_data, out_dtype, start, count);
+        return pq_read_parallel_single_file(
+            readers->at(0), column_idx, out_data, out_dtype, start, count, pq_file_row_groups(readers, 0));
     }
     return 0;
 }
@@ -330,13 +907,21 @@ int pq_read_string(
         return 0;
     }
 
+    if (!readers->row_groups.empty())
+    {
+        // only the row groups left by filters
+        int64_t n_rows = pq_get_size(readers, column_idx);
+        pq_read_string_parallel(readers, column_idx, out_offsets, out_data, out_nulls, 0, n_rows);
+        return n_rows;
+    }
+
     if (readers->size() > 1)
     {
         // std::cout << "pq path is dir" << '\n';
 
         std::vector<uint32_t> offset_vec;
         std::vector<uint8_t> data_vec;
-        std::vector<bool> null_vec;
+        hpat_null_bitmap null_vec;
         int32_t last_offset = 0;
         int64_t n_all_vals = 0;
         for (size_t i = 0; i < readers->size(); i++)
@@ -364,7 +949,7 @@ int pq_read_string(
 
         memcpy(*out_offsets, offset_vec.data(), offset_vec.size() * sizeof(uint32_t));
         memcpy(*out_data, data_vec.data(), data_vec.size());
-        pack_null_bitmap(out_nulls, null_vec, n_all_vals);
+        null_vec.pack(out_nulls, n_all_vals);
 
         // for(int i=0; i<offset_vec.size(); i++)
         //     std::cout << (*out_offsets)[i] << ' ';
@@ -402,18 +987,18 @@ int pq_read_string_parallel(FileReaderVec* readers,
 
         // skip whole files if no need to read any rows
         int file_ind = 0;
-        int64_t file_size = pq_get_size_single_file(readers->at(0), column_idx);
+        int64_t file_size = pq_file_size(readers, 0, column_idx);
         while (start >= file_size)
         {
             start -= file_size;
             file_ind++;
-            file_size = pq_get_size_single_file(readers->at(file_ind), column_idx);
+            file_size = pq_file_size(readers, file_ind, column_idx);
         }
 
         int64_t n_all_vals = 0;
         std::vector<uint32_t> offset_vec;
         std::vector<uint8_t> data_vec;
-        std::vector<bool> null_vec;
+        hpat_null_bitmap null_vec;
 
         // read data
         int64_t last_offset = 0;
@@ -432,7 +1017,8 @@ int pq_read_string_parallel(FileReaderVec* readers,
                                                     rows_to_read,
                                                     &offset_vec,
                                                     &data_vec,
-                                                    &null_vec);
+                                                    &null_vec,
+                                                    pq_file_row_groups(readers, file_ind));
 
                 int size = offset_vec.size();
                 for (int64_t i = 1; i <= rows_to_read + 1; i++)
@@ -449,7 +1035,7 @@ int pq_read_string_parallel(FileReaderVec* readers,
             file_ind++;
             if (read_rows < count)
             {
-                file_size = pq_get_size_single_file(readers->at(file_ind), column_idx);
+                file_size = pq_file_size(readers, file_ind, column_idx);
             }
         }
         offset_vec.push_back(last_offset);
@@ -459,13 +1045,602 @@ int pq_read_string_parallel(FileReaderVec* readers,
 
         memcpy(*out_offsets, offset_vec.data(), offset_vec.size() * sizeof(uint32_t));
         memcpy(*out_data, data_vec.data(), data_vec.size());
-        pack_null_bitmap(out_nulls, null_vec, n_all_vals);
+        null_vec.pack(out_nulls, n_all_vals);
         return n_all_vals;
     }
     else
     {
-        return pq_read_string_parallel_single_file(
-            readers->at(0), column_idx, out_offsets, out_data, out_nulls, start, count);
+        return pq_read_string_parallel_single_file(readers->at(0),
+                                                   column_idx,
+                                                   out_offsets,
+                                                   out_data,
+                                                   out_nulls,
+                                                   start,
+                                                   count,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL,
+                                                   pq_file_row_groups(readers, 0));
     }
     return 0;
 }
+
+/**
+ * Read rows [start, start+count) of a string column as categorical codes of code_size bytes.
+ * Categories are given as characters and offsets (n_cats+1 values), nulls are -1.
+ * Values not in the categories are -1 too and counted for pq_get_num_errors.
+ **/
+int pq_read_categorical(FileReaderVec* readers,
+                        int64_t column_idx,
+                        uint8_t* out_codes,
+                        int code_size,
+                        const uint8_t* cat_chars,
+                        const uint32_t* cat_offsets,
+                        int64_t n_cats,
+                        int64_t start,
+                        int64_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    if (readers->size() == 0)
+    {
+        printf("empty parquet dataset\n");
+        return 0;
+    }
+
+    // skip whole files if no need to read any rows
+    size_t file_ind = 0;
+    int64_t file_size = pq_file_size(readers, 0, column_idx);
+    while (start >= file_size)
+    {
+        start -= file_size;
+        file_ind++;
+        file_size = pq_file_size(readers, file_ind, column_idx);
+    }
+
+    int64_t read_rows = 0;
+    while (read_rows < count)
+    {
+        int64_t rows_to_read = std::min(count - read_rows, file_size - start);
+        readers->n_unknown_cats += pq_read_categorical_single_file(readers->at(file_ind),
+                                                                   column_idx,
+                                                                   out_codes + read_rows * code_size,
+                                                                   code_size,
+                                                                   cat_chars,
+                                                                   cat_offsets,
+                                                                   n_cats,
+                                                                   start,
+                                                                   rows_to_read,
+                                                                   pq_file_row_groups(readers, file_ind));
+        read_rows += rows_to_read;
+        start = 0; // start becomes 0 after reading non-empty first chunk
+        file_ind++;
+        if (read_rows < count)
+        {
+            file_size = pq_file_size(readers, file_ind, column_idx);
+        }
+    }
+    return 0;
+}
+
+/// number of values categorical reads found outside their categories, summed over the ranks of
+/// parallel reads so that all of them fail together
+int64_t pq_get_num_errors(FileReaderVec* readers)
+{
+    int64_t n_errors = readers->n_unknown_cats;
+    if (readers->parallel)
+    {
+        pq_dist_reduce_t reduce = (pq_dist_reduce_t)pq_get_transport_symbol("hpat_dist_reduce");
+        if (reduce != nullptr)
+        {
+            reduce(reinterpret_cast<char*>(&readers->n_unknown_cats),
+                   reinterpret_cast<char*>(&n_errors),
+                   HPAT_ReduceOps::SUM,
+                   HPAT_CTypes::INT64);
+        }
+    }
+    return n_errors;
+}
+
+/**
+ * Categories of a string column at compile time: its distinct values in order of first
+ * appearance (like Pandas categories of the data) taken from the dictionary pages of the
+ * dataset files, so the column isn't decoded for dictionary encoded files. Returns a list of str.
+ **/
+PyObject* pq_get_column_categories(PyObject* self, PyObject* args)
+{
+    char* file_name;
+    long long column_idx;
+    if (!PyArg_ParseTuple(args, "sL", &file_name, &column_idx))
+    {
+        return NULL;
+    }
+
+    std::vector<std::string> values;
+    FileReaderVec* readers = get_arrow_readers(file_name, 0);
+    try
+    {
+        for (auto& reader : *readers)
+        {
+            pq_get_dictionary_single_file(reader, column_idx, &values);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        del_arrow_readers(readers);
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+    del_arrow_readers(readers);
+
+    // the dictionaries of the row groups in order, each value where it first appears
+    std::unordered_set<std::string> seen;
+    size_t n_values = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (seen.insert(values[i]).second)
+        {
+            if (n_values != i)
+            {
+                values[n_values] = std::move(values[i]);
+            }
+            n_values++;
+        }
+    }
+    values.resize(n_values);
+
+    PyObject* categories = PyList_New(values.size());
+    if (categories == NULL)
+    {
+        return NULL;
+    }
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        PyObject* value = PyUnicode_DecodeUTF8(values[i].data(), values[i].size(), NULL);
+        if (value == NULL)
+        {
+            Py_DECREF(categories);
+            return NULL;
+        }
+        PyList_SET_ITEM(categories, i, value);
+    }
+    return categories;
+}
+
+// ***********************************************************************************
+// Row-group-level distribution of parallel reads
+//
+// Instead of reading a row range, which makes ranks decode the row groups at their
+// range boundaries both, each rank reads consecutive whole row groups (balanced by
+// byte size). The rows are then shuffled to the 1D block layout expected by the
+// caller (start and count of this rank).
+
+typedef void (*pq_alltoallv_t)(void*, void*, int64_t*, int64_t*, int64_t*, int64_t*, int);
+
+struct pq_row_group_plan
+{
+    int rank;
+    int n_pes;
+    pq_alltoallv_t alltoallv;
+    std::vector<int64_t> rank_starts; // first global row of the row groups of each rank, and the total rows
+    std::vector<int64_t> send_rows;   // rows of our row groups going to each rank
+    std::vector<int64_t> recv_rows;   // rows of our 1D block coming from each rank
+};
+
+/**
+ * Assign consecutive row groups of the dataset to ranks balancing their byte size and
+ * compute the row counts to shuffle to the 1D block layout. Depends on metadata only so
+ * all ranks agree on the plan.
+ *
+ * @return     false if the plan isn't applicable: no MPI transport or a single rank
+ **/
+static bool pq_get_row_group_plan(FileReaderVec* readers, int64_t start, int64_t count, pq_row_group_plan& plan)
+{
+    pq_dist_get_rank_t get_rank = (pq_dist_get_rank_t)pq_get_transport_symbol("hpat_dist_get_rank");
+    pq_dist_get_size_t get_size = (pq_dist_get_size_t)pq_get_transport_symbol("hpat_dist_get_size");
+    plan.alltoallv = (pq_alltoallv_t)pq_get_transport_symbol("c_alltoallv");
+    if (get_rank == nullptr || get_size == nullptr || plan.alltoallv == nullptr || readers->size() == 0)
+    {
+        return false;
+    }
+    plan.rank = get_rank();
+    plan.n_pes = get_size();
+    if (plan.n_pes == 1)
+    {
+        return false;
+    }
+
+    std::vector<int64_t> rg_rows;
+    std::vector<int64_t> rg_bytes;
+    for (size_t i = 0; i < readers->size(); i++)
+    {
+        std::vector<int64_t> file_rg_rows;
+        std::vector<int64_t> file_rg_bytes;
+        pq_get_row_group_sizes_single_file(readers->at(i), &file_rg_rows, &file_rg_bytes);
+        const std::vector<int>* row_groups = pq_file_row_groups(readers, i);
+        int64_t n_row_groups = row_groups == NULL ? file_rg_rows.size() : row_groups->size();
+        for (int64_t j = 0; j < n_row_groups; j++)
+        {
+            int row_group_index = row_groups == NULL ? j : (*row_groups)[j];
+            rg_rows.push_back(file_rg_rows[row_group_index]);
+            rg_bytes.push_back(file_rg_bytes[row_group_index]);
+        }
+    }
+    double total_bytes = 0;
+    for (size_t i = 0; i < rg_bytes.size(); i++)
+    {
+        total_bytes += rg_bytes[i];
+    }
+
+    // a row group goes to the rank whose byte range contains its middle byte
+    plan.rank_starts.assign(plan.n_pes + 1, 0);
+    int64_t row = 0;
+    double curr_bytes = 0;
+    int last_rank = 0;
+    for (size_t i = 0; i < rg_rows.size(); i++)
+    {
+        int owner = total_bytes == 0 ? 0 : (int)((curr_bytes + rg_bytes[i] / 2.0) * plan.n_pes / total_bytes);
+        owner = std::min(owner, plan.n_pes - 1);
+        while (last_rank < owner)
+        {
+            plan.rank_starts[++last_rank] = row;
+        }
+        row += rg_rows[i];
+        curr_bytes += rg_bytes[i];
+    }
+    while (last_rank < plan.n_pes)
+    {
+        plan.rank_starts[++last_rank] = row;
+    }
+
+    const int64_t total_rows = row;
+    const int64_t own_start = plan.rank_starts[plan.rank];
+    const int64_t own_end = plan.rank_starts[plan.rank + 1];
+    plan.send_rows.assign(plan.n_pes, 0);
+    plan.recv_rows.assign(plan.n_pes, 0);
+    for (int i = 0; i < plan.n_pes; i++)
+    {
+        int64_t pe_start = hpat_dist_get_start(total_rows, plan.n_pes, i);
+        int64_t pe_end = hpat_dist_get_end(total_rows, plan.n_pes, i);
+        plan.send_rows[i] = std::max((int64_t)0, std::min(own_end, pe_end) - std::max(own_start, pe_start));
+        plan.recv_rows[i] = std::max((int64_t)0,
+                                     std::min(start + count, plan.rank_starts[i + 1]) -
+                                         std::max(start, plan.rank_starts[i]));
+    }
+    return true;
+}
+
+/// exchange rows of elem_size bytes according to send_rows and recv_rows (in rank order)
+static void pq_alltoallv_rows(const pq_row_group_plan& plan,
+                              const void* send_data,
+                              void* recv_data,
+                              const std::vector<int64_t>& send_rows,
+                              const std::vector<int64_t>& recv_rows,
+                              int64_t elem_size)
+{
+    std::vector<int64_t> send_counts(plan.n_pes);
+    std::vector<int64_t> recv_counts(plan.n_pes);
+    std::vector<int64_t> send_disp(plan.n_pes, 0);
+    std::vector<int64_t> recv_disp(plan.n_pes, 0);
+    for (int i = 0; i < plan.n_pes; i++)
+    {
+        send_counts[i] = send_rows[i] * elem_size;
+        recv_counts[i] = recv_rows[i] * elem_size;
+        if (i > 0)
+        {
+            send_disp[i] = send_disp[i - 1] + send_counts[i - 1];
+            recv_disp[i] = recv_disp[i - 1] + recv_counts[i - 1];
+        }
+    }
+    plan.alltoallv((void*)send_data,
+                   recv_data,
+                   send_counts.data(),
+                   recv_counts.data(),
+                   send_disp.data(),
+                   recv_disp.data(),
+                   HPAT_CTypes::UINT8);
+}
+
+int pq_read_parallel_row_groups(
+    FileReaderVec* readers, int64_t column_idx, uint8_t* out_data, int out_dtype, int64_t start, int64_t count)
+{
+    int dtype_size = pq_type_sizes[out_dtype];
+    pq_row_group_plan plan;
+    if (!pq_get_row_group_plan(readers, start, count, plan))
+    {
+        return pq_read_parallel(readers, column_idx, out_data, out_dtype, start, count);
+    }
+
+    // row groups of this rank are read whole, none of their rows are skipped
+    int64_t own_rows = plan.rank_starts[plan.rank + 1] - plan.rank_starts[plan.rank];
+    std::vector<uint8_t> own_data(own_rows * dtype_size);
+    pq_read_parallel(readers, column_idx, own_data.data(), out_dtype, plan.rank_starts[plan.rank], own_rows);
+
+    pq_alltoallv_rows(plan, own_data.data(), out_data, plan.send_rows, plan.recv_rows, dtype_size);
+    return 0;
+}
+
+int pq_read_string_parallel_row_groups(FileReaderVec* readers,
+                                       int64_t column_idx,
+                                       uint32_t** out_offsets,
+                                       uint8_t** out_data,
+                                       uint8_t** out_nulls,
+                                       int64_t start,
+                                       int64_t count)
+{
+    // per row: string length and validity, characters are exchanged separately
+    pq_row_group_plan plan;
+    if (!pq_get_row_group_plan(readers, start, count, plan))
+    {
+        return pq_read_string_parallel(readers, column_idx, out_offsets, out_data, out_nulls, start, count);
+    }
+
+    int64_t own_rows = plan.rank_starts[plan.rank + 1] - plan.rank_starts[plan.rank];
+    uint32_t* own_offsets = NULL;
+    uint8_t* own_chars = NULL;
+    uint8_t* own_nulls = NULL;
+    if (own_rows > 0)
+    {
+        pq_read_string_parallel(
+            readers, column_idx, &own_offsets, &own_chars, &own_nulls, plan.rank_starts[plan.rank], own_rows);
+    }
+
+    std::vector<uint32_t> own_lens(own_rows);
+    std::vector<uint8_t> own_valid(own_rows);
+    for (int64_t i = 0; i < own_rows; i++)
+    {
+        own_lens[i] = own_offsets[i + 1] - own_offsets[i];
+        own_valid[i] = own_nulls == NULL || ((own_nulls[i / 8] >> (i % 8)) & 1);
+    }
+    std::vector<uint32_t> lens(count);
+    std::vector<uint8_t> valid(count);
+    pq_alltoallv_rows(plan, own_lens.data(), lens.data(), plan.send_rows, plan.recv_rows, sizeof(uint32_t));
+    pq_alltoallv_rows(plan, own_valid.data(), valid.data(), plan.send_rows, plan.recv_rows, sizeof(uint8_t));
+
+    // characters going to and coming from each rank
+    std::vector<int64_t> send_chars(plan.n_pes, 0);
+    std::vector<int64_t> recv_chars(plan.n_pes, 0);
+    int64_t row = 0;
+    int64_t recv_row = 0;
+    for (int i = 0; i < plan.n_pes; i++)
+    {
+        send_chars[i] = own_offsets == NULL ? 0 : own_offsets[row + plan.send_rows[i]] - own_offsets[row];
+        row += plan.send_rows[i];
+        for (int64_t j = 0; j < plan.recv_rows[i]; j++)
+        {
+            recv_chars[i] += lens[recv_row + j];
+        }
+        recv_row += plan.recv_rows[i];
+    }
+
+    *out_offsets = new uint32_t[count + 1];
+    (*out_offsets)[0] = 0;
+    for (int64_t i = 0; i < count; i++)
+    {
+        (*out_offsets)[i + 1] = (*out_offsets)[i] + lens[i];
+    }
+    *out_data = new uint8_t[(*out_offsets)[count]];
+    pq_alltoallv_rows(plan, own_chars, *out_data, send_chars, recv_chars, 1);
+
+    int64_t n_null_bytes = (count + 7) / 8;
+    *out_nulls = new uint8_t[n_null_bytes];
+    memset(*out_nulls, 0, n_null_bytes);
+    for (int64_t i = 0; i < count; i++)
+    {
+        if (valid[i])
+        {
+            (*out_nulls)[i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+
+    delete[] own_offsets;
+    delete[] own_chars;
+    delete[] own_nulls;
+    return 0;
+}
+
+// ***********************************************************************************
+// Multi-column reads
+//
+// Reading columns one at a time decodes the metadata and issues the I/O of every row
+// group once per column. The compiler generates one read call per column, so these
+// calls only record the column and its output buffer (pq_defer_read) and
+// pq_read_deferred then reads all recorded columns together, one row group at a time.
+
+int pq_read_columns_parallel(FileReaderVec* readers,
+                             int64_t n_cols,
+                             const int64_t* column_idxs,
+                             uint8_t** out_datas,
+                             const int* out_dtypes,
+                             int64_t start,
+                             int64_t count)
+{
+    if (count == 0 || n_cols == 0)
+    {
+        return 0;
+    }
+
+    if (readers->size() == 0)
+    {
+        printf("empty parquet dataset\n");
+        return 0;
+    }
+
+    // skip whole files if no need to read any rows
+    size_t file_ind = 0;
+    int64_t file_size = pq_file_size(readers, 0, column_idxs[0]);
+    while (start >= file_size)
+    {
+        start -= file_size;
+        file_ind++;
+        file_size = pq_file_size(readers, file_ind, column_idxs[0]);
+    }
+
+    // read data, output pointers advance through the files
+    std::vector<uint8_t*> col_datas(out_datas, out_datas + n_cols);
+    int64_t read_rows = 0;
+    while (read_rows < count)
+    {
+        int64_t rows_to_read = std::min(count - read_rows, file_size - start);
+        pq_read_columns_parallel_single_file(readers->at(file_ind),
+                                             n_cols,
+                                             column_idxs,
+                                             col_datas.data(),
+                                             out_dtypes,
+                                             start,
+                                             rows_to_read,
+                                             pq_file_row_groups(readers, file_ind),
+                                             readers->prefetch_depth,
+                                             readers->prefetch_max_bytes);
+        for (int64_t j = 0; j < n_cols; j++)
+        {
+            col_datas[j] += rows_to_read * pq_type_sizes[out_dtypes[j]];
+        }
+        read_rows += rows_to_read;
+        start = 0; // start becomes 0 after reading non-empty first chunk
+        file_ind++;
+        if (read_rows < count)
+        {
+            file_size = pq_file_size(readers, file_ind, column_idxs[0]);
+        }
+    }
+    return 0;
+}
+
+/// multi-column version of pq_read_parallel_row_groups, all columns share one row group plan
+static int pq_read_columns_parallel_row_groups(FileReaderVec* readers,
+                                               int64_t n_cols,
+                                               const int64_t* column_idxs,
+                                               uint8_t** out_datas,
+                                               const int* out_dtypes,
+                                               int64_t start,
+                                               int64_t count)
+{
+    pq_row_group_plan plan;
+    if (!pq_get_row_group_plan(readers, start, count, plan))
+    {
+        return pq_read_columns_parallel(readers, n_cols, column_idxs, out_datas, out_dtypes, start, count);
+    }
+
+    int64_t own_rows = plan.rank_starts[plan.rank + 1] - plan.rank_starts[plan.rank];
+    std::vector<std::vector<uint8_t>> own_data(n_cols);
+    std::vector<uint8_t*> own_datas(n_cols);
+    for (int64_t j = 0; j < n_cols; j++)
+    {
+        own_data[j].resize(own_rows * pq_type_sizes[out_dtypes[j]]);
+        own_datas[j] = own_data[j].data();
+    }
+    pq_read_columns_parallel(
+        readers, n_cols, column_idxs, own_datas.data(), out_dtypes, plan.rank_starts[plan.rank], own_rows);
+
+    for (int64_t j = 0; j < n_cols; j++)
+    {
+        pq_alltoallv_rows(
+            plan, own_datas[j], out_datas[j], plan.send_rows, plan.recv_rows, pq_type_sizes[out_dtypes[j]]);
+    }
+    return 0;
+}
+
+int64_t pq_defer_read(
+    FileReaderVec* readers, int64_t column_idx, uint8_t* out_data, int out_dtype, int64_t start, int64_t count)
+{
+    readers->deferred_reads.push_back({column_idx, out_data, out_dtype, start, count});
+    return 0;
+}
+
+int pq_read_deferred(FileReaderVec* readers, int row_group_dist, int prefetch_depth, int64_t prefetch_max_bytes)
+{
+    readers->prefetch_depth = prefetch_depth;
+    readers->prefetch_max_bytes = prefetch_max_bytes;
+
+    // columns of the same rows are read together. The order of the reads is the same
+    // on all ranks, which the collective row group distribution relies on
+    std::vector<pq_column_read> reads;
+    reads.swap(readers->deferred_reads);
+    while (!reads.empty())
+    {
+        int64_t start = reads[0].start;
+        int64_t count = reads[0].count;
+        std::vector<int64_t> column_idxs;
+        std::vector<uint8_t*> out_datas;
+        std::vector<int> out_dtypes;
+        std::vector<pq_column_read> other_reads;
+        for (const auto& read : reads)
+        {
+            if (read.start == start && read.count == count)
+            {
+                column_idxs.push_back(read.column_idx);
+                out_datas.push_back(read.out_data);
+                out_dtypes.push_back(read.out_dtype);
+            }
+            else
+            {
+                other_reads.push_back(read);
+            }
+        }
+        reads.swap(other_reads);
+
+        int64_t n_cols = column_idxs.size();
+        if (count == -1)
+        {
+            count = pq_get_size(readers, column_idxs[0]);
+            pq_read_columns_parallel(
+                readers, n_cols, column_idxs.data(), out_datas.data(), out_dtypes.data(), 0, count);
+        }
+        else if (row_group_dist)
+        {
+            pq_read_columns_parallel_row_groups(
+                readers, n_cols, column_idxs.data(), out_datas.data(), out_dtypes.data(), start, count);
+        }
+        else
+        {
+            pq_read_columns_parallel(
+                readers, n_cols, column_idxs.data(), out_datas.data(), out_dtypes.data(), start, count);
+        }
+    }
+    return 0;
+}
+
+// ***********************************************************************************
+// Parallel writes, see _parquet_writer.h
+
+void* pq_writer_new(int64_t n_rows)
+{
+    pq_writer* writer = new pq_writer();
+    writer->n_rows = n_rows;
+    return writer;
+}
+
+void pq_writer_add_column(void* writer, const char* name, int32_t col_type, const uint8_t* data)
+{
+    pq_writer_add_column_impl((pq_writer*)writer, name, col_type, data);
+}
+
+void pq_writer_add_string_column(
+    void* writer, const char* name, const uint32_t* offsets, const uint8_t* chars, const uint8_t* null_bitmap)
+{
+    pq_writer_add_string_column_impl((pq_writer*)writer, name, offsets, chars, null_bitmap);
+}
+
+int32_t pq_writer_write(void* writer, const char* path, int32_t rank, int64_t row_group_size, int32_t compression)
+{
+    return pq_writer_write_impl((pq_writer*)writer, path, rank, row_group_size, compression);
+}
+
+int32_t pq_write_metadata(const char* path, int32_t n_pes)
+{
+    return pq_write_metadata_impl(path, n_pes);
+}
+
+int32_t pq_write_clean_dir(const char* path)
+{
+    return pq_write_clean_dir_impl(path);
+}
+
+void pq_del_writer(void* writer)
+{
+    delete (pq_writer*)writer;
+}
@@ -0,0 +1,308 @@
+#ifndef _PARQUET_WRITER_H_INCLUDED
+#define _PARQUET_WRITER_H_INCLUDED
+
+#include <bitset>
+#include <boost/filesystem/operations.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../_hpat_common.h"
+#include "arrow/io/file.h"
+#include "arrow/table.h"
+#include "arrow/type.h"
+#include "parquet/api/reader.h"
+#include "parquet/arrow/writer.h"
+
+/*
+  Native parallel Parquet writer.
+
+  Every rank writes its rows of a distributed dataframe as its own part file
+  part-<rank>.parquet of the output directory, so no data is gathered. Rank 0
+  first removes the part files and _metadata of a previous write. Column
+  buffers are wrapped into Arrow arrays without copies, except bool columns which
+  are bit-packed and the validity of datetime64 columns (NaT is null).
+
+  After all parts are written, rank 0 writes a _metadata summary file with the row
+  groups of all parts (paths relative to the directory), which readers can use to
+  plan a read without opening every footer.
+*/
+
+// column types of the writer other than HPAT_CTypes values of numeric columns
+#define PQ_WRITE_COL_BOOL 102
+#define PQ_WRITE_COL_DATETIME 103
+#define PQ_WRITE_COL_STRING 104
+
+struct pq_writer
+{
+    int64_t n_rows;
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    // buffers created by the writer, the others point to the column data
+    std::vector<std::vector<uint8_t>> own_buffers;
+
+    std::shared_ptr<arrow::Buffer> new_buffer(int64_t size)
+    {
+        own_buffers.push_back(std::vector<uint8_t>(size, 0));
+        return std::make_shared<arrow::Buffer>(own_buffers.back().data(), size);
+    }
+};
+
+static std::shared_ptr<arrow::DataType> pq_write_arrow_type(int col_type)
+{
+    switch (col_type)
+    {
+    case HPAT_CTypes::INT8: return arrow::int8();
+    case HPAT_CTypes::UINT8: return arrow::uint8();
+    case HPAT_CTypes::INT16: return arrow::int16();
+    case HPAT_CTypes::UINT16: return arrow::uint16();
+    case HPAT_CTypes::INT32: return arrow::int32();
+    case HPAT_CTypes::UINT32: return arrow::uint32();
+    case HPAT_CTypes::INT64: return arrow::int64();
+    case HPAT_CTypes::UINT64: return arrow::uint64();
+    case HPAT_CTypes::FLOAT32: return arrow::float32();
+    case HPAT_CTypes::FLOAT64: return arrow::float64();
+    case PQ_WRITE_COL_BOOL: return arrow::boolean();
+    case PQ_WRITE_COL_DATETIME: return arrow::timestamp(arrow::TimeUnit::NANO);
+    default: std::cerr << "parquet write: unsupported column type " << col_type << std::endl; return nullptr;
+    }
+}
+
+static int pq_write_type_size(int col_type)
+{
+    switch (col_type)
+    {
+    case HPAT_CTypes::INT8:
+    case HPAT_CTypes::UINT8:
+    case PQ_WRITE_COL_BOOL: return 1;
+    case HPAT_CTypes::INT16:
+    case HPAT_CTypes::UINT16: return 2;
+    case HPAT_CTypes::INT32:
+    case HPAT_CTypes::UINT32:
+    case HPAT_CTypes::FLOAT32: return 4;
+    default: return 8;
+    }
+}
+
+/// number of zero bits among the first n bits of an Arrow validity bitmap
+static int64_t pq_write_null_count(const uint8_t* null_bitmap, int64_t n)
+{
+    int64_t n_valid = 0;
+    for (int64_t i = 0; i < n / 8; i++)
+    {
+        n_valid += std::bitset<8>(null_bitmap[i]).count();
+    }
+    for (int64_t i = n / 8 * 8; i < n; i++)
+    {
+        n_valid += (null_bitmap[i / 8] >> (i % 8)) & 1;
+    }
+    return n - n_valid;
+}
+
+static void pq_writer_add_array(pq_writer* writer,
+                                const char* name,
+                                const std::shared_ptr<arrow::DataType>& type,
+                                std::vector<std::shared_ptr<arrow::Buffer>>&& buffers,
+                                int64_t null_count)
+{
+    writer->fields.push_back(arrow::field(name, type));
+    writer->arrays.push_back(
+        arrow::MakeArray(arrow::ArrayData::Make(type, writer->n_rows, std::move(buffers), null_count)));
+}
+
+static void pq_writer_add_column_impl(pq_writer* writer, const char* name, int col_type, const uint8_t* data)
+{
+    std::shared_ptr<arrow::DataType> type = pq_write_arrow_type(col_type);
+    if (type == nullptr)
+    {
+        return;
+    }
+    int64_t n = writer->n_rows;
+
+    if (col_type == PQ_WRITE_COL_BOOL)
+    {
+        // numpy bools are bytes, Arrow bools are bits
+        std::shared_ptr<arrow::Buffer> values = writer->new_buffer((n + 7) / 8);
+        uint8_t* bits = writer->own_buffers.back().data();
+        for (int64_t i = 0; i < n; i++)
+        {
+            bits[i / 8] |= (uint8_t)((data[i] != 0) << (i % 8));
+        }
+        pq_writer_add_array(writer, name, type, {nullptr, values}, 0);
+        return;
+    }
+
+    std::shared_ptr<arrow::Buffer> values = std::make_shared<arrow::Buffer>(data, n * pq_write_type_size(col_type));
+    if (col_type == PQ_WRITE_COL_DATETIME)
+    {
+        // NaT values are written as nulls like pandas does
+        const int64_t* dt_data = (const int64_t*)data;
+        int64_t null_count = 0;
+        for (int64_t i = 0; i < n; i++)
+        {
+            null_count += dt_data[i] == std::numeric_limits<int64_t>::min();
+        }
+        std::shared_ptr<arrow::Buffer> null_bitmap;
+        if (null_count > 0)
+        {
+            null_bitmap = writer->new_buffer((n + 7) / 8);
+            uint8_t* bits = writer->own_buffers.back().data();
+            for (int64_t i = 0; i < n; i++)
+            {
+                bits[i / 8] |= (uint8_t)((dt_data[i] != std::numeric_limits<int64_t>::min()) << (i % 8));
+            }
+        }
+        pq_writer_add_array(writer, name, type, {null_bitmap, values}, null_count);
+        return;
+    }
+    pq_writer_add_array(writer, name, type, {nullptr, values}, 0);
+}
+
+static void pq_writer_add_string_column_impl(
+    pq_writer* writer, const char* name, const uint32_t* offsets, const uint8_t* chars, const uint8_t* null_bitmap)
+{
+    int64_t n = writer->n_rows;
+    // offsets of HPAT string arrays are 32-bit like Arrow's, only unsigned
+    std::shared_ptr<arrow::Buffer> offsets_buf =
+        std::make_shared<arrow::Buffer>((const uint8_t*)offsets, (n + 1) * sizeof(uint32_t));
+    std::shared_ptr<arrow::Buffer> chars_buf = std::make_shared<arrow::Buffer>(chars, offsets[n]);
+    std::shared_ptr<arrow::Buffer> null_buf;
+    int64_t null_count = 0;
+    if (null_bitmap != nullptr)
+    {
+        null_count = pq_write_null_count(null_bitmap, n);
+        if (null_count > 0)
+        {
+            null_buf = std::make_shared<arrow::Buffer>(null_bitmap, (n + 7) / 8);
+        }
+    }
+    pq_writer_add_array(writer, name, arrow::utf8(), {null_buf, offsets_buf, chars_buf}, null_count);
+}
+
+static std::string pq_write_part_name(int rank)
+{
+    char part_name[32];
+    snprintf(part_name, sizeof(part_name), "part-%05d.parquet", rank);
+    return part_name;
+}
+
+/// create the output directory (by all ranks), true if it exists afterwards
+static bool pq_write_create_dir(const std::string& path)
+{
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(path, ec);
+    // another rank could create it concurrently
+    return boost::filesystem::is_directory(path);
+}
+
+/// remove the part files and _metadata of a previous write to the output directory, so parts of
+/// ranks beyond the current ones aren't read back as data. Called on one rank before any part is written
+static int pq_write_clean_dir_impl(const std::string& path)
+{
+    boost::system::error_code ec;
+    if (!boost::filesystem::is_directory(path, ec))
+        return 0;
+    std::vector<boost::filesystem::path> old_files;
+    for (boost::filesystem::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string name = it->path().filename().string();
+        if (name == "_metadata" ||
+            (name.compare(0, 5, "part-") == 0 && it->path().extension().string() == ".parquet"))
+            old_files.push_back(it->path());
+    }
+    for (auto& old_file : old_files)
+        if (!ec)
+            boost::filesystem::remove(old_file, ec);
+    if (ec)
+    {
+        std::cerr << "parquet write: cannot remove old files of " << path << ": " << ec.message() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+static int pq_writer_write_impl(
+    pq_writer* writer, const std::string& path, int rank, int64_t row_group_size, int compression)
+{
+    if (!pq_write_create_dir(path))
+    {
+        std::cerr << "parquet write: cannot create directory " << path << std::endl;
+        return -1;
+    }
+    std::string part_path = (boost::filesystem::path(path) / pq_write_part_name(rank)).string();
+
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(arrow::schema(writer->fields), writer->arrays);
+    std::shared_ptr<arrow::io::FileOutputStream> out_file;
+    arrow::Status status = arrow::io::FileOutputStream::Open(part_path, &out_file);
+    if (!status.ok())
+    {
+        std::cerr << "parquet write: cannot open " << part_path << ": " << status.ToString() << std::endl;
+        return -1;
+    }
+
+    std::shared_ptr<parquet::WriterProperties> props =
+        parquet::WriterProperties::Builder().compression((parquet::Compression::type)compression)->build();
+    // INT96 keeps nanoseconds of datetime64 columns (Parquet 1.0 has no nanosecond timestamps)
+    std::shared_ptr<parquet::ArrowWriterProperties> arrow_props =
+        parquet::ArrowWriterProperties::Builder().enable_deprecated_int96_timestamps()->build();
+    status = parquet::arrow::WriteTable(
+        *table, arrow::default_memory_pool(), out_file, std::max(row_group_size, (int64_t)1), props, arrow_props);
+    if (!status.ok())
+    {
+        std::cerr << "parquet write: " << status.ToString() << std::endl;
+        out_file->Close();
+        return -1;
+    }
+    out_file->Close();
+    return 0;
+}
+
+/// write _metadata of the part files of all ranks, called on one rank after all parts are written
+static int pq_write_metadata_impl(const std::string& path, int n_pes)
+{
+    std::shared_ptr<parquet::FileMetaData> metadata;
+    for (int rank = 0; rank < n_pes; rank++)
+    {
+        std::string part_name = pq_write_part_name(rank);
+        std::string part_path = (boost::filesystem::path(path) / part_name).string();
+        std::shared_ptr<parquet::FileMetaData> part_metadata;
+        try
+        {
+            part_metadata = parquet::ParquetFileReader::OpenFile(part_path, false)->metadata();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "parquet write: cannot read footer of " << part_path << ": " << e.what() << std::endl;
+            return -1;
+        }
+        part_metadata->set_file_path(part_name);
+        if (metadata == nullptr)
+        {
+            metadata = part_metadata;
+        }
+        else
+        {
+            metadata->AppendRowGroups(*part_metadata);
+        }
+    }
+
+    std::string metadata_path = (boost::filesystem::path(path) / "_metadata").string();
+    std::shared_ptr<arrow::io::FileOutputStream> out_file;
+    arrow::Status status = arrow::io::FileOutputStream::Open(metadata_path, &out_file);
+    if (status.ok())
+    {
+        status = parquet::arrow::WriteMetaDataFile(*metadata, out_file.get());
+        out_file->Close();
+    }
+    if (!status.ok())
+    {
+        std::cerr << "parquet write: cannot write " << metadata_path << ": " << status.ToString() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+#endif // _PARQUET_WRITER_H_INCLUDED
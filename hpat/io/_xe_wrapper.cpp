@@ -1,7 +1,11 @@
 #include <Python.h>
+#include <algorithm>
 #include <cmath>
 #include <ctgmath>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <tuple>
 #include <vector>
 
 #include "xe.h"
@@ -208,73 +212,78 @@ int64_t get_column_size_xenon(xe_connection_t xe_connection, xe_dataset_t xe_dat
     return status.nrows;
 }
 
-void read_xenon_col(
-    xe_connection_t xe_connection, xe_dataset_t xe_dataset, uint64_t col_id, uint8_t* arr, uint64_t* xe_typ_enums)
+// ***********************************************************************************
+// Multi-column reads
+//
+// Rows of a strand are stored field after field, so reading a column decodes every
+// field of every row anyway. read_xenon_columns reads all numeric columns of a read into
+// their output arrays in one pass, decoding each row once, and reads the string columns of
+// the schema in the same pass. String arrays are allocated by their own read calls, so the
+// strings read ahead are kept until read_xenon_col_str takes them. A string read with
+// nothing read ahead for its rows reads all string columns of those rows in one pass.
+// xe_drop_read_ahead drops the string columns whose reads were removed as dead.
+
+// _type_to_xe_dtype_number = {'int8': 0, 'int16': 1, 'int32': 2, 'int64': 3,
+//                             'float32': 4, 'float64': 5, 'DECIMAL': 6,
+//                              'bool_': 7, 'string': 8, 'BLOB': 9}
+static const int xe_type_sizes[] = {1, 2, 4, 8, 4, 8, 0, 1, 0, 0};
+
+#define XE_TYPE_STRING 8
+
+// output of a column of a multi-column read
+struct xe_column_out
+{
+    uint64_t col_id;
+    uint8_t* data;                 // numeric columns
+    std::vector<uint32_t> offsets; // string columns
+    std::vector<uint8_t> chars;
+};
+
+// string columns of a dataset read ahead, by column and row range
+typedef std::map<std::tuple<uint64_t, int64_t, int64_t>, xe_column_out> xe_read_ahead_cols;
+
+static std::map<xe_dataset_t, xe_read_ahead_cols> xe_read_ahead;
+
+/**
+ * Read rows [start, start + count) of the columns in one pass over the strands, decoding
+ * each row once and scattering the fields of the requested columns to their outputs.
+ * count -1 reads all rows.
+ **/
+static bool xe_read_columns(xe_connection_t xe_connection,
+                            xe_dataset_t xe_dataset,
+                            const uint64_t* xe_typ_enums,
+                            std::vector<xe_column_out>& cols,
+                            int64_t start,
+                            int64_t count)
 {
     struct xe_status status;
 
     int err = xe_status(xe_connection, xe_dataset, 0, &status);
-    CHECK(!err, "Fail to stat dataset", );
-    CHECK(col_id < status.ncols, "invalid column number", );
-
-    // _type_to_xe_dtype_number = {'int8': 0, 'int16': 1, 'int32': 2, 'int64': 3,
-    //                             'float32': 4, 'float64': 5, 'DECIMAL': 6,
-    //                              'bool_': 7, 'string': 8, 'BLOB': 9}
-
-    uint8_t* curr_arr = arr;
-    uint8_t* read_buf = (uint8_t*)malloc(READ_BUF_SIZE * sizeof(uint8_t));
-    uint64_t nrows = 0;
-    int len = 0;
-
-    for (uint64_t sid = 0; sid < status.fanout; sid++)
+    CHECK(!err, "Fail to stat dataset", false);
+    if (count == -1)
     {
-        xe_rewind(xe_connection, xe_dataset, sid);
+        count = status.nrows;
+    }
 
-        do
+    // output of each column of the schema, -1 if it isn't read
+    std::vector<int> col_outs(status.ncols, -1);
+    for (size_t i = 0; i < cols.size(); i++)
+    {
+        CHECK(cols[i].col_id < status.ncols, "invalid column number", false);
+        CHECK(col_outs[cols[i].col_id] == -1, "column read twice", false);
+        col_outs[cols[i].col_id] = i;
+        if (xe_typ_enums[cols[i].col_id] == XE_TYPE_STRING)
         {
-            uint8_t* buf = read_buf;
-            xe_get(xe_connection, xe_dataset, sid, read_buf, READ_BUF_SIZE, &nrows);
-            for (uint64_t r = 0; r < nrows; r++)
-            {
-                for (uint64_t c = 0; c < status.ncols; c++)
-                {
-                    uint64_t tp_enum = xe_typ_enums[c];
-                    read_xe_row(buf, curr_arr, tp_enum, col_id == c, len);
-                }
-            }
-        } while (nrows);
+            cols[i].offsets.assign(1, 0);
+            cols[i].offsets.reserve(count + 1);
+        }
+    }
+    if (count == 0)
+    {
+        return true;
     }
 
-    delete[] read_buf;
-
-    return;
-}
-
-void read_xenon_col_parallel(xe_connection_t xe_connection,
-                             xe_dataset_t xe_dataset,
-                             uint64_t col_id,
-                             uint8_t* arr,
-                             uint64_t* xe_typ_enums,
-                             uint64_t start,
-                             uint64_t count)
-{
-    // printf("read column %lld\n", col_id);
-    // for (uint64_t i = 0; i<22; i++)
-    //     printf("%lld ", xe_typ_enums[i]);
-    // printf("\n");
-
-    struct xe_status status;
-
-    int err = xe_status(xe_connection, xe_dataset, 0, &status);
-    CHECK(!err, "Fail to stat dataset", );
-    CHECK(col_id < status.ncols, "invalid column number", );
-
-    // _type_to_xe_dtype_number = {'int8': 0, 'int16': 1, 'int32': 2, 'int64': 3,
-    //                             'float32': 4, 'float64': 5, 'DECIMAL': 6,
-    //                              'bool_': 7, 'string': 8, 'BLOB': 9}
-
-    uint8_t* curr_arr = arr;
-    uint8_t* read_buf = (uint8_t*)malloc(READ_BUF_SIZE * sizeof(uint8_t));
+    std::vector<uint8_t> read_buf(READ_BUF_SIZE);
     uint64_t nrows = 0;
     int len = 0;
 
@@ -288,34 +297,58 @@ void read_xenon_col_parallel(xe_connection_t xe_connection,
         skipped_rows += status.snrows;
         strand_ind++;
         err = xe_status(xe_connection, xe_dataset, strand_ind, &status);
-        CHECK(!err, "Fail to stat dataset", );
+        CHECK(!err, "Fail to stat dataset", false);
     }
 
     while (read_rows < count)
     {
         err = xe_rewind(xe_connection, xe_dataset, strand_ind);
-        CHECK(!err, "Fail to rewind dataset", );
+        CHECK(!err, "Fail to rewind dataset", false);
         int64_t rows_to_skip = start - skipped_rows;
-        int64_t rows_to_read = std::min(count - read_rows, status.snrows - rows_to_skip);
+        int64_t rows_to_read = std::min(count - read_rows, (int64_t)status.snrows - rows_to_skip);
         int64_t batch_ind = 0;
 
         do
         {
-            uint8_t* buf = read_buf;
-            err = xe_get(xe_connection, xe_dataset, strand_ind, read_buf, READ_BUF_SIZE, &nrows);
-            CHECK(!err, "Fail to read dataset", );
+            uint8_t* buf = read_buf.data();
+            err = xe_get(xe_connection, xe_dataset, strand_ind, read_buf.data(), READ_BUF_SIZE, &nrows);
+            CHECK(!err, "Fail to read dataset", false);
             for (uint64_t r = batch_ind; r < batch_ind + nrows; r++)
             {
                 bool do_read = (r >= rows_to_skip) && (r < (rows_to_skip + rows_to_read));
+                // output row of the fields
+                int64_t out_row = read_rows + r - rows_to_skip;
                 for (uint64_t c = 0; c < status.ncols; c++)
                 {
                     uint64_t tp_enum = xe_typ_enums[c];
-                    read_xe_row(buf, curr_arr, tp_enum, (col_id == c) && do_read, len);
+                    int out_ind = do_read ? col_outs[c] : -1;
+                    if (out_ind == -1)
+                    {
+                        uint8_t* no_arr = nullptr;
+                        read_xe_row(buf, no_arr, tp_enum, false, len);
+                    }
+                    else if (tp_enum == XE_TYPE_STRING)
+                    {
+                        // the chars are right before the next field, null strings are empty
+                        xe_column_out& col = cols[out_ind];
+                        uint8_t* no_arr = nullptr;
+                        len = 0;
+                        read_xe_row(buf, no_arr, tp_enum, false, len);
+                        col.chars.insert(col.chars.end(), buf - len, buf);
+                        col.offsets.push_back(col.chars.size());
+                    }
+                    else
+                    {
+                        uint8_t* curr_arr = cols[out_ind].data + out_row * xe_type_sizes[tp_enum];
+                        read_xe_row(buf, curr_arr, tp_enum, true, len);
+                    }
                 }
             }
             batch_ind += nrows;
             if (batch_ind > (rows_to_skip + rows_to_read))
+            {
                 break;
+            }
         } while (nrows);
 
         skipped_rows += rows_to_skip;
@@ -325,86 +358,127 @@ void read_xenon_col_parallel(xe_connection_t xe_connection,
         if (strand_ind < status.fanout)
         {
             err = xe_status(xe_connection, xe_dataset, strand_ind, &status);
-            CHECK(!err, "Fail to read dataset", );
+            CHECK(!err, "Fail to read dataset", false);
         }
         else
         {
             break;
         }
     }
-    CHECK(read_rows == count, "Xenon read incomplete", );
-    delete[] read_buf;
-
-    return;
+    CHECK(read_rows == count, "Xenon read incomplete", false);
+    return true;
 }
 
-void read_xenon_col_str(xe_connection_t xe_connection,
-                        xe_dataset_t xe_dataset,
-                        uint64_t col_id,
-                        uint32_t** out_offsets,
-                        uint8_t** out_data,
-                        uint64_t* xe_typ_enums)
+/**
+ * Read rows [start, start + count) of the columns with the string columns of the schema not
+ * read ahead for these rows yet. The string columns added are kept as read ahead, the
+ * columns passed are left in cols.
+ **/
+static bool xe_read_columns_ahead(xe_connection_t xe_connection,
+                                  xe_dataset_t xe_dataset,
+                                  const uint64_t* xe_typ_enums,
+                                  std::vector<xe_column_out>& cols,
+                                  int64_t start,
+                                  int64_t count)
 {
-    // printf("read column %lld\n", col_id);
-    // for (uint64_t i = 0; i<6; i++)
-    //     printf("%lld ", xe_typ_enums[i]);
-    // printf("\n");
-
     struct xe_status status;
 
     int err = xe_status(xe_connection, xe_dataset, 0, &status);
-    CHECK(!err, "Fail to stat dataset", );
-    CHECK(col_id < status.ncols, "invalid column number", );
-
-    // _type_to_xe_dtype_number = {'int8': 0, 'int16': 1, 'int32': 2, 'int64': 3,
-    //                             'float32': 4, 'float64': 5, 'DECIMAL': 6,
-    //                              'bool_': 7, 'string': 8, 'BLOB': 9}
-
-    *out_offsets = new uint32_t[status.nrows + 1];
-    uint32_t* curr_offset = *out_offsets;
-    uint32_t curr_len = 0;
-    std::vector<uint8_t> data_vec;
+    CHECK(!err, "Fail to stat dataset", false);
 
-    uint8_t* data_arr = (uint8_t*)malloc(READ_BUF_SIZE * sizeof(uint8_t));
-    uint8_t* read_buf = (uint8_t*)malloc(READ_BUF_SIZE * sizeof(uint8_t));
-    uint64_t nrows = 0;
-    int len = 0;
+    xe_read_ahead_cols& read_ahead = xe_read_ahead[xe_dataset];
+    size_t n_cols = cols.size();
+    for (uint64_t c = 0; c < status.ncols; c++)
+    {
+        bool is_out = std::any_of(
+            cols.begin(), cols.begin() + n_cols, [c](const xe_column_out& col) { return col.col_id == c; });
+        if (xe_typ_enums[c] == XE_TYPE_STRING && !is_out && read_ahead.count(std::make_tuple(c, start, count)) == 0)
+        {
+            cols.push_back({c, nullptr});
+        }
+    }
 
-    for (uint64_t sid = 0; sid < status.fanout; sid++)
+    if (!xe_read_columns(xe_connection, xe_dataset, xe_typ_enums, cols, start, count))
+    {
+        return false;
+    }
+    for (size_t i = n_cols; i < cols.size(); i++)
     {
-        xe_rewind(xe_connection, xe_dataset, sid);
+        read_ahead[std::make_tuple(cols[i].col_id, start, count)] = std::move(cols[i]);
+    }
+    cols.resize(n_cols);
+    return true;
+}
 
-        do
+/// read string column col_id, taking it from the columns read ahead (see Multi-column reads)
+static void xe_read_str_column(xe_connection_t xe_connection,
+                               xe_dataset_t xe_dataset,
+                               uint64_t col_id,
+                               uint32_t** out_offsets,
+                               uint8_t** out_data,
+                               uint64_t* xe_typ_enums,
+                               int64_t start,
+                               int64_t count)
+{
+    xe_read_ahead_cols& read_ahead = xe_read_ahead[xe_dataset];
+    auto key = std::make_tuple(col_id, start, count);
+    xe_column_out col;
+    auto col_ahead = read_ahead.find(key);
+    if (col_ahead != read_ahead.end())
+    {
+        col = std::move(col_ahead->second);
+        read_ahead.erase(col_ahead);
+    }
+    else
+    {
+        std::vector<xe_column_out> cols(1);
+        cols[0].col_id = col_id;
+        cols[0].data = nullptr;
+        if (!xe_read_columns_ahead(xe_connection, xe_dataset, xe_typ_enums, cols, start, count))
         {
-            uint8_t* buf = read_buf;
-            uint8_t* curr_arr = data_arr;
-            xe_get(xe_connection, xe_dataset, sid, read_buf, READ_BUF_SIZE, &nrows);
-            for (uint64_t r = 0; r < nrows; r++)
-            {
-                for (uint64_t c = 0; c < status.ncols; c++)
-                {
-                    uint64_t tp_enum = xe_typ_enums[c];
-                    read_xe_row(buf, curr_arr, tp_enum, col_id == c, len);
-                    if (col_id == c)
-                    {
-                        *curr_offset = curr_len;
-                        curr_offset++;
-                        curr_len += len;
-                        data_vec.insert(data_vec.end(), curr_arr - len, curr_arr);
-                    }
-                }
-            }
-        } while (nrows);
+            *out_offsets = NULL;
+            *out_data = NULL;
+            return;
+        }
+        col = std::move(cols[0]);
     }
-    *curr_offset = curr_len;
-
-    *out_data = new uint8_t[data_vec.size()];
-    memcpy(*out_data, data_vec.data(), data_vec.size());
 
-    delete[] data_arr;
+    *out_offsets = new uint32_t[col.offsets.size()];
+    std::copy(col.offsets.begin(), col.offsets.end(), *out_offsets);
+    *out_data = new uint8_t[col.chars.size()];
+    std::copy(col.chars.begin(), col.chars.end(), *out_data);
+}
 
-    delete[] read_buf;
+/**
+ * Read rows [start, start + count) of the numeric columns col_ids into their arrays col_data,
+ * reading the string columns of the schema ahead in the same pass. count -1 reads all rows.
+ **/
+void read_xenon_columns(xe_connection_t xe_connection,
+                        xe_dataset_t xe_dataset,
+                        uint64_t* xe_typ_enums,
+                        int64_t* col_ids,
+                        int64_t n_cols,
+                        uint8_t** col_data,
+                        int64_t start,
+                        int64_t count)
+{
+    std::vector<xe_column_out> cols;
+    for (int64_t i = 0; i < n_cols; i++)
+    {
+        cols.push_back({(uint64_t)col_ids[i], col_data[i]});
+    }
+    xe_read_columns_ahead(xe_connection, xe_dataset, xe_typ_enums, cols, start, count);
+    return;
+}
 
+void read_xenon_col_str(xe_connection_t xe_connection,
+                        xe_dataset_t xe_dataset,
+                        uint64_t col_id,
+                        uint32_t** out_offsets,
+                        uint8_t** out_data,
+                        uint64_t* xe_typ_enums)
+{
+    xe_read_str_column(xe_connection, xe_dataset, col_id, out_offsets, out_data, xe_typ_enums, 0, -1);
     return;
 }
 
@@ -417,112 +491,20 @@ void read_xenon_col_str_parallel(xe_connection_t xe_connection,
                                  uint64_t start,
                                  uint64_t count)
 {
-    // printf("read column %lld\n", col_id);
-    // for (uint64_t i = 0; i<6; i++)
-    //     printf("%lld ", xe_typ_enums[i]);
-    // printf("\n");
-
     if (count == 0)
     {
         *out_offsets = NULL;
         *out_data = NULL;
         return;
     }
+    xe_read_str_column(xe_connection, xe_dataset, col_id, out_offsets, out_data, xe_typ_enums, start, count);
+    return;
+}
 
-    struct xe_status status;
-
-    int err = xe_status(xe_connection, xe_dataset, 0, &status);
-    CHECK(!err, "Fail to stat dataset", );
-    CHECK(col_id < status.ncols, "invalid column number", );
-
-    // _type_to_xe_dtype_number = {'int8': 0, 'int16': 1, 'int32': 2, 'int64': 3,
-    //                             'float32': 4, 'float64': 5, 'DECIMAL': 6,
-    //                              'bool_': 7, 'string': 8, 'BLOB': 9}
-
-    *out_offsets = new uint32_t[count + 1];
-    uint32_t* curr_offset = *out_offsets;
-    uint32_t curr_len = 0;
-    std::vector<uint8_t> data_vec;
-
-    uint8_t* data_arr = (uint8_t*)malloc(READ_BUF_SIZE * sizeof(uint8_t));
-    uint8_t* read_buf = (uint8_t*)malloc(READ_BUF_SIZE * sizeof(uint8_t));
-    uint64_t nrows = 0;
-    int len = 0;
-
-    int strand_ind = 0;
-    int64_t skipped_rows = 0;
-    int64_t read_rows = 0;
-
-    // skip whole strands if no need to read any rows
-    while (start - skipped_rows >= status.snrows)
-    {
-        skipped_rows += status.snrows;
-        strand_ind++;
-        err = xe_status(xe_connection, xe_dataset, strand_ind, &status);
-        CHECK(!err, "Fail to stat dataset", );
-    }
-
-    while (read_rows < count)
-    {
-        err = xe_rewind(xe_connection, xe_dataset, strand_ind);
-        CHECK(!err, "Fail to rewind dataset", );
-        int64_t rows_to_skip = start - skipped_rows;
-        int64_t rows_to_read = std::min(count - read_rows, status.snrows - rows_to_skip);
-        int64_t batch_ind = 0;
-
-        do
-        {
-            uint8_t* buf = read_buf;
-            uint8_t* curr_arr = data_arr;
-            err = xe_get(xe_connection, xe_dataset, strand_ind, read_buf, READ_BUF_SIZE, &nrows);
-            CHECK(!err, "Fail to read dataset", );
-            for (uint64_t r = batch_ind; r < batch_ind + nrows; r++)
-            {
-                bool do_read = (r >= rows_to_skip) && (r < (rows_to_skip + rows_to_read));
-                for (uint64_t c = 0; c < status.ncols; c++)
-                {
-                    uint64_t tp_enum = xe_typ_enums[c];
-                    read_xe_row(buf, curr_arr, tp_enum, (col_id == c) && do_read, len);
-                    if (col_id == c && do_read)
-                    {
-                        *curr_offset = curr_len;
-                        curr_offset++;
-                        curr_len += len;
-                        data_vec.insert(data_vec.end(), curr_arr - len, curr_arr);
-                    }
-                }
-            }
-            batch_ind += nrows;
-            if (batch_ind > (rows_to_skip + rows_to_read))
-            {
-                break;
-            }
-        } while (nrows);
-
-        skipped_rows += rows_to_skip;
-        read_rows += rows_to_read;
-
-        strand_ind++;
-        if (strand_ind < status.fanout)
-        {
-            err = xe_status(xe_connection, xe_dataset, strand_ind, &status);
-            CHECK(!err, "Fail to read dataset", );
-        }
-        else
-        {
-            break;
-        }
-    }
-    CHECK(read_rows == count, "Xenon read incomplete", );
-    *curr_offset = curr_len;
-
-    *out_data = new uint8_t[data_vec.size()];
-    memcpy(*out_data, data_vec.data(), data_vec.size());
-
-    delete[] data_arr;
-
-    delete[] read_buf;
-
+/// drop the string columns read ahead but not taken by their (dead) reads
+void xe_drop_read_ahead(xe_connection_t xe_connection, xe_dataset_t xe_dataset)
+{
+    xe_read_ahead.erase(xe_dataset);
     return;
 }
 
@@ -544,6 +526,7 @@ xe_dataset_t c_xe_open(xe_connection_t xe_connect, char* dset)
 
 void c_xe_close(xe_connection_t xe_connect, xe_dataset_t xe_dataset)
 {
+    xe_read_ahead.erase(xe_dataset);
     xe_close(xe_connect, xe_dataset);
     xe_disconnect(xe_connect);
     return;
@@ -572,10 +555,10 @@ PyMODINIT_FUNC PyInit_hxe_ext(void)
     }
 
     PyObject_SetAttrString(m, "get_column_size_xenon", PyLong_FromVoidPtr((void*)(&get_column_size_xenon)));
-    PyObject_SetAttrString(m, "read_xenon_col", PyLong_FromVoidPtr((void*)(&read_xenon_col)));
-    PyObject_SetAttrString(m, "read_xenon_col_parallel", PyLong_FromVoidPtr((void*)(&read_xenon_col_parallel)));
+    PyObject_SetAttrString(m, "read_xenon_columns", PyLong_FromVoidPtr((void*)(&read_xenon_columns)));
     PyObject_SetAttrString(m, "read_xenon_col_str", PyLong_FromVoidPtr((void*)(&read_xenon_col_str)));
     PyObject_SetAttrString(m, "read_xenon_col_str_parallel", PyLong_FromVoidPtr((void*)(&read_xenon_col_str_parallel)));
+    PyObject_SetAttrString(m, "xe_drop_read_ahead", PyLong_FromVoidPtr((void*)(&xe_drop_read_ahead)));
     PyObject_SetAttrString(m, "c_xe_connect", PyLong_FromVoidPtr((void*)(&c_xe_connect)));
     PyObject_SetAttrString(m, "c_xe_open", PyLong_FromVoidPtr((void*)(&c_xe_open)));
     PyObject_SetAttrString(m, "c_xe_close", PyLong_FromVoidPtr((void*)(&c_xe_close)));
@@ -5,7 +5,8 @@ from collections import defaultdict
 import numba
 from numba import typeinfer, ir, ir_utils, config, types, cgutils
 from numba.typing.templates import signature
-from numba.extending import overload, intrinsic, register_model, models, box
+from numba.targets.imputils import impl_ret_new_ref
+from numba.extending import overload, intrinsic, register_model, models, box, unbox, NativeValue
 from numba.ir_utils import (visit_vars_inner, replace_vars_inner,
                             compile_to_numba_ir, replace_arg_nodes)
 import hpat
@@ -14,6 +15,7 @@ from hpat.utils import debug_prints, alloc_arr_tup, empty_like_type
 from hpat.distributed_analysis import Distribution
 from hpat.str_ext import string_type
 from hpat.str_arr_ext import (string_array_type, to_string_list,
+                              StringArrayPayloadType, construct_string_array,
                               cp_str_list_to_array, str_list_to_array,
                               get_offset_ptr, get_data_ptr, convert_len_arr_to_offset,
                               pre_alloc_string_array, num_total_chars,
@@ -197,6 +199,22 @@ def build_csv_definitions(csv_node, definitions=None):
 ir_utils.build_defs_extensions[CsvReader] = build_csv_definitions
 
 ll.add_symbol('csv_file_chunk_reader', hio.csv_file_chunk_reader)
+ll.add_symbol('csv_file_chunk_parse', hio.csv_file_chunk_parse)
+ll.add_symbol('csv_get_num_rows', hio.csv_get_num_rows)
+ll.add_symbol('csv_get_num_errors', hio.csv_get_num_errors)
+ll.add_symbol('csv_read_column', hio.csv_read_column)
+ll.add_symbol('csv_read_string_column', hio.csv_read_string_column)
+ll.add_symbol('csv_del_chunk', hio.csv_del_chunk)
+ll.add_symbol('csv_file_batch_reader', hio.csv_file_batch_reader)
+ll.add_symbol('csv_read_batch', hio.csv_read_batch)
+ll.add_symbol('csv_del_batch_reader', hio.csv_del_batch_reader)
+ll.add_symbol('csv_writer_new', hio.csv_writer_new)
+ll.add_symbol('csv_writer_add_column', hio.csv_writer_add_column)
+ll.add_symbol('csv_writer_add_string_column', hio.csv_writer_add_string_column)
+ll.add_symbol('csv_datetime_column_resolution', hio.csv_datetime_column_resolution)
+ll.add_symbol('csv_writer_format', hio.csv_writer_format)
+ll.add_symbol('csv_writer_data', hio.csv_writer_data)
+ll.add_symbol('csv_del_writer', hio.csv_del_writer)
 
 
 def csv_distributed_run(csv_node, array_dists, typemap, calltypes, typingctx, targetctx, dist_pass):
@@ -280,6 +298,97 @@ csv_file_chunk_reader = types.ExternalFunction(
         types.voidptr, types.bool_, types.int64, types.int64))
 
 
+csv_file_chunk_parse = types.ExternalFunction(
+    "csv_file_chunk_parse", types.voidptr(
+        types.voidptr, types.bool_, types.int64, types.int64, types.int8,
+        types.int64, types.voidptr, types.voidptr, types.int64))
+csv_get_num_rows = types.ExternalFunction("csv_get_num_rows", types.int64(types.voidptr))
+csv_get_num_errors = types.ExternalFunction("csv_get_num_errors", types.int64(types.voidptr))
+csv_read_column = types.ExternalFunction(
+    "csv_read_column", types.void(types.voidptr, types.int64, types.voidptr))
+csv_del_chunk = types.ExternalFunction("csv_del_chunk", types.void(types.voidptr))
+
+
+class CsvBatchReaderType(types.Opaque):
+    def __init__(self):
+        super(CsvBatchReaderType, self).__init__(name='CsvBatchReaderType')
+
+
+csv_batch_reader_type = CsvBatchReaderType()
+register_model(CsvBatchReaderType)(models.OpaqueModel)
+
+
+@box(CsvBatchReaderType)
+def box_csv_batch_reader(typ, val, c):
+    return c.pyapi.long_from_voidptr(val)
+
+
+@unbox(CsvBatchReaderType)
+def unbox_csv_batch_reader(typ, obj, c):
+    return NativeValue(c.pyapi.long_as_voidptr(obj))
+
+
+csv_file_batch_reader = types.ExternalFunction(
+    "csv_file_batch_reader", csv_batch_reader_type(
+        types.voidptr, types.bool_, types.int64, types.int64, types.int8,
+        types.int64, types.voidptr, types.voidptr, types.int64))
+csv_read_batch = types.ExternalFunction("csv_read_batch", types.voidptr(csv_batch_reader_type))
+csv_del_batch_reader = types.ExternalFunction("csv_del_batch_reader", types.void(csv_batch_reader_type))
+
+
+@intrinsic
+def csv_read_string_column(typingctx, chunk_typ, col_ind_typ, n_rows_typ=None):
+    def codegen(context, builder, sig, args):
+        typ = sig.return_type
+        dtype = StringArrayPayloadType()
+        meminfo, meminfo_data_ptr = construct_string_array(context, builder)
+        string_array = context.make_helper(builder, typ)
+
+        str_arr_payload = cgutils.create_struct_proxy(dtype)(context, builder)
+        string_array.num_items = args[2]
+
+        fnty = lir.FunctionType(lir.VoidType(),
+                                [lir.IntType(8).as_pointer(), lir.IntType(64),
+                                 lir.IntType(32).as_pointer().as_pointer(),
+                                 lir.IntType(8).as_pointer().as_pointer(),
+                                 lir.IntType(8).as_pointer().as_pointer()])
+
+        fn = builder.module.get_or_insert_function(fnty, name="csv_read_string_column")
+        builder.call(fn, [args[0], args[1],
+                          str_arr_payload._get_ptr_by_name('offsets'),
+                          str_arr_payload._get_ptr_by_name('data'),
+                          str_arr_payload._get_ptr_by_name('null_bitmap')])
+        builder.store(str_arr_payload._getvalue(), meminfo_data_ptr)
+
+        string_array.meminfo = meminfo
+        string_array.offsets = str_arr_payload.offsets
+        string_array.data = str_arr_payload.data
+        string_array.null_bitmap = str_arr_payload.null_bitmap
+        string_array.num_total_chars = builder.zext(builder.load(
+            builder.gep(string_array.offsets, [string_array.num_items])), lir.IntType(64))
+        ret = string_array._getvalue()
+        return impl_ret_new_ref(context, builder, typ, ret)
+
+    return string_array_type(types.voidptr, types.int64, types.int64), codegen
+
+
+# column types of the native parser besides numeric CTypeEnum values (see _csv_parser.h)
+_CSV_COL_DATETIME = 100
+_CSV_COL_STRING = 101
+
+
+def _get_csv_col_type(t):
+    """native parser type of array type t, None if only pandas can parse it
+    """
+    if t == string_array_type:
+        return _CSV_COL_STRING
+    if t.dtype == types.NPDatetime('ns'):
+        return _CSV_COL_DATETIME
+    if isinstance(t.dtype, (types.Integer, types.Float)) and t.dtype in _numba_to_c_type_map:
+        return _numba_to_c_type_map[t.dtype]
+    return None
+
+
 def _get_dtype_str(t):
     dtype = t.dtype
     if isinstance(dtype, PDCategoricalDtype):
@@ -319,7 +428,11 @@ compiled_funcs = []
 
 
 def _gen_csv_reader_py(col_names, col_typs, usecols, sep, typingctx, targetctx, parallel, skiprows):
-    # TODO: support non-numpy types like strings
+    csv_col_types = [_get_csv_col_type(t) for t in col_typs]
+    if (hpat.config.config_csv_native_parser and len(sep) == 1
+            and all(t is not None for t in csv_col_types)):
+        return _gen_csv_reader_py_native(col_names, col_typs, csv_col_types, usecols, sep, parallel, skiprows)
+
     date_inds = ", ".join(str(i) for i, t in enumerate(col_typs) if t.dtype == types.NPDatetime('ns'))
     typ_strs = ", ".join(["{}='{}'".format(_sanitize_varname(cname), _get_dtype_str(t))
                           for cname, t in zip(col_names, col_typs)])
@@ -352,6 +465,250 @@ def _gen_csv_reader_py(col_names, col_typs, usecols, sep, typingctx, targetctx,
     return jit_func
 
 
+def _gen_csv_native_args_text(col_names, csv_col_types, usecols, sep, parallel, skiprows):
+    """generate usecols/col_types arrays and return the common arguments of the native parser entry points
+    """
+    func_text = "  usecols = np.array([{}], np.int64)\n".format(", ".join(str(c) for c in usecols))
+    func_text += "  col_types = np.array([{}], np.int32)\n".format(", ".join(str(t) for t in csv_col_types))
+    args = "fname._data, {}, {}, -1, np.int8({}), {}, usecols.ctypes, col_types.ctypes".format(
+        parallel, skiprows, ord(sep), len(col_names))
+    return func_text, args
+
+
+def _gen_csv_read_columns_text(col_names, col_typs):
+    """generate code copying the columns of parsed chunk csv_chunk to new arrays
+    """
+    func_text = "  n_rows = csv_get_num_rows(csv_chunk)\n"
+    for i, (cname, t) in enumerate(zip(col_names, col_typs)):
+        varname = _sanitize_varname(cname)
+        if t == string_array_type:
+            func_text += "  {} = csv_read_string_column(csv_chunk, {}, n_rows)\n".format(varname, i)
+            continue
+        dtype = 'dt64_dtype' if t.dtype == types.NPDatetime('ns') else 'np.{}'.format(t.dtype)
+        func_text += "  {} = np.empty(n_rows, {})\n".format(varname, dtype)
+        func_text += "  csv_read_column(csv_chunk, {}, {}.ctypes)\n".format(i, varname)
+    return func_text
+
+
+def _gen_csv_check_errors_text(parallel, del_chunk):
+    """generate code raising if parsed chunk csv_chunk could not be read or has values that could
+    not be parsed (on any rank if parallel), the errors are reported on the error output
+    """
+    func_text = "  n_errors = csv_get_num_errors(csv_chunk)\n"
+    # -1 errors if the chunk could not be read
+    func_text += "  n_failed = 1 if n_errors < 0 else 0\n"
+    func_text += "  n_errors = max(n_errors, 0)\n"
+    if parallel:
+        func_text += "  n_failed = hpat.distributed_api.dist_reduce(n_failed, np.int32(_sum_op))\n"
+        func_text += "  n_errors = hpat.distributed_api.dist_reduce(n_errors, np.int32(_sum_op))\n"
+    func_text += "  if n_failed != 0 or n_errors != 0:\n"
+    if del_chunk:
+        func_text += "    csv_del_chunk(csv_chunk)\n"
+    func_text += "    if n_failed != 0:\n"
+    func_text += "      raise IOError('read_csv(): file could not be read, see error output')\n"
+    func_text += "    raise ValueError('read_csv(): values could not be parsed as their column dtype, "
+    func_text += "see error output')\n"
+    return func_text
+
+
+# native reader functions by their code, which depends on the column names and types, usecols, sep etc.
+# read_csv_batches() calls and compilations of the same read reuse the compiled functions
+_csv_native_funcs = {}
+
+
+def _exec_csv_native_func(func_text, func_name):
+    # print(func_text)
+    if func_text in _csv_native_funcs:
+        return _csv_native_funcs[func_text]
+    glbls = {'np': np, 'hpat': hpat, 'dt64_dtype': np.dtype('datetime64[ns]'),
+             '_sum_op': hpat.distributed_api.Reduce_Type.Sum.value, 'csv_get_num_errors': csv_get_num_errors,
+             'csv_file_chunk_parse': csv_file_chunk_parse, 'csv_get_num_rows': csv_get_num_rows,
+             'csv_read_column': csv_read_column, 'csv_read_string_column': csv_read_string_column,
+             'csv_del_chunk': csv_del_chunk, 'csv_file_batch_reader': csv_file_batch_reader,
+             'csv_read_batch': csv_read_batch, 'csv_del_batch_reader': csv_del_batch_reader}
+    loc_vars = {}
+    exec(func_text, glbls, loc_vars)
+
+    jit_func = numba.njit(loc_vars[func_name])
+    _csv_native_funcs[func_text] = jit_func
+    return jit_func
+
+
+def _gen_csv_reader_py_native(col_names, col_typs, csv_col_types, usecols, sep, parallel, skiprows):
+    """generate reader parsing the chunk of this rank natively into column buffers
+    """
+    args_text, args = _gen_csv_native_args_text(col_names, csv_col_types, usecols, sep, parallel, skiprows)
+    func_text = "def csv_reader_py(fname):\n"
+    func_text += args_text
+    func_text += "  csv_chunk = csv_file_chunk_parse({}, {})\n".format(args, hpat.config.config_csv_num_threads)
+    func_text += _gen_csv_check_errors_text(parallel, True)
+    func_text += _gen_csv_read_columns_text(col_names, col_typs)
+    func_text += "  csv_del_chunk(csv_chunk)\n"
+    func_text += "  return ({},)\n".format(", ".join(_sanitize_varname(c) for c in col_names))
+
+    return _exec_csv_native_func(func_text, 'csv_reader_py')
+
+
+def _gen_csv_batch_reader_py(col_names, col_typs, csv_col_types, usecols, sep, parallel, skiprows, batch_size):
+    """generate functions opening a batch reader of the chunk of this rank and reading its next batch
+    """
+    args_text, args = _gen_csv_native_args_text(col_names, csv_col_types, usecols, sep, parallel, skiprows)
+    func_text = "def csv_open_py(fname):\n"
+    func_text += args_text
+    func_text += "  return csv_file_batch_reader({}, {})\n".format(args, batch_size)
+    open_func = _exec_csv_native_func(func_text, 'csv_open_py')
+
+    func_text = "def csv_read_batch_py(reader):\n"
+    func_text += "  csv_chunk = csv_read_batch(reader)\n"
+    # ranks read different numbers of batches, errors are only checked locally
+    func_text += _gen_csv_check_errors_text(False, False)
+    func_text += _gen_csv_read_columns_text(col_names, col_typs)
+    func_text += "  return n_rows, ({},)\n".format(", ".join(_sanitize_varname(c) for c in col_names))
+    read_func = _exec_csv_native_func(func_text, 'csv_read_batch_py')
+
+    return open_func, read_func
+
+
+@numba.njit
+def _del_csv_batch_reader(reader):
+    csv_del_batch_reader(reader)
+
+
+def read_csv_batches(fname, names, dtype, batch_size, usecols=None, sep=',', skiprows=0, parse_dates=(),
+                     parallel=False):
+    """Read a CSV file in DataFrames of at most batch_size rows.
+
+    Only a block of the file and one batch of rows are kept in memory at a time,
+    the next block is read in the background while a batch is consumed. Arguments
+    are like the ones of pd.read_csv(), every column needs a dtype (parse_dates
+    columns are datetime64[ns]). If parallel, each process iterates over its own
+    chunk of the file.
+    """
+    if usecols is None:
+        usecols = list(range(len(names)))
+    col_typs = []
+    for i, cname in enumerate(names):
+        if i in parse_dates or cname in parse_dates:
+            col_typs.append(types.Array(types.NPDatetime('ns'), 1, 'C'))
+        elif dtype[cname] == str:
+            col_typs.append(string_array_type)
+        else:
+            col_typs.append(types.Array(numba.from_dtype(np.dtype(dtype[cname])), 1, 'C'))
+    csv_col_types = [_get_csv_col_type(t) for t in col_typs]
+    if len(sep) != 1 or any(t is None for t in csv_col_types):
+        raise ValueError("read_csv_batches() supports single character separators and numeric, "
+                         "datetime and string columns only")
+
+    open_func, read_func = _gen_csv_batch_reader_py(
+        names, col_typs, csv_col_types, usecols, sep, parallel, skiprows, batch_size)
+    reader = open_func(fname)
+    # NULL reader, the error is reported on the error output
+    if reader == 0:
+        raise IOError("read_csv_batches(): file {} could not be read, see error output".format(fname))
+    try:
+        while True:
+            n_rows, arrs = read_func(reader)
+            if n_rows == 0:
+                break
+            yield pd.DataFrame(dict(zip(names, arrs)), columns=names)
+    finally:
+        _del_csv_batch_reader(reader)
+
+
+csv_writer_new = types.ExternalFunction(
+    "csv_writer_new", types.voidptr(types.int64, types.int64, types.int8))
+csv_writer_add_column = types.ExternalFunction(
+    "csv_writer_add_column", types.void(types.voidptr, types.int32, types.voidptr, types.int32))
+csv_datetime_column_resolution = types.ExternalFunction(
+    "csv_datetime_column_resolution", types.int32(types.voidptr, types.int64))
+csv_writer_format = types.ExternalFunction(
+    "csv_writer_format", types.int64(types.voidptr, types.voidptr, types.int64, types.int64))
+csv_writer_data = types.ExternalFunction("csv_writer_data", types.voidptr(types.voidptr))
+csv_del_writer = types.ExternalFunction("csv_del_writer", types.void(types.voidptr))
+
+
+@intrinsic
+def csv_writer_add_string_column(typingctx, writer_typ, str_arr_typ=None):
+    def codegen(context, builder, sig, args):
+        string_array = context.make_helper(builder, string_array_type, args[1])
+        fnty = lir.FunctionType(lir.VoidType(),
+                                [lir.IntType(8).as_pointer(), lir.IntType(32).as_pointer(),
+                                 lir.IntType(8).as_pointer(), lir.IntType(8).as_pointer()])
+        fn = builder.module.get_or_insert_function(fnty, name="csv_writer_add_string_column")
+        builder.call(fn, [args[0], string_array.offsets, string_array.data, string_array.null_bitmap])
+        return context.get_dummy_value()
+
+    return types.void(types.voidptr, string_array_type), codegen
+
+
+# bool column type of the native writer (see _csv_writer.h)
+_CSV_COL_BOOL = 102
+
+
+def _get_csv_write_col_type(t):
+    """native writer type of array type t, None if only pandas can format it
+    """
+    if t == string_array_type:
+        return _CSV_COL_STRING
+    if not (isinstance(t, types.Array) and t.ndim == 1 and t.layout == 'C'):
+        return None
+    if t.dtype == types.bool_:
+        return _CSV_COL_BOOL
+    return _get_csv_col_type(t)
+
+
+def _csv_quote_field(val, sep):
+    if sep in val or '"' in val or '\n' in val or '\r' in val:
+        return '"{}"'.format(val.replace('"', '""'))
+    return val
+
+
+def gen_csv_write_parallel(df_typ):
+    """generate function writing distributed dataframe df like df.to_csv(fname) with default
+    arguments: every rank formats its rows natively and writes them at its byte offset of the file.
+    Returns the function and its globals, None if a column type is not supported.
+    """
+    csv_col_types = [_get_csv_write_col_type(t) for t in df_typ.data]
+    if any(t is None for t in csv_col_types):
+        return None
+    header = ','.join([''] + [_csv_quote_field(str(c), ',') for c in df_typ.columns]) + '\n'
+
+    func_text = "def csv_write_py(fname, df):\n"
+    func_text += "  n_rows = len(df)\n"
+    func_text += "  writer = csv_writer_new(n_rows, hpat.distributed_api.dist_exscan(n_rows), np.int8({}))\n".format(
+        ord(','))
+    for i, t in enumerate(csv_col_types):
+        func_text += "  c{} = hpat.hiframes.pd_dataframe_ext.get_dataframe_data(df, {})\n".format(i, i)
+        if t == _CSV_COL_STRING:
+            func_text += "  csv_writer_add_string_column(writer, c{})\n".format(i)
+            continue
+        dt_reso = "np.int32(0)"
+        if t == _CSV_COL_DATETIME:
+            # the precision of datetimes depends on all values of the column
+            func_text += "  dt_reso{0} = hpat.distributed_api.dist_reduce(\n".format(i)
+            func_text += "    csv_datetime_column_resolution(c{}.ctypes, n_rows), np.int32(_max_op))\n".format(i)
+            dt_reso = "dt_reso{}".format(i)
+        func_text += "  csv_writer_add_column(writer, np.int32({}), c{}.ctypes, {})\n".format(t, i, dt_reso)
+    func_text += "  header_len = len(_header) if hpat.distributed_api.get_rank() == 0 else 0\n"
+    func_text += "  count = csv_writer_format(writer, _header.ctypes, header_len, {})\n".format(
+        hpat.config.config_csv_num_threads)
+    func_text += "  start = hpat.distributed_api.dist_exscan(count)\n"
+    func_text += "  hpat.io.np_io._file_write_parallel(fname._data, csv_writer_data(writer), start, count, 1)\n"
+    func_text += "  csv_del_writer(writer)\n"
+
+    # print(func_text)
+    glbls = {'np': np, 'hpat': hpat, '_header': np.frombuffer(header.encode(), np.uint8),
+             '_max_op': hpat.distributed_api.Reduce_Type.Max.value,
+             'csv_writer_new': csv_writer_new, 'csv_writer_add_column': csv_writer_add_column,
+             'csv_writer_add_string_column': csv_writer_add_string_column,
+             'csv_datetime_column_resolution': csv_datetime_column_resolution,
+             'csv_writer_format': csv_writer_format, 'csv_writer_data': csv_writer_data,
+             'csv_del_writer': csv_del_writer}
+    loc_vars = {}
+    exec(func_text, glbls, loc_vars)
+    return loc_vars['csv_write_py'], glbls
+
+
 def _sanitize_varname(varname):
     new_name = varname.replace('$', '_').replace('.', '_')
     if not new_name[0].isalpha():
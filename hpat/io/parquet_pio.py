@@ -2,10 +2,10 @@ from hpat.config import _has_pyarrow
 import llvmlite.binding as ll
 from llvmlite import ir as lir
 from numba.targets.arrayobj import make_array
-from numba.targets.imputils import lower_builtin
+from numba.targets.imputils import lower_builtin, lower_constant
 from numba import cgutils
 import numba
-from numba import ir, config, ir_utils, types
+from numba import ir, config, ir_utils, types, npdatetime
 from numba.ir_utils import (mk_unique_var, replace_vars_inner, find_topo_order,
                             dprint_func_ir, remove_dead, mk_alloc, remove_dels,
                             get_name_var_table, replace_var_names,
@@ -14,6 +14,7 @@ from numba.ir_utils import (mk_unique_var, replace_vars_inner, find_topo_order,
                             find_callname, guard, require, get_definition)
 
 from numba.typing.templates import infer_global, AbstractTemplate
+from numba.extending import intrinsic, overload, typeof_impl, register_model, models
 from numba.typing import signature
 from numba.targets.imputils import impl_ret_new_ref, impl_ret_borrowed
 import numpy as np
@@ -21,7 +22,9 @@ import hpat
 from hpat.str_ext import string_type, unicode_to_char_ptr
 from hpat.str_arr_ext import StringArray, StringArrayPayloadType, construct_string_array
 from hpat.str_arr_ext import string_array_type
-from hpat.utils import unliteral_all
+from hpat.utils import unliteral_all, _numba_to_c_type_map
+from hpat.hiframes.pd_categorical_ext import (PDCategoricalDtype, CategoricalArray,
+                                              get_categories_int_type)
 
 
 # from parquet/types.h
@@ -31,6 +34,39 @@ _type_to_pq_dtype_number = {'bool_': 0, 'int32': 1, 'int64': 2,
                             'int96': 3, 'float32': 4, 'float64': 5,
                             repr(types.NPDatetime('ns')): 3, 'int8': 6}
 
+# comparison operators of read_parquet() filters, PQ_FILTER_* in hpat_parquet_reader.cpp
+_pq_filter_ops = {'=': 0, '==': 0, '!=': 1, '<': 2, '<=': 3, '>': 4, '>=': 5}
+
+
+class PqCategories(object):
+    """constant argument of read_parquet_cat() calls holding the categorical dtype of the
+    column, which is only known at compile time. Its type carries the dtype so the call is
+    typed without a registry of dtypes.
+    """
+
+    def __init__(self, dtype):
+        self.dtype = dtype
+
+
+class PqCategoriesType(types.Opaque):
+    def __init__(self, dtype):
+        self.dtype = dtype
+        super(PqCategoriesType, self).__init__(name='PqCategoriesType({})'.format(dtype))
+
+
+register_model(PqCategoriesType)(models.OpaqueModel)
+
+
+@typeof_impl.register(PqCategories)
+def typeof_pq_categories(val, c):
+    return PqCategoriesType(val.dtype)
+
+
+@lower_constant(PqCategoriesType)
+def lower_pq_categories(context, builder, ty, pyval):
+    # categories are embedded in the read call, nothing to pass at runtime
+    return context.get_dummy_value()
+
 
 def read_parquet():
     return 0
@@ -52,6 +88,22 @@ def get_column_size_parquet():
     return 0
 
 
+def read_parquet_deferred():
+    return 0
+
+
+def add_parquet_filter():
+    return 0
+
+
+def read_parquet_cat():
+    return 0
+
+
+def read_parquet_cat_parallel():
+    return 0
+
+
 def remove_parquet(rhs, lives, call_list):
     # the call is dead if the read array is dead
     if call_list == [read_parquet] and rhs.args[2].name not in lives:
@@ -60,6 +112,8 @@ def remove_parquet(rhs, lives, call_list):
         return True
     if call_list == [read_parquet_str]:
         return True
+    if call_list == [read_parquet_cat]:
+        return True
     return False
 
 
@@ -76,7 +130,12 @@ class ParquetHandler(object):
         self.locals = _locals
         self.reverse_copies = _reverse_copies
 
-    def gen_parquet_read(self, file_name, lhs):
+    def gen_parquet_read(self, file_name, lhs, filters=(), categories=()):
+        """generate nodes reading all columns of the Parquet dataset. filters is a list of
+        (column name, operator, value variable or constant) which let the readers skip row
+        groups whose statistics exclude the predicate (rows still need filtering).
+        String columns in categories are read as categorical codes.
+        """
         scope = file_name.scope
         loc = file_name.loc
 
@@ -93,12 +152,14 @@ class ParquetHandler(object):
             convert_types = self.locals[self.reverse_copies[lhs.name] + ':convert']
             self.locals.pop(self.reverse_copies[lhs.name] + ':convert')
 
+        file_name_str = None
+        fname_def = guard(get_definition, self.func_ir, file_name)
+        if isinstance(fname_def, (ir.Const, ir.Global, ir.FreeVar)) and isinstance(fname_def.value, str):
+            file_name_str = fname_def.value
+
         if table_types is None:
-            fname_def = guard(get_definition, self.func_ir, file_name)
-            if (not isinstance(fname_def, (ir.Const, ir.Global, ir.FreeVar))
-                    or not isinstance(fname_def.value, str)):
+            if file_name_str is None:
                 raise ValueError("Parquet schema not available")
-            file_name_str = fname_def.value
             col_names, col_types = parquet_file_schema(file_name_str)
             # remove Pandas index if exists
             # TODO: handle index properly when indices are supported
@@ -108,10 +169,10 @@ class ParquetHandler(object):
             col_types = list(table_types.values())
 
         out_nodes = []
-        # get arrow readers once
+        # get arrow readers once, the distributed pass sets parallel if the reads are distributed
 
         def init_arrow_readers(fname):
-            arrow_readers = get_arrow_readers(unicode_to_char_ptr(fname))
+            arrow_readers = get_arrow_readers(unicode_to_char_ptr(fname), 0)
 
         f_block = compile_to_numba_ir(init_arrow_readers,
                                       {'get_arrow_readers': _get_arrow_readers,
@@ -122,12 +183,23 @@ class ParquetHandler(object):
         out_nodes += f_block.body[:-3]
         arrow_readers_var = out_nodes[-1].target
 
+        for cname, op, value in filters:
+            if cname not in col_names:
+                raise ValueError("Parquet filter column {} not found".format(cname))
+            out_nodes += get_filter_nodes(arrow_readers_var, col_names.index(cname), _pq_filter_ops[op], value)
+
         col_arrs = []
         for i, cname in enumerate(col_names):
             # get column type from schema
             c_type = col_types[i]
             if cname in convert_types:
                 c_type = convert_types[cname].dtype
+            if cname in categories:
+                if c_type != string_type:
+                    raise ValueError("Parquet categorical column {} is not a string column".format(cname))
+                if file_name_str is None:
+                    raise ValueError("Parquet categories of column {} not available".format(cname))
+                c_type = PDCategoricalDtype(parquet_column_categories(file_name_str, i))
 
             # create a variable for column and assign type
             varname = mk_unique_var(cname)
@@ -137,18 +209,46 @@ class ParquetHandler(object):
 
             out_nodes += get_column_read_nodes(c_type, cvar, arrow_readers_var, i)
 
-        # delete arrow readers
+        # read the columns recorded by the read calls in one pass, delete arrow readers
         def cleanup_arrow_readers(readers):
+            s = read_parquet_deferred(readers)
+            s = del_arrow_readers(readers)
+
+        # categorical reads fail on values not in the compile-time categories
+        def cleanup_arrow_readers_cat(readers):
+            s = read_parquet_deferred(readers)
+            s = pq_check_cat_errors(readers)
             s = del_arrow_readers(readers)
 
-        f_block = compile_to_numba_ir(cleanup_arrow_readers,
-                                      {'del_arrow_readers': _del_arrow_readers,
+        f_block = compile_to_numba_ir(cleanup_arrow_readers_cat if categories else cleanup_arrow_readers,
+                                      {'read_parquet_deferred': read_parquet_deferred,
+                                       'pq_check_cat_errors': pq_check_cat_errors,
+                                       'del_arrow_readers': _del_arrow_readers,
                                        }).blocks.popitem()[1]
         replace_arg_nodes(f_block, [arrow_readers_var])
         out_nodes += f_block.body[:-3]
         return col_names, col_arrs, out_nodes
 
 
+def get_filter_nodes(arrow_readers_var, col_ind, op, value):
+    # value is a variable or a constant
+    args = [arrow_readers_var]
+    glbls = {'add_parquet_filter': add_parquet_filter}
+    if isinstance(value, ir.Var):
+        func_text = 'def f(arrow_readers, value):\n'
+        args.append(value)
+    else:
+        func_text = 'def f(arrow_readers):\n'
+        glbls['value'] = value
+    func_text += '  s = add_parquet_filter(arrow_readers, {}, {}, value)\n'.format(col_ind, op)
+
+    loc_vars = {}
+    exec(func_text, {}, loc_vars)
+    f_block = compile_to_numba_ir(loc_vars['f'], glbls).blocks.popitem()[1]
+    replace_arg_nodes(f_block, args)
+    return f_block.body[:-3]
+
+
 def get_column_read_nodes(c_type, cvar, arrow_readers_var, i):
 
     loc = cvar.loc
@@ -156,7 +256,10 @@ def get_column_read_nodes(c_type, cvar, arrow_readers_var, i):
     func_text = 'def f(arrow_readers):\n'
     func_text += '  col_size = get_column_size_parquet(arrow_readers, {})\n'.format(i)
     # generate strings differently
-    if c_type == string_type:
+    if isinstance(c_type, PDCategoricalDtype):
+        # strings are looked up in the categories while reading, no string array is built
+        func_text += '  column = read_parquet_cat(arrow_readers, {}, col_size, pq_categories)\n'.format(i)
+    elif c_type == string_type:
         # pass size for easier allocation and distributed analysis
         func_text += '  column = read_parquet_str(arrow_readers, {}, col_size)\n'.format(
             i)
@@ -179,6 +282,8 @@ def get_column_read_nodes(c_type, cvar, arrow_readers_var, i):
                                      {'get_column_size_parquet': get_column_size_parquet,
                                       'read_parquet': read_parquet,
                                       'read_parquet_str': read_parquet_str,
+                                      'read_parquet_cat': read_parquet_cat,
+                                      'pq_categories': PqCategories(c_type),
                                       'np': np,
                                       'hpat': hpat,
                                       'StringArray': StringArray}).blocks.popitem()
@@ -250,6 +355,15 @@ def parquet_file_schema(file_name):
     return col_names, col_types
 
 
+def parquet_column_categories(file_name, col_ind):
+    """categories of a string column (in order of first appearance, like Pandas categories
+    from the data), read from the dictionary pages of the column chunks instead of decoding
+    the column
+    """
+    from .. import parquet_cpp
+    return parquet_cpp.get_column_categories(file_name, col_ind)
+
+
 def _rm_pd_index(col_names, col_types):
     """remove pandas index if found in columns
     """
@@ -261,8 +375,20 @@ def _rm_pd_index(col_names, col_types):
         pass
 
 
-_get_arrow_readers = types.ExternalFunction("get_arrow_readers", types.Opaque('arrow_reader')(types.voidptr))
+_get_arrow_readers = types.ExternalFunction("get_arrow_readers",
+                                            types.Opaque('arrow_reader')(types.voidptr, types.int64))
 _del_arrow_readers = types.ExternalFunction("del_arrow_readers", types.void(types.Opaque('arrow_reader')))
+_pq_get_num_errors = types.ExternalFunction("pq_get_num_errors", types.int64(types.Opaque('arrow_reader')))
+
+
+@numba.njit
+def pq_check_cat_errors(readers):
+    """raise if categorical reads found values not in the categories, which are taken from
+    the data at compile time. All ranks of parallel reads raise together.
+    """
+    if _pq_get_num_errors(readers) != 0:
+        raise ValueError("read_parquet(): values not in the categories of their column, see error output")
+    return 0
 
 
 @infer_global(get_column_size_parquet)
@@ -284,6 +410,22 @@ class ReadParquetInfer(AbstractTemplate):
         return signature(types.int64, *unliteral_all(args))
 
 
+@infer_global(read_parquet_deferred)
+class ReadParquetDeferredInfer(AbstractTemplate):
+    def generic(self, args, kws):
+        assert not kws
+        assert len(args) == 1
+        return signature(types.int32, *unliteral_all(args))
+
+
+@infer_global(add_parquet_filter)
+class AddParquetFilterInfer(AbstractTemplate):
+    def generic(self, args, kws):
+        assert not kws
+        assert len(args) == 4
+        return signature(types.int32, *unliteral_all(args))
+
+
 @infer_global(read_parquet_str)
 class ReadParquetStrInfer(AbstractTemplate):
     def generic(self, args, kws):
@@ -300,6 +442,27 @@ class ReadParquetStrParallelInfer(AbstractTemplate):
         return signature(string_array_type, *unliteral_all(args))
 
 
+def _get_pq_cat_array_type(cats_typ):
+    assert isinstance(cats_typ, PqCategoriesType)
+    return CategoricalArray(cats_typ.dtype)
+
+
+@infer_global(read_parquet_cat)
+class ReadParquetCatInfer(AbstractTemplate):
+    def generic(self, args, kws):
+        assert not kws
+        assert len(args) == 4
+        return signature(_get_pq_cat_array_type(args[3]), *unliteral_all(args[:3]), args[3])
+
+
+@infer_global(read_parquet_cat_parallel)
+class ReadParquetCatParallelInfer(AbstractTemplate):
+    def generic(self, args, kws):
+        assert not kws
+        assert len(args) == 5
+        return signature(_get_pq_cat_array_type(args[4]), *unliteral_all(args[:4]), args[4])
+
+
 @infer_global(read_parquet_parallel)
 class ReadParallelParquetInfer(AbstractTemplate):
     def generic(self, args, kws):
@@ -318,6 +481,21 @@ if _has_pyarrow:
     ll.add_symbol('pq_get_size', parquet_cpp.get_size)
     ll.add_symbol('pq_read_string', parquet_cpp.read_string)
     ll.add_symbol('pq_read_string_parallel', parquet_cpp.read_string_parallel)
+    ll.add_symbol('pq_read_parallel_row_groups', parquet_cpp.read_parallel_row_groups)
+    ll.add_symbol('pq_read_string_parallel_row_groups', parquet_cpp.read_string_parallel_row_groups)
+    ll.add_symbol('pq_read_columns_parallel', parquet_cpp.read_columns_parallel)
+    ll.add_symbol('pq_defer_read', parquet_cpp.defer_read)
+    ll.add_symbol('pq_read_deferred', parquet_cpp.read_deferred)
+    ll.add_symbol('pq_add_filter', parquet_cpp.add_filter)
+    ll.add_symbol('pq_read_categorical', parquet_cpp.read_categorical)
+    ll.add_symbol('pq_get_num_errors', parquet_cpp.get_num_errors)
+    ll.add_symbol('pq_writer_new', parquet_cpp.writer_new)
+    ll.add_symbol('pq_writer_add_column', parquet_cpp.writer_add_column)
+    ll.add_symbol('pq_writer_add_string_column', parquet_cpp.writer_add_string_column)
+    ll.add_symbol('pq_writer_write', parquet_cpp.writer_write)
+    ll.add_symbol('pq_write_metadata', parquet_cpp.write_metadata)
+    ll.add_symbol('pq_write_clean_dir', parquet_cpp.write_clean_dir)
+    ll.add_symbol('pq_del_writer', parquet_cpp.del_writer)
 
 
 @lower_builtin(get_column_size_parquet, types.Opaque('arrow_reader'), types.intp)
@@ -328,6 +506,63 @@ def pq_size_lower(context, builder, sig, args):
     return builder.call(fn, args)
 
 
+def _gen_pq_defer_read(builder, reader, cindex, data_ptr, out_dtype, start, count):
+    """record the column read in the readers, read_parquet_deferred() reads all recorded
+    columns in one pass over the row groups
+    """
+    fnty = lir.FunctionType(lir.IntType(64),
+                            [lir.IntType(8).as_pointer(), lir.IntType(64),
+                             lir.IntType(8).as_pointer(),
+                             lir.IntType(32), lir.IntType(64), lir.IntType(64)])
+    fn = builder.module.get_or_insert_function(fnty, name="pq_defer_read")
+    return builder.call(fn, [reader, cindex,
+                             builder.bitcast(data_ptr, lir.IntType(8).as_pointer()),
+                             out_dtype, start, count])
+
+
+@lower_builtin(read_parquet_deferred, types.Opaque('arrow_reader'))
+def pq_read_deferred_lower(context, builder, sig, args):
+    fnty = lir.FunctionType(lir.IntType(32),
+                            [lir.IntType(8).as_pointer(), lir.IntType(32),
+                             lir.IntType(32), lir.IntType(64)])
+    fn = builder.module.get_or_insert_function(fnty, name="pq_read_deferred")
+    row_group_dist = context.get_constant(types.int32, int(hpat.config.config_pq_row_group_dist))
+    prefetch_depth = context.get_constant(types.int32, hpat.config.config_pq_prefetch_depth)
+    prefetch_max_bytes = context.get_constant(types.int64, hpat.config.config_pq_prefetch_max_bytes)
+    return builder.call(fn, [args[0], row_group_dist, prefetch_depth, prefetch_max_bytes])
+
+
+@lower_builtin(add_parquet_filter, types.Opaque('arrow_reader'), types.intp, types.intp, types.Any)
+def pq_add_filter_lower(context, builder, sig, args):
+    val_typ = sig.args[3]
+    is_float = 0
+    int_value = context.get_constant(types.int64, 0)
+    float_value = context.get_constant(types.float64, 0.0)
+    if isinstance(val_typ, types.Float):
+        is_float = 1
+        float_value = context.cast(builder, args[3], val_typ, types.float64)
+    elif isinstance(val_typ, (types.Integer, types.Boolean)):
+        int_value = context.cast(builder, args[3], val_typ, types.int64)
+    elif (isinstance(val_typ, types.NPDatetime)
+            and npdatetime.get_timedelta_conversion_factor(val_typ.unit, 'ns') is not None):
+        # datetime64 columns are read as nanoseconds
+        factor = npdatetime.get_timedelta_conversion_factor(val_typ.unit, 'ns')
+        int_value = builder.mul(args[3], context.get_constant(types.int64, factor))
+    else:
+        # no row groups skipped, rows are filtered after the read
+        return context.get_constant(types.int32, 0)
+
+    fnty = lir.FunctionType(lir.IntType(32),
+                            [lir.IntType(8).as_pointer(), lir.IntType(64),
+                             lir.IntType(32), lir.IntType(32),
+                             lir.IntType(64), lir.DoubleType()])
+    fn = builder.module.get_or_insert_function(fnty, name="pq_add_filter")
+    return builder.call(fn, [args[0], args[1],
+                             builder.trunc(args[2], lir.IntType(32)),
+                             context.get_constant(types.int32, is_float),
+                             int_value, float_value])
+
+
 @lower_builtin(read_parquet, types.Opaque('arrow_reader'), types.intp, types.Array, types.int32)
 def pq_read_lower(context, builder, sig, args):
     fnty = lir.FunctionType(lir.IntType(64),
@@ -335,6 +570,12 @@ def pq_read_lower(context, builder, sig, args):
                              lir.IntType(8).as_pointer()], lir.IntType(32))
     out_array = make_array(sig.args[2])(context, builder, args[2])
 
+    if hpat.config.config_pq_multi_column_read:
+        # all rows of the column
+        return _gen_pq_defer_read(builder, args[0], args[1], out_array.data, args[3],
+                                  context.get_constant(types.int64, 0),
+                                  context.get_constant(types.int64, -1))
+
     fn = builder.module.get_or_insert_function(fnty, name="pq_read")
     return builder.call(fn, [args[0], args[1],
                              builder.bitcast(
@@ -357,7 +598,12 @@ def pq_read_parallel_lower(context, builder, sig, args):
                              lir.IntType(32), lir.IntType(64), lir.IntType(64)])
     out_array = make_array(sig.args[2])(context, builder, args[2])
 
-    fn = builder.module.get_or_insert_function(fnty, name="pq_read_parallel")
+    if hpat.config.config_pq_multi_column_read:
+        res = _gen_pq_defer_read(builder, args[0], args[1], out_array.data, args[3], args[4], args[5])
+        return builder.trunc(res, lir.IntType(32))
+
+    fname = "pq_read_parallel_row_groups" if hpat.config.config_pq_row_group_dist else "pq_read_parallel"
+    fn = builder.module.get_or_insert_function(fnty, name=fname)
     return builder.call(fn, [args[0], args[1],
                              builder.bitcast(
                                  out_array.data, lir.IntType(8).as_pointer()),
@@ -416,8 +662,8 @@ def pq_read_string_parallel_lower(context, builder, sig, args):
                              lir.IntType(8).as_pointer().as_pointer(),
                              lir.IntType(64), lir.IntType(64)])
 
-    fn = builder.module.get_or_insert_function(
-        fnty, name="pq_read_string_parallel")
+    fname = "pq_read_string_parallel_row_groups" if hpat.config.config_pq_row_group_dist else "pq_read_string_parallel"
+    fn = builder.module.get_or_insert_function(fnty, name=fname)
     res = builder.call(fn, [args[0], args[1],
                             str_arr_payload._get_ptr_by_name('offsets'),
                             str_arr_payload._get_ptr_by_name('data'),
@@ -435,3 +681,200 @@ def pq_read_string_parallel_lower(context, builder, sig, args):
         builder.gep(string_array.offsets, [string_array.num_items])), lir.IntType(64))
     ret = string_array._getvalue()
     return impl_ret_new_ref(context, builder, typ, ret)
+
+
+# read string columns as categorical codes
+
+
+def _gen_pq_read_cat(context, builder, cat_arr_typ, reader, cindex, start, count):
+    """allocate the codes array and read rows [start, start+count), count=-1 is not
+    supported since the array is allocated here
+    """
+    cats = cat_arr_typ.dtype.categories
+    int_typ = types.Array(get_categories_int_type(cat_arr_typ.dtype), 1, 'C')
+    codes = numba.targets.arrayobj._empty_nd_impl(context, builder, int_typ, [count])
+
+    # categories as constant characters and offsets
+    cat_bytes = [c.encode('utf-8') for c in cats]
+    cat_offsets = np.zeros(len(cats) + 1, np.uint32)
+    cat_offsets[1:] = np.cumsum([len(c) for c in cat_bytes])
+    cat_chars = np.frombuffer(b''.join(cat_bytes) + b'\0', np.uint8)
+    chars_typ = types.Array(types.uint8, 1, 'C')
+    offsets_typ = types.Array(types.uint32, 1, 'C')
+    chars_arr = make_array(chars_typ)(
+        context, builder, context.make_constant_array(builder, chars_typ, cat_chars))
+    offsets_arr = make_array(offsets_typ)(
+        context, builder, context.make_constant_array(builder, offsets_typ, cat_offsets))
+
+    fnty = lir.FunctionType(lir.IntType(32),
+                            [lir.IntType(8).as_pointer(), lir.IntType(64),
+                             lir.IntType(8).as_pointer(), lir.IntType(32),
+                             lir.IntType(8).as_pointer(), lir.IntType(32).as_pointer(),
+                             lir.IntType(64), lir.IntType(64), lir.IntType(64)])
+    fn = builder.module.get_or_insert_function(fnty, name="pq_read_categorical")
+    builder.call(fn, [reader, cindex,
+                      builder.bitcast(codes.data, lir.IntType(8).as_pointer()),
+                      context.get_constant(types.int32, int_typ.dtype.bitwidth // 8),
+                      chars_arr.data, offsets_arr.data,
+                      context.get_constant(types.int64, len(cats)),
+                      start, count])
+    return impl_ret_new_ref(context, builder, cat_arr_typ, codes._getvalue())
+
+
+@lower_builtin(read_parquet_cat, types.Opaque('arrow_reader'), types.intp, types.intp, PqCategoriesType)
+def pq_read_cat_lower(context, builder, sig, args):
+    return _gen_pq_read_cat(context, builder, sig.return_type, args[0], args[1],
+                            context.get_constant(types.int64, 0), args[2])
+
+
+@lower_builtin(read_parquet_cat_parallel, types.Opaque('arrow_reader'), types.intp, types.intp, types.intp,
+               PqCategoriesType)
+def pq_read_cat_parallel_lower(context, builder, sig, args):
+    return _gen_pq_read_cat(context, builder, sig.return_type, args[0], args[1], args[2], args[3])
+
+
+# parallel write of distributed dataframes, every rank writes a part file of the output
+# directory (see _parquet_writer.h)
+
+pq_writer_new = types.ExternalFunction("pq_writer_new", types.voidptr(types.int64))
+pq_writer_add_column = types.ExternalFunction(
+    "pq_writer_add_column", types.void(types.voidptr, types.voidptr, types.int32, types.voidptr))
+pq_writer_write = types.ExternalFunction(
+    "pq_writer_write", types.int32(types.voidptr, types.voidptr, types.int32, types.int64, types.int32))
+pq_write_metadata = types.ExternalFunction("pq_write_metadata", types.int32(types.voidptr, types.int32))
+pq_write_clean_dir = types.ExternalFunction("pq_write_clean_dir", types.int32(types.voidptr))
+pq_del_writer = types.ExternalFunction("pq_del_writer", types.void(types.voidptr))
+
+
+@intrinsic
+def pq_writer_add_string_column(typingctx, writer_typ, name_typ, str_arr_typ=None):
+    def codegen(context, builder, sig, args):
+        string_array = context.make_helper(builder, string_array_type, args[2])
+        fnty = lir.FunctionType(lir.VoidType(),
+                                [lir.IntType(8).as_pointer(), lir.IntType(8).as_pointer(),
+                                 lir.IntType(32).as_pointer(), lir.IntType(8).as_pointer(),
+                                 lir.IntType(8).as_pointer()])
+        fn = builder.module.get_or_insert_function(fnty, name="pq_writer_add_string_column")
+        builder.call(fn, [args[0], args[1], string_array.offsets, string_array.data, string_array.null_bitmap])
+        return context.get_dummy_value()
+
+    return types.void(types.voidptr, types.voidptr, string_array_type), codegen
+
+
+# column types of the native writer other than HPAT C types (see _parquet_writer.h)
+_PQ_WRITE_COL_BOOL = 102
+_PQ_WRITE_COL_DATETIME = 103
+_PQ_WRITE_COL_STRING = 104
+
+# parquet::Compression::type values
+_pq_compression_codes = {None: 0, 'snappy': 1, 'gzip': 2, 'brotli': 4, 'lz4': 5, 'zstd': 6}
+
+_min_op = hpat.distributed_api.Reduce_Type.Min.value
+
+
+def _get_pq_write_col_type(t):
+    """native writer type of array type t, None if only pandas can write it
+    """
+    if t == string_array_type:
+        return _PQ_WRITE_COL_STRING
+    if not (isinstance(t, types.Array) and t.ndim == 1 and t.layout == 'C'):
+        return None
+    if t.dtype == types.bool_:
+        return _PQ_WRITE_COL_BOOL
+    if t.dtype == types.NPDatetime('ns'):
+        return _PQ_WRITE_COL_DATETIME
+    return _numba_to_c_type_map.get(t.dtype, None)
+
+
+def gen_parquet_write_parallel(df_typ, compression='snappy'):
+    """generate function writing the rows of distributed dataframe df of every rank as
+    a part file of directory fname, and a _metadata file of all parts on rank 0.
+    Returns the function and its globals, None if the native writer doesn't support
+    the dataframe (an index, column types or compression).
+    """
+    pq_col_types = [_get_pq_write_col_type(t) for t in df_typ.data]
+    if (df_typ.index != types.none or any(t is None for t in pq_col_types)
+            or compression not in _pq_compression_codes):
+        return None
+
+    glbls = {'np': np, 'hpat': hpat,
+             'pq_writer_new': pq_writer_new, 'pq_writer_add_column': pq_writer_add_column,
+             'pq_writer_add_string_column': pq_writer_add_string_column,
+             'pq_writer_write': pq_writer_write, 'pq_write_metadata': pq_write_metadata,
+             'pq_del_writer': pq_del_writer, 'pq_write_begin': pq_write_begin, 'pq_write_end': pq_write_end}
+    func_text = "def pq_write_py(fname, df):\n"
+    func_text += "  rank = hpat.distributed_api.get_rank()\n"
+    func_text += "  err = pq_write_begin(fname, rank)\n"
+    func_text += "  writer = pq_writer_new(len(df))\n"
+    for i, t in enumerate(pq_col_types):
+        # column names as null-terminated constant arrays
+        glbls['_name{}'.format(i)] = np.frombuffer(str(df_typ.columns[i]).encode() + b'\0', np.uint8)
+        func_text += "  c{} = hpat.hiframes.pd_dataframe_ext.get_dataframe_data(df, {})\n".format(i, i)
+        if t == _PQ_WRITE_COL_STRING:
+            func_text += "  pq_writer_add_string_column(writer, _name{0}.ctypes, c{0})\n".format(i)
+        else:
+            func_text += "  pq_writer_add_column(writer, _name{0}.ctypes, np.int32({1}), c{0}.ctypes)\n".format(i, t)
+    func_text += "  if err == 0:\n"
+    func_text += "    err = pq_writer_write(writer, fname._data, rank, {}, np.int32({}))\n".format(
+        hpat.config.config_pq_write_row_group_size, _pq_compression_codes[compression])
+    func_text += "  pq_del_writer(writer)\n"
+    func_text += "  pq_write_end(fname, rank, err, True)\n"
+
+    loc_vars = {}
+    exec(func_text, glbls, loc_vars)
+    return loc_vars['pq_write_py'], glbls
+
+
+@numba.njit
+def pq_write_begin(fname, rank):
+    """remove the files of a previous write to directory fname on rank 0 before any
+    rank writes its part, returns the error status of the removal
+    """
+    err = np.int32(0)
+    if rank == 0:
+        err = pq_write_clean_dir(fname._data)
+    hpat.distributed_api.barrier()
+    return err
+
+
+@numba.njit
+def pq_write_end(fname, rank, err, write_metadata):
+    """once all parts are written, write the _metadata summary of their row groups on
+    rank 0 and raise on all ranks if any rank failed
+    """
+    err = hpat.distributed_api.dist_reduce(err, np.int32(_min_op))
+    if write_metadata and err == 0 and rank == 0:
+        err = pq_write_metadata(fname._data, hpat.distributed_api.get_size())
+    err = hpat.distributed_api.dist_reduce(err, np.int32(_min_op))
+    if err != 0:
+        raise RuntimeError("to_parquet() failed, see error output")
+
+
+def to_parquet_part(df, fname, compression, rank):  # pragma: no cover
+    return 0
+
+
+def _write_parquet_part(df, fname, compression, rank):
+    import os
+    import sys
+    try:
+        os.makedirs(fname, exist_ok=True)
+        df.to_parquet(os.path.join(fname, 'part-{:05d}.parquet'.format(rank)),
+                      compression=compression, index=False)
+    except Exception as e:
+        print("parquet write: {}".format(e), file=sys.stderr)
+        return -1
+    return 0
+
+
+@overload(to_parquet_part)
+def to_parquet_part_overload(df, fname, compression, rank):
+    """write the rows of this rank as a part file of directory fname using pandas,
+    for dataframes the native writer doesn't support
+    """
+    def _impl(df, fname, compression, rank):
+        with numba.objmode(err='int32'):
+            err = _write_parquet_part(df, fname, compression, rank)
+        return err
+
+    return _impl
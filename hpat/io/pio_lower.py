@@ -38,6 +38,29 @@ if hpat.config._has_h5py:
 
 h5g_close = types.ExternalFunction("h5g_close", types.none(h5group_type))
 
+# HDF5 filter ids of compression names, as registered with The HDF Group
+_h5_filter_ids = {
+    'gzip': 1,
+    'szip': 4,
+    'lzf': 32000,
+    'blosc': 32001,
+    'lz4': 32004,
+    'bzip2': 307,
+    'zstd': 32015,
+}
+
+
+def _get_h5_write_filter():
+    """filter id of config_h5_write_compression, 0 for no compression"""
+    compression = hpat.config.config_h5_write_compression
+    if not compression:
+        return 0
+    if compression.isdigit():
+        return int(compression)
+    if compression not in _h5_filter_ids:
+        raise ValueError("unknown HDF5 compression {}".format(compression))
+    return _h5_filter_ids[compression]
+
 
 @lower_builtin(operator.getitem, h5file_type, string_type)
 @lower_builtin(operator.getitem, h5dataset_or_group_type, string_type)
@@ -123,10 +146,11 @@ def h5_create_dset(context, builder, sig, args):
     dset_name = gen_get_unicode_chars(context, builder, dset_name)
     dtype_str = gen_get_unicode_chars(context, builder, dtype_str)
 
-    # extra last arg type for type enum
+    # extra args for type enum and the filter, compression level, shuffle and chunk size
     arg_typs = [h5file_lir_type, lir.IntType(8).as_pointer(), lir.IntType(32),
                 lir.IntType(64).as_pointer(),
-                lir.IntType(32)]
+                lir.IntType(32), lir.IntType(32), lir.IntType(32), lir.IntType(32),
+                lir.IntType(64)]
     fnty = lir.FunctionType(h5file_lir_type, arg_typs)
 
     fn = builder.module.get_or_insert_function(
@@ -144,9 +168,14 @@ def h5_create_dset(context, builder, sig, args):
         t_fnty, name="hpat_h5_get_type_enum")
     typ_arg = builder.call(t_fn, [dtype_str])
 
+    # layout and compression of created datasets are set by config at compile time
     call_args = [fg_id, dset_name, ndims_arg,
                  builder.bitcast(count_ptr, lir.IntType(64).as_pointer()),
-                 typ_arg]
+                 typ_arg,
+                 lir.Constant(lir.IntType(32), _get_h5_write_filter()),
+                 lir.Constant(lir.IntType(32), hpat.config.config_h5_write_compression_level),
+                 lir.Constant(lir.IntType(32), int(hpat.config.config_h5_write_shuffle)),
+                 lir.Constant(lir.IntType(64), hpat.config.config_h5_write_chunk_bytes)]
 
     return builder.call(fn, call_args)
 
@@ -25,7 +25,10 @@ from hpat.str_arr_ext import StringArray, StringArrayPayloadType, construct_stri
 
 def remove_xenon(rhs, lives, call_list):
     # the call is dead if the read array is dead
-    if call_list == [read_xenon_col] and rhs.args[3].name not in lives:
+    # the call is dead if all the read arrays are dead
+    if call_list == [read_xenon_columns] and all(v.name not in lives for v in rhs.args[4:]):
+        return True
+    if call_list == [read_xenon_columns_parallel] and all(v.name not in lives for v in rhs.args[6:]):
         return True
     if call_list == [get_column_size_xenon]:
         return True
@@ -50,10 +53,10 @@ def _handle_read(assign, lhs, rhs, func_ir):
     # TODO: init only once
     from .. import hxe_ext
     ll.add_symbol('get_column_size_xenon', hxe_ext.get_column_size_xenon)
-    ll.add_symbol('c_read_xenon', hxe_ext.read_xenon_col)
-    ll.add_symbol('c_read_xenon_parallel', hxe_ext.read_xenon_col_parallel)
+    ll.add_symbol('c_read_xenon_columns', hxe_ext.read_xenon_columns)
     ll.add_symbol('c_read_xenon_col_str', hxe_ext.read_xenon_col_str)
     ll.add_symbol('c_read_xenon_col_str_parallel', hxe_ext.read_xenon_col_str_parallel)
+    ll.add_symbol('c_xe_drop_read_ahead', hxe_ext.xe_drop_read_ahead)
     ll.add_symbol('c_xe_connect', hxe_ext.c_xe_connect)
     ll.add_symbol('c_xe_open', hxe_ext.c_xe_open)
     ll.add_symbol('c_xe_close', hxe_ext.c_xe_close)
@@ -87,17 +90,26 @@ def _handle_read(assign, lhs, rhs, func_ir):
     scope = rhs.args[0].scope
     loc = rhs.args[0].loc
 
+    # all columns are read in one pass over the dataset: the numeric columns are allocated and
+    # read by one read_xenon_columns() call, which reads the string columns ahead for their
+    # read_xenon_str() calls
     col_items = []
-    for i, cname in enumerate(col_names):
-        # get column type from schema
-        c_type = col_types[i]
-
-        # create a variable for column and assign type
+    for cname in col_names:
+        # create a variable for column
         varname = mk_unique_var(cname)
         cvar = ir.Var(scope, varname, loc)
         col_items.append((cname, cvar))
 
-        out_nodes += get_column_read_nodes(c_type, cvar, xe_connect_var, xe_dset_var, i, schema_arr_var)
+    num_cols = [(i, cvar) for i, (_, cvar) in enumerate(col_items) if col_types[i] != string_array_type]
+    str_cols = [(i, cvar) for i, (_, cvar) in enumerate(col_items) if col_types[i] == string_array_type]
+    for i, cvar in num_cols:
+        out_nodes += get_column_read_nodes(col_types[i], cvar, xe_connect_var, xe_dset_var, i, schema_arr_var)
+    if num_cols:
+        out_nodes += gen_read_columns_xenon(num_cols, xe_connect_var, xe_dset_var, schema_arr_var)
+    for i, cvar in str_cols:
+        out_nodes += get_column_read_nodes(col_types[i], cvar, xe_connect_var, xe_dset_var, i, schema_arr_var)
+    if str_cols:
+        out_nodes += gen_drop_read_ahead_xenon(xe_connect_var, xe_dset_var)
 
     # we need to close in the URI case since we opened the connection/dataset
     if len(rhs.args) == 1:
@@ -169,7 +181,7 @@ def get_column_read_nodes(c_type, cvar, xe_connect_var, xe_dset_var, i, schema_a
     loc = cvar.loc
 
     func_text = ('def f(xe_connect_var, xe_dset_var, schema_arr):\n')
-    func_text = ('    col_size = get_column_size_xenon(xe_connect_var, xe_dset_var, {})\n'. format(i))
+    func_text += ('  col_size = get_column_size_xenon(xe_connect_var, xe_dset_var, {})\n'. format(i))
     # func_text += '  print(col_size)\n'
     # generate strings differently since upfront allocation is not possible
     if c_type == string_array_type:
@@ -177,14 +189,13 @@ def get_column_read_nodes(c_type, cvar, xe_connect_var, xe_dset_var, i, schema_a
         func_text += '  column = read_xenon_str(xe_connect_var, xe_dset_var, {}, col_size, schema_arr)\n'.format(i)
     else:
         el_type = get_element_type(c_type.dtype)
+        # read by read_xenon_columns() with the other numeric columns
         func_text += '  column = np.empty(col_size, dtype=np.{})\n'.format(el_type)
-        func_text += '  status = read_xenon_col(xe_connect_var, xe_dset_var, {}, column, schema_arr)\n'.format(i)
     loc_vars = {}
     exec(func_text, {}, loc_vars)
     size_func = loc_vars['f']
     _, f_block = compile_to_numba_ir(size_func,
                                      {'get_column_size_xenon': get_column_size_xenon,
-                                      'read_xenon_col': read_xenon_col,
                                       'read_xenon_str': read_xenon_str,
                                       'np': np,
                                       }).blocks.popitem()
@@ -227,6 +238,36 @@ def gen_init_xenon(address, dset_name):
     return out_nodes, connect_var, dset_t_var
 
 
+def gen_read_columns_xenon(cols, connect_var, dset_t_var, schema_arr_var):
+    # the arrays are arguments of the read to keep them alive until it fills them
+    col_args = ", ".join("c{}".format(i) for i, _ in cols)
+    func_text = 'def f(connect_var, dset_t_var, schema_arr, {}):\n'.format(col_args)
+    func_text += '  col_ids = np.array([{}])\n'.format(", ".join(str(i) for i, _ in cols))
+    func_text += '  s = read_xenon_columns(connect_var, dset_t_var, schema_arr, col_ids, {})\n'.format(col_args)
+    loc_vars = {}
+    exec(func_text, {}, loc_vars)
+    read_func = loc_vars['f']
+    f_block = compile_to_numba_ir(read_func,
+                                  {'read_xenon_columns': read_xenon_columns,
+                                   'np': np}).blocks.popitem()[1]
+
+    replace_arg_nodes(f_block, [connect_var, dset_t_var, schema_arr_var] + [cvar for _, cvar in cols])
+    out_nodes = f_block.body[:-3]
+    return out_nodes
+
+
+def gen_drop_read_ahead_xenon(connect_var, dset_t_var):
+    def drop_func(connect_var, dset_t_var):
+        s = xe_drop_read_ahead(connect_var, dset_t_var)
+
+    f_block = compile_to_numba_ir(drop_func,
+                                  {'xe_drop_read_ahead': xe_drop_read_ahead}).blocks.popitem()[1]
+
+    replace_arg_nodes(f_block, [connect_var, dset_t_var])
+    out_nodes = f_block.body[:-3]
+    return out_nodes
+
+
 def gen_close_xenon(connect_var, dset_t_var):
     #
     def close_func(connect_var, dset_t_var):
@@ -279,48 +320,52 @@ get_column_size_xenon = types.ExternalFunction(
 xe_connect = types.ExternalFunction("c_xe_connect", xe_connect_type(types.voidptr))
 xe_open = types.ExternalFunction("c_xe_open", xe_dset_type(xe_connect_type, types.voidptr))
 xe_close = types.ExternalFunction("c_xe_close", types.void(xe_connect_type, xe_dset_type))
+xe_drop_read_ahead = types.ExternalFunction("c_xe_drop_read_ahead", types.void(xe_connect_type, xe_dset_type))
+
+
+def _gen_read_xenon_columns(context, builder, args, col_tps, schema_arr_tp, col_ids_tp, start, count):
+    ctinfo = context.make_array(schema_arr_tp)(context, builder, value=args[2])
+    col_ids_info = context.make_array(col_ids_tp)(context, builder, value=args[3])
+    n_cols = len(col_tps)
+    col_data = cgutils.alloca_once(builder, lir.IntType(8).as_pointer(), size=n_cols)
+    for i, (col_tp, col) in enumerate(zip(col_tps, args[-n_cols:])):
+        arr_info = context.make_array(col_tp)(context, builder, value=col)
+        builder.store(builder.bitcast(arr_info.data, lir.IntType(8).as_pointer()),
+                      builder.gep(col_data, [context.get_constant(types.intp, i)]))
+    fnty = lir.FunctionType(lir.VoidType(),
+                            [lir.IntType(8).as_pointer(),
+                             lir.IntType(8).as_pointer(),
+                             lir.IntType(64).as_pointer(),
+                             lir.IntType(64).as_pointer(),
+                             lir.IntType(64),
+                             lir.IntType(8).as_pointer().as_pointer(),
+                             lir.IntType(64),
+                             lir.IntType(64)])
+
+    fn = builder.module.get_or_insert_function(fnty, name="c_read_xenon_columns")
+    builder.call(fn, [args[0], args[1], ctinfo.data, col_ids_info.data,
+                      context.get_constant(types.int64, n_cols), col_data, start, count])
+    return context.get_dummy_value()
 
 
 # TODO: fix liveness/alias in Numba to be able to use arr.ctypes directly
 @intrinsic
-def read_xenon_col(typingctx, connect_tp, dset_tp, col_id_tp, column_tp, schema_arr_tp):
+def read_xenon_columns(typingctx, connect_tp, dset_tp, schema_arr_tp, col_ids_tp, *col_tps):
     def codegen(context, builder, sig, args):
-        arr_info = context.make_array(column_tp)(context, builder, value=args[3])
-        ctinfo = context.make_array(schema_arr_tp)(context, builder, value=args[4])
-        fnty = lir.FunctionType(lir.VoidType(),
-                                [lir.IntType(8).as_pointer(),
-                                 lir.IntType(8).as_pointer(),
-                                 lir.IntType(64),
-                                 lir.IntType(8).as_pointer(),
-                                 lir.IntType(64).as_pointer()])
-
-        fn = builder.module.get_or_insert_function(fnty, name="c_read_xenon")
-        res = builder.call(fn, [args[0], args[1], args[2],
-                                builder.bitcast(arr_info.data, lir.IntType(8).as_pointer()), ctinfo.data])
-        return context.get_dummy_value()
-    return signature(types.none, connect_tp, dset_tp, col_id_tp, column_tp, schema_arr_tp), codegen
+        # all rows
+        return _gen_read_xenon_columns(context, builder, args, col_tps, schema_arr_tp, col_ids_tp,
+                                       context.get_constant(types.int64, 0), context.get_constant(types.int64, -1))
+    return signature(types.none, connect_tp, dset_tp, schema_arr_tp, col_ids_tp, *col_tps), codegen
 
 
 @intrinsic
-def read_xenon_col_parallel(typingctx, connect_tp, dset_tp, col_id_tp, column_tp, schema_arr_tp, start_tp, count_tp):
+def read_xenon_columns_parallel(typingctx, connect_tp, dset_tp, schema_arr_tp, col_ids_tp, start_tp, count_tp,
+                                *col_tps):
     def codegen(context, builder, sig, args):
-        arr_info = context.make_array(column_tp)(context, builder, value=args[3])
-        ctinfo = context.make_array(schema_arr_tp)(context, builder, value=args[4])
-        fnty = lir.FunctionType(lir.VoidType(),
-                                [lir.IntType(8).as_pointer(),
-                                 lir.IntType(8).as_pointer(),
-                                 lir.IntType(64),
-                                 lir.IntType(8).as_pointer(),
-                                 lir.IntType(64).as_pointer(),
-                                 lir.IntType(64),
-                                 lir.IntType(64)])
-
-        fn = builder.module.get_or_insert_function(fnty, name="c_read_xenon_parallel")
-        res = builder.call(fn, [args[0], args[1], args[2],
-                                builder.bitcast(arr_info.data, lir.IntType(8).as_pointer()), ctinfo.data,
-                                args[5], args[6]])
-        return context.get_dummy_value()
-    return signature(types.none, connect_tp, dset_tp, col_id_tp, column_tp, schema_arr_tp, start_tp, count_tp), codegen
+        return _gen_read_xenon_columns(context, builder, args, col_tps, schema_arr_tp, col_ids_tp,
+                                       args[4], args[5])
+    return signature(types.none, connect_tp, dset_tp, schema_arr_tp, col_ids_tp, start_tp, count_tp,
+                     *col_tps), codegen
 
 
 @intrinsic
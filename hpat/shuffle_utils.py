@@ -49,8 +49,9 @@ ShuffleMeta = namedtuple('ShuffleMeta',
 
 # before shuffle, 'send_counts' is needed as well as
 # 'send_counts_char' and 'send_arr_lens' for every string type
+# counts and displacements are int64 since c_alltoallv exchanges more than 2^31 elements
 def alloc_pre_shuffle_metadata(arr, data, n_pes, is_contig):
-    return PreShuffleMeta(np.zeros(n_pes, np.int32), ())
+    return PreShuffleMeta(np.zeros(n_pes, np.int64), ())
 
 
 @overload(alloc_pre_shuffle_metadata)
@@ -58,7 +59,7 @@ def alloc_pre_shuffle_metadata_overload(key_arrs, data, n_pes, is_contig):
 
     func_text = "def f(key_arrs, data, n_pes, is_contig):\n"
     # send_counts
-    func_text += "  send_counts = np.zeros(n_pes, np.int32)\n"
+    func_text += "  send_counts = np.zeros(n_pes, np.int64)\n"
 
     # send_counts_char, send_arr_lens for strings
     n_keys = len(key_arrs.types)
@@ -66,7 +67,7 @@ def alloc_pre_shuffle_metadata_overload(key_arrs, data, n_pes, is_contig):
     for i, typ in enumerate(key_arrs.types + data.types):
         if typ == string_array_type:
             func_text += ("  arr = key_arrs[{}]\n".format(i) if i < n_keys else "  arr = data[{}]\n".format(i - n_keys))
-            func_text += "  send_counts_char_{} = np.zeros(n_pes, np.int32)\n".format(n_str)
+            func_text += "  send_counts_char_{} = np.zeros(n_pes, np.int64)\n".format(n_str)
             func_text += "  send_arr_lens_{} = np.empty(1, np.uint32)\n".format(n_str)
             # needs allocation since written in update before finalize
             func_text += "  if is_contig:\n"
@@ -126,8 +127,8 @@ def finalize_shuffle_meta_overload(key_arrs, data, pre_shuffle_meta, n_pes, is_c
     func_text = "def f(key_arrs, data, pre_shuffle_meta, n_pes, is_contig, init_vals=()):\n"
     # common metas: send_counts, recv_counts, tmp_offset, n_out, n_send, send_disp, recv_disp
     func_text += "  send_counts = pre_shuffle_meta.send_counts\n"
-    func_text += "  recv_counts = np.empty(n_pes, np.int32)\n"
-    func_text += "  tmp_offset = np.zeros(n_pes, np.int32)\n"  # for non-contig
+    func_text += "  recv_counts = np.empty(n_pes, np.int64)\n"
+    func_text += "  tmp_offset = np.zeros(n_pes, np.int64)\n"  # for non-contig
     func_text += "  hpat.distributed_api.alltoall(send_counts, recv_counts, 1)\n"
     func_text += "  n_out = recv_counts.sum()\n"
     func_text += "  n_send = send_counts.sum()\n"
@@ -157,7 +158,7 @@ def finalize_shuffle_meta_overload(key_arrs, data, pre_shuffle_meta, n_pes, is_c
             func_text += "  send_buff_{} = None\n".format(i)
             # send/recv counts
             func_text += "  send_counts_char_{} = pre_shuffle_meta.send_counts_char_tup[{}]\n".format(n_str, n_str)
-            func_text += "  recv_counts_char_{} = np.empty(n_pes, np.int32)\n".format(n_str)
+            func_text += "  recv_counts_char_{} = np.empty(n_pes, np.int64)\n".format(n_str)
             func_text += ("  hpat.distributed_api.alltoall("
                           "send_counts_char_{}, recv_counts_char_{}, 1)\n").format(n_str, n_str)
             # alloc output
@@ -170,7 +171,7 @@ def finalize_shuffle_meta_overload(key_arrs, data, pre_shuffle_meta, n_pes, is_c
                           "calc_disp(recv_counts_char_{})\n").format(n_str, n_str)
 
             # tmp_offset_char, send_arr_lens
-            func_text += "  tmp_offset_char_{} = np.zeros(n_pes, np.int32)\n".format(n_str)
+            func_text += "  tmp_offset_char_{} = np.zeros(n_pes, np.int64)\n".format(n_str)
             func_text += "  send_arr_lens_{} = pre_shuffle_meta.send_arr_lens_tup[{}]\n".format(n_str, n_str)
             # send char arr
             # TODO: arr refcount if arr is not stored somewhere?
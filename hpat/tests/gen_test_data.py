@@ -114,6 +114,12 @@ def generate_other_data():
     with open("csv_data_date1.csv", "w") as f:
         f.write(data)
 
+    # test_csv_threads_parallel1, large enough to be split into sub-chunks
+    data = ''.join('{0},{0}.5,"s{1}\n,x"\n'.format(i, i % 7) for i in range(150000))
+
+    with open("csv_data_large1.csv", "w") as f:
+        f.write(data)
+
     # generated data for parallel merge_asof testing
     df1 = pd.DataFrame({'time': pd.DatetimeIndex(
         ['2017-01-03', '2017-01-06', '2017-02-15', '2017-02-21']),
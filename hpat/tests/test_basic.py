@@ -484,6 +484,34 @@ class TestBasic(BaseTest):
             A, B, _ = hpat_func3(arr_len)
             np.testing.assert_allclose(A, B)
 
+    def test_permuted_array_indexing_rounds(self):
+        # with a tiny shuffle buffer the rows are sent in many rounds of one or
+        # two rows. The permutation can't be compared against NumPy (see
+        # test_permuted_array_indexing), so the rows of A and B are checked to
+        # move together and A to be a permutation of its values.
+        def test_impl(arr_len):
+            A = np.arange(arr_len)
+            B = np.arange(2 * arr_len).reshape(arr_len, 2)
+            P = np.random.permutation(arr_len)
+            A, B = A[P], B[P]
+            return A, B, A.sum(), (A * A).sum()
+
+        max_bytes = hpat.config.config_shuffle_max_bytes
+        hpat.config.config_shuffle_max_bytes = 32
+        try:
+            hpat_func = hpat.jit(locals={'A:return': 'distributed',
+                                         'B:return': 'distributed'})(test_impl)
+            for arr_len in [11, 111, 128]:
+                A, B, s1, s2 = hpat_func(arr_len)
+                begin, end = self._rank_bounds(arr_len)
+                self.assertEqual(len(A), end - begin)
+                np.testing.assert_array_equal(B[:, 0], 2 * A)
+                np.testing.assert_array_equal(B[:, 1], 2 * A + 1)
+                self.assertEqual(s1, np.arange(arr_len).sum())
+                self.assertEqual(s2, (np.arange(arr_len) ** 2).sum())
+        finally:
+            hpat.config.config_shuffle_max_bytes = max_bytes
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -1,10 +1,14 @@
 import unittest
+import os
 import platform
+import shutil
+import ctypes
 import pandas as pd
 from pandas.api.types import CategoricalDtype
 import numpy as np
 import h5py
 import pyarrow.parquet as pq
+import pyarrow as pa
 import hpat
 from hpat.tests.test_utils import (count_array_REPs, count_parfor_REPs,
                                    count_parfor_OneDs, count_array_OneDs, dist_IR_contains, get_rank,
@@ -27,6 +31,12 @@ class TestIO(unittest.TestCase):
             f.create_dataset('test', data=A)
             f.close()
 
+            # test_h5_filter_runs1
+            A = np.arange(5000 * 3, dtype=np.float64).reshape(5000, 3)
+            f = h5py.File('h5_test_filter_runs.h5', "w")
+            f.create_dataset('test', data=A)
+            f.close()
+
             # test_csv_cat1
             data = ("2,B,SA\n"
                     "3,A,SBC\n"
@@ -45,6 +55,55 @@ class TestIO(unittest.TestCase):
             with open("csv_data_dtype1.csv", "w") as f:
                 f.write(data)
 
+            # test_csv_quoted_newline_parallel1
+            data = ('1,"A\nB",2.5\n'
+                    '2,"C",3.5\n'
+                    '3,"D\n\nE",1.0\n'
+                    '4,"F""G",0.5\n'
+                    '5,"H,\nI",4.0\n')
+
+            with open("csv_data_quoted1.csv", "w") as f:
+                f.write(data)
+
+            # test_pq_filters_ne_missing1, row groups of constant values with a null and a NaN
+            A = pa.array([1.0, None, 1.0, np.nan, 1.0, 1.0, 2.0, 3.0], from_pandas=False)
+            pq.write_table(pa.Table.from_arrays([A], ['A']), 'pq_filter_ne.parquet', row_group_size=2)
+
+            # test_pq_str_nulls_row_groups1, row groups of 5 rows (appended at offsets that are not
+            # multiples of 8) alternating between having nulls and having no validity bitmap
+            A = pa.array([None if (i // 5) % 2 == 0 and i % 3 == 0 else 'ab' * (i % 4) for i in range(47)])
+            pq.write_table(pa.Table.from_arrays([A], ['A']), 'pq_str_nulls.parquet', row_group_size=5)
+
+            # test_pq_categorical_unknown1, dictionary encoded in several row groups, categories
+            # in order of first appearance (not sorted)
+            A = pa.array(['b', 'a', None, 'b', 'c', 'a'])
+            pq.write_table(pa.Table.from_arrays([A], ['A']), 'pq_cat_unknown.parquet', row_group_size=4)
+
+            # test_csv_nan_parallel1
+            data = ("1,2.5,ab\n"
+                    "2,,\n"
+                    "3,NaN,cd\n"
+                    "\n"
+                    "4,1.5,ab\n")
+
+            with open("csv_data_nan1.csv", "w") as f:
+                f.write(data)
+
+            # test_csv_errors_parallel1, int column with a missing and an out of range value
+            data = ("1,2019-01-01\n"
+                    ",2019-01-02\n"
+                    "99999999999999999999,2019-01-03\n")
+
+            with open("csv_data_errors1.csv", "w") as f:
+                f.write(data)
+
+            # test_csv_errors_parallel2, date which is not ISO 8601
+            data = ("1,2019-01-01\n"
+                    "2,01/02/2019\n")
+
+            with open("csv_data_errors2.csv", "w") as f:
+                f.write(data)
+
             # test_np_io1
             n = 111
             A = np.random.ranf(n)
@@ -114,6 +173,32 @@ class TestIO(unittest.TestCase):
         np.testing.assert_almost_equal(X, np.ones((N, D)))
         np.testing.assert_almost_equal(Y, np.arange(N) + 1.0)
 
+    def test_h5_write_compressed1(self):
+        def test_impl(N, D):
+            points = np.arange(N * D).reshape(N, D) % 7 + 1.0
+            f = h5py.File("lr_w_gzip.hdf5", "w")
+            dset1 = f.create_dataset("points", (N, D), dtype='f8')
+            dset1[:] = points
+            f.close()
+            return points
+
+        N = 1001
+        D = 10
+        compression = hpat.config.config_h5_write_compression
+        hpat.config.config_h5_write_compression = 'gzip'
+        try:
+            hpat_func = hpat.jit(test_impl)
+            hpat_func(N, D)
+        finally:
+            hpat.config.config_h5_write_compression = compression
+        f = h5py.File("lr_w_gzip.hdf5", "r")
+        self.assertEqual(f['points'].compression, 'gzip')
+        self.assertTrue(f['points'].shuffle)
+        self.assertEqual(f['points'].maxshape, (None, D))
+        X = f['points'][:]
+        f.close()
+        np.testing.assert_almost_equal(X, np.arange(N * D).reshape(N, D) % 7 + 1.0)
+
     @unittest.skip("fix collective create dataset and group")
     def test_h5_write_group(self):
         def test_impl(n, fname):
@@ -195,6 +280,20 @@ class TestIO(unittest.TestCase):
         start, end = get_start_end(n)
         np.testing.assert_allclose(hpat_func(), test_impl()[start:end])
 
+    def test_h5_filter_runs1(self):
+        def test_impl(m):
+            f = h5py.File("h5_test_filter_runs.h5", "r")
+            b = np.arange(5000) % m == 0
+            X = f['test'][b, :]
+            f.close()
+            return X
+
+        hpat_func = hpat.jit(locals={'X:return': 'distributed'})(test_impl)
+        # sparse rows are read as a hyperslab union, every other row densely
+        for m in [97, 2]:
+            start, end = get_start_end(len(test_impl(m)))
+            np.testing.assert_allclose(hpat_func(m), test_impl(m)[start:end])
+
     @unittest.skip('Error - fix needed\n'
                    'NUMA_PES=3 build')
     def test_pq_read(self):
@@ -296,6 +395,120 @@ class TestIO(unittest.TestCase):
         self.assertEqual(count_array_REPs(), 0)
         self.assertEqual(count_parfor_REPs(), 0)
 
+    def test_pq_str_nulls_row_groups1(self):
+        def test_impl():
+            df = pq.read_table('pq_str_nulls.parquet').to_pandas()
+            return df.A
+
+        def test_impl_par():
+            df = pq.read_table('pq_str_nulls.parquet').to_pandas()
+            return df.A.isna().sum()
+
+        hpat_func = hpat.jit(test_impl)
+        pd.testing.assert_series_equal(hpat_func(), test_impl(), check_names=False)
+        hpat_func = hpat.jit(test_impl_par)
+        self.assertEqual(hpat_func(), test_impl_par())
+        self.assertEqual(count_array_REPs(), 0)
+
+    def test_pq_row_group_dist1(self):
+        def test_impl():
+            df = pq.read_table('example2.parquet').to_pandas()
+            return df.four.sum(), (df.five.values == 'foo').sum()
+
+        # the distribution is picked when the function is compiled
+        row_group_dist = hpat.config.config_pq_row_group_dist
+        hpat.config.config_pq_row_group_dist = True
+        try:
+            hpat_func = hpat.jit(test_impl)
+            np.testing.assert_almost_equal(hpat_func(), test_impl())
+        finally:
+            hpat.config.config_pq_row_group_dist = row_group_dist
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
+    def test_pq_metadata_cache1(self):
+        def test_impl():
+            df = pq.read_table('example2.parquet').to_pandas()
+            return df.four.sum(), (df.five.values == 'foo').sum()
+
+        # the first call writes the cache, the second one reads footers from it
+        cache_dir = hpat.config.config_pq_metadata_cache_dir
+        hpat.config.config_pq_metadata_cache_dir = 'pq_metadata_cache'
+        try:
+            hpat_func = hpat.jit(test_impl)
+            np.testing.assert_almost_equal(hpat_func(), test_impl())
+            np.testing.assert_almost_equal(hpat_func(), test_impl())
+        finally:
+            hpat.config.config_pq_metadata_cache_dir = cache_dir
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
+    def test_pq_multi_column_read1(self):
+        def test_impl():
+            df = pq.read_table('example2.parquet').to_pandas()
+            return df.four.sum(), (df.one.values == 2.5).sum(), (df.five.values == 'foo').sum()
+
+        hpat_func = hpat.jit(test_impl)
+        np.testing.assert_almost_equal(hpat_func(), test_impl())
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
+    def test_pq_filters1(self):
+        def test_impl(v):
+            df = pd.read_parquet('example2.parquet', filters=[('four', '>', v), ('four', '<=', 10)])
+            return df.four.sum(), len(df)
+
+        def test_impl_pd(v):
+            df = pd.read_parquet('example2.parquet')
+            df = df[(df.four > v) & (df.four <= 10)]
+            return df.four.sum(), len(df)
+
+        hpat_func = hpat.jit(test_impl)
+        np.testing.assert_almost_equal(hpat_func(3.5), test_impl_pd(3.5))
+        self.assertEqual(count_array_REPs(), 0)
+
+    def test_pq_filters_ne_missing1(self):
+        def test_impl():
+            df = pd.read_parquet('pq_filter_ne.parquet', filters=[('A', '!=', 1.0)])
+            return len(df), df.A.isna().sum()
+
+        def test_impl_pd():
+            df = pd.read_parquet('pq_filter_ne.parquet')
+            df = df[df.A != 1.0]
+            return len(df), df.A.isna().sum()
+
+        hpat_func = hpat.jit(test_impl)
+        self.assertEqual(hpat_func(), test_impl_pd())
+
+    def test_pq_categorical1(self):
+        def test_impl():
+            df = pq.read_table('example2.parquet').to_pandas(categories=['two'])
+            return df.two
+
+        hpat_func = hpat.jit(test_impl)
+        pd.testing.assert_series_equal(hpat_func(), test_impl(), check_names=False)
+
+    def test_pq_categorical_unknown1(self):
+        def test_impl():
+            df = pq.read_table('pq_cat_unknown.parquet').to_pandas(categories=['A'])
+            return df.A
+
+        def barrier_impl():
+            return hpat.distributed_api.barrier()
+
+        hpat_func = hpat.jit(test_impl)
+        barrier = hpat.jit(barrier_impl)
+        pd.testing.assert_series_equal(hpat_func(), test_impl(), check_names=False)
+
+        # categories are fixed at compile time, a value added afterwards is an error
+        barrier()
+        if get_rank() == 0:
+            A = pa.array(['b', 'a', None, 'b', 'd', 'a'])
+            pq.write_table(pa.Table.from_arrays([A], ['A']), 'pq_cat_unknown.parquet', row_group_size=4)
+        barrier()
+        with self.assertRaises(ValueError):
+            hpat_func()
+
     @unittest.skip('Error - fix needed\n'
                    'NUMA_PES=3 build')
     def test_pq_bool(self):
@@ -512,6 +725,131 @@ class TestIO(unittest.TestCase):
         hpat_func = hpat.jit(locals={'df:return': 'distributed'})(test_impl)
         self.assertEqual(hpat_func(), test_impl())
 
+    def test_csv_quoted_newline_parallel1(self):
+        def test_impl():
+            df = pd.read_csv("csv_data_quoted1.csv",
+                             names=['A', 'B', 'C'],
+                             dtype={'A': np.int, 'B': str, 'C': np.float})
+            return (df.A.sum(), (df.B == 'D\n\nE').sum(), df.C.sum())
+        hpat_func = hpat.jit(test_impl)
+        self.assertEqual(hpat_func(), test_impl())
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
+    def test_csv_nan_parallel1(self):
+        def test_impl():
+            df = pd.read_csv("csv_data_nan1.csv",
+                             names=['A', 'B', 'C'],
+                             dtype={'A': np.int, 'B': np.float, 'C': str})
+            return (df.A.sum(), df.B.sum(), (df.C == 'ab').sum())
+        hpat_func = hpat.jit(test_impl)
+        self.assertEqual(hpat_func(), test_impl())
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
+    def test_csv_errors_parallel1(self):
+        def test_impl():
+            df = pd.read_csv("csv_data_errors1.csv", names=['A', 'B'], dtype={'A': np.int64, 'B': str},
+                             parse_dates=[1])
+            return df.A.sum()
+        hpat_func = hpat.jit(test_impl)
+        with self.assertRaises(ValueError):
+            hpat_func()
+
+    def test_csv_errors_parallel2(self):
+        def test_impl():
+            df = pd.read_csv("csv_data_errors2.csv", names=['A', 'B'], dtype={'A': np.int64, 'B': str},
+                             parse_dates=[1])
+            return df.B.max()
+        hpat_func = hpat.jit(test_impl)
+        with self.assertRaises(ValueError):
+            hpat_func()
+
+    def test_csv_quotechar1(self):
+        # only the default quote character splits lines and fields
+        def test_impl():
+            df = pd.read_csv("csv_data1.csv", names=['A', 'B', 'C', 'D'],
+                             dtype={'A': np.int, 'B': np.float, 'C': np.float, 'D': np.int}, quotechar="'")
+            return df.A.sum()
+        with self.assertRaises(ValueError):
+            hpat.jit(test_impl)()
+
+    def test_csv_missing_file_parallel1(self):
+        def test_impl():
+            df = pd.read_csv("csv_data_missing1.csv", names=['A', 'B'], dtype={'A': np.int64, 'B': np.float64})
+            return df.A.sum()
+        hpat_func = hpat.jit(test_impl)
+        with self.assertRaises(IOError):
+            hpat_func()
+
+    def test_csv_threads_parallel1(self):
+        def test_impl():
+            df = pd.read_csv("csv_data_large1.csv",
+                             names=['A', 'B', 'C'],
+                             dtype={'A': np.int, 'B': np.float, 'C': str})
+            return (df.A.sum(), df.B.sum(), (df.C == 's3\n,x').sum())
+        num_threads = hpat.config.config_csv_num_threads
+        hpat.config.config_csv_num_threads = 4
+        try:
+            hpat_func = hpat.jit(test_impl)
+            self.assertEqual(hpat_func(), test_impl())
+        finally:
+            hpat.config.config_csv_num_threads = num_threads
+
+    def test_csv_batches1(self):
+        names = ['A', 'B', 'C', 'D']
+        dtype = {'A': np.int64, 'B': np.float64, 'C': str, 'D': np.int64}
+        batches = list(hpat.io.csv_ext.read_csv_batches(
+            "csv_data_date1.csv", names, dtype, 2, parse_dates=[2]))
+        df = pd.read_csv("csv_data_date1.csv", names=names, dtype=dtype, parse_dates=[2])
+        self.assertTrue(all(len(b) <= 2 for b in batches))
+        pd.testing.assert_frame_equal(pd.concat(batches, ignore_index=True), df)
+
+    def test_csv_batches_cache1(self):
+        # repeated calls reuse the compiled reader functions
+        names = ['A', 'B', 'C', 'D']
+        dtype = {'A': np.int64, 'B': np.float64, 'C': str, 'D': np.int64}
+        list(hpat.io.csv_ext.read_csv_batches("csv_data_date1.csv", names, dtype, 3, parse_dates=[2]))
+        n_funcs = len(hpat.io.csv_ext._csv_native_funcs)
+        batches = list(hpat.io.csv_ext.read_csv_batches("csv_data_date1.csv", names, dtype, 3, parse_dates=[2]))
+        self.assertEqual(len(hpat.io.csv_ext._csv_native_funcs), n_funcs)
+        df = pd.read_csv("csv_data_date1.csv", names=names, dtype=dtype, parse_dates=[2])
+        pd.testing.assert_frame_equal(pd.concat(batches, ignore_index=True), df)
+
+    def test_csv_batches_missing_file1(self):
+        names = ['A', 'B']
+        dtype = {'A': np.int64, 'B': np.float64}
+        with self.assertRaises(IOError):
+            list(hpat.io.csv_ext.read_csv_batches("csv_data_missing1.csv", names, dtype, 2))
+
+    def test_csv_pandas_parser1(self):
+        def test_impl():
+            return pd.read_csv("csv_data_date1.csv",
+                               names=['A', 'B', 'C', 'D'],
+                               dtype={'A': np.int64, 'B': np.float, 'C': str, 'D': np.int64},
+                               parse_dates=[2])
+        native_parser = hpat.config.config_csv_native_parser
+        hpat.config.config_csv_native_parser = False
+        try:
+            hpat_func = hpat.jit(test_impl)
+            pd.testing.assert_frame_equal(hpat_func(), test_impl())
+        finally:
+            hpat.config.config_csv_native_parser = native_parser
+
+    def test_csv_stream_reader_buffer1(self):
+        # the StreamReader of a file chunk is mmapped and supports buffer/readinto access
+        chunk_reader = ctypes.PYFUNCTYPE(ctypes.py_object, ctypes.c_char_p, ctypes.c_bool, ctypes.c_int64,
+                                         ctypes.c_int64)(hpat.hio.csv_file_chunk_reader)
+        reader = chunk_reader(b"csv_data1.csv", False, 0, -1)
+        with open("csv_data1.csv", "rb") as f:
+            data = f.read()
+        self.assertEqual(bytes(memoryview(reader)), data)
+        buff = bytearray(10)
+        self.assertEqual(reader.readinto(buff), 10)
+        self.assertEqual(bytes(buff), data[:10])
+        self.assertEqual(reader.readbytes(), data[10:])
+        self.assertEqual(reader.read(), '')
+
     def test_csv_usecols1(self):
         def test_impl():
             return pd.read_csv("csv_data1.csv",
@@ -581,8 +919,6 @@ class TestIO(unittest.TestCase):
         # TODO: delete files
         pd.testing.assert_frame_equal(pd.read_csv(hp_fname), pd.read_csv(pd_fname))
 
-    @unittest.skip('AttributeError: Failed in hpat mode pipeline (step: convert to distributed)\n'
-                   'module \'hpat.hio\' has no attribute \'file_write_parallel\'')
     def test_write_csv_parallel1(self):
         def test_impl(n, fname):
             df = pd.DataFrame({'A': np.arange(n)})
@@ -601,6 +937,66 @@ class TestIO(unittest.TestCase):
             pd.testing.assert_frame_equal(
                 pd.read_csv(hp_fname), pd.read_csv(pd_fname))
 
+    def test_write_csv_parallel_types1(self):
+        def test_impl(df, fname):
+            df.to_csv(fname)
+
+        hpat_func = hpat.jit(distributed={'df'})(test_impl)
+        n = 111
+        df = pd.DataFrame({'A': np.arange(n) / 7, 'B': np.arange(n, dtype=np.int32) - 50,
+                           'C': np.arange(n) % 3 == 0,
+                           'D': [np.nan if i % 5 == 0 else 'a,"b"' * (i % 4) for i in range(n)],
+                           'E': pd.date_range('2019-01-01', periods=n, freq='7h').values})
+        df.loc[::9, 'A'] = np.nan
+        start, end = get_start_end(n)
+        hp_fname = 'test_write_csv_types1_hpat_par.csv'
+        pd_fname = 'test_write_csv_types1_pd_par.csv'
+        hpat_func(df.iloc[start:end].reset_index(drop=True), hp_fname)
+        if get_rank() == 0:
+            test_impl(df, pd_fname)
+            with open(hp_fname) as f1, open(pd_fname) as f2:
+                self.assertEqual(f1.read(), f2.read())
+
+    def test_write_csv_parallel_line_breaks1(self):
+        def test_impl(df, fname):
+            # no arguments other than the file name, so rows are formatted natively
+            df.to_csv(fname)
+
+        hpat_func = hpat.jit(distributed={'df'})(test_impl)
+        n = 111
+        df = pd.DataFrame({'A\rx': np.arange(n),
+                           'B': ['a\rb' if i % 3 == 0 else ('c\r\nd' if i % 3 == 1 else 'e\nf') for i in range(n)]})
+        start, end = get_start_end(n)
+        hp_fname = 'test_write_csv_line_breaks1_hpat_par.csv'
+        hpat_func(df.iloc[start:end].reset_index(drop=True), hp_fname)
+        if get_rank() == 0:
+            # fields and names with line breaks are quoted, so rows read back intact
+            pd.testing.assert_frame_equal(pd.read_csv(hp_fname, index_col=0), df)
+
+    def test_write_parquet_parallel1(self):
+        def test_impl(df, fname):
+            df.to_parquet(fname)
+
+        hpat_func = hpat.jit(distributed={'df'})(test_impl)
+        n = 111
+        df = pd.DataFrame({'A': np.arange(n) / 7, 'B': np.arange(n, dtype=np.int32) - 50,
+                           'C': np.arange(n) % 3 == 0,
+                           'D': [np.nan if i % 5 == 0 else 'ab' * (i % 4) for i in range(n)],
+                           'E': pd.date_range('2019-01-01', periods=n, freq='7h').values})
+        start, end = get_start_end(n)
+        hp_fname = 'test_write_parquet1_hpat_par.pq'
+        if get_rank() == 0:
+            # parts of a previous write with more ranks are removed
+            os.makedirs(hp_fname, exist_ok=True)
+            df.iloc[:3].to_parquet(os.path.join(hp_fname, 'part-00999.parquet'), index=False)
+        try:
+            hpat_func(df.iloc[start:end].reset_index(drop=True), hp_fname)
+            if get_rank() == 0:
+                pd.testing.assert_frame_equal(pd.read_parquet(hp_fname), df)
+        finally:
+            if get_rank() == 0:
+                shutil.rmtree(hp_fname, ignore_errors=True)
+
     def test_np_io1(self):
         def test_impl():
             A = np.fromfile("np_file1.dat", np.float64)
@@ -194,6 +194,47 @@ class TestJoin(unittest.TestCase):
         self.assertEqual(count_array_REPs(), 0)
         self.assertEqual(count_parfor_REPs(), 0)
 
+    def test_join_parallel_hash1(self):
+        # negative and strided keys of different int types, and string keys
+        def test_impl(df1, df2):
+            df3 = pd.merge(df1, df2, on=('A', 'S'))
+            return (df3.B.sum(), df3.C.sum(), len(df3))
+
+        hpat_func = hpat.jit(distributed=['df1', 'df2'])(test_impl)
+        n = 111
+        df1 = pd.DataFrame({'A': -1024 * (np.arange(n) % 13),
+                            'S': [str(i % 7) for i in range(n)],
+                            'B': np.arange(n) + 1.0})
+        df2 = pd.DataFrame({'A': (-1024 * (np.arange(n) % 11)).astype(np.int32),
+                            'S': [str(i % 5) for i in range(n)],
+                            'C': np.arange(n) + 2})
+        start1, end1 = get_start_end(len(df1))
+        start2, end2 = get_start_end(len(df2))
+        self.assertEqual(
+            hpat_func(df1.iloc[start1:end1], df2.iloc[start2:end2]),
+            test_impl(df1, df2))
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
+    def test_join_skew_parallel1(self):
+        # a few keys have most rows of the left table
+        def test_impl(df1, df2):
+            df3 = pd.merge(df1, df2, on='A', how='left')
+            return (df3.B.sum(), df3.C.sum(), len(df3))
+
+        hpat_func = hpat.jit(distributed=['df1', 'df2'])(test_impl)
+        n = 1000
+        A1 = np.where(np.arange(n) % 10 < 6, np.arange(n) % 3, np.arange(n))
+        df1 = pd.DataFrame({'A': A1, 'B': np.arange(n) + 1.0})
+        df2 = pd.DataFrame({'A': np.arange(n // 2) % 250, 'C': np.arange(n // 2) + 1.0})
+        start1, end1 = get_start_end(len(df1))
+        start2, end2 = get_start_end(len(df2))
+        self.assertEqual(
+            hpat_func(df1.iloc[start1:end1], df2.iloc[start2:end2]),
+            test_impl(df1, df2))
+        self.assertEqual(count_array_REPs(), 0)
+        self.assertEqual(count_parfor_REPs(), 0)
+
     def test_merge_asof_seq1(self):
         def test_impl(df1, df2):
             return pd.merge_asof(df1, df2, on='time')
@@ -29,11 +29,15 @@
 #include <mpi.h>
 
 #include "../_distributed.h"
+#include "../_hpat_hash.h"
+#include "../io/_csv_lines.h"
 
 using namespace std;
 
 #define ROOT 0
 #define LARGE_DTYPE_SIZE 1024
+// largest messages of exchanges which don't fit MPI_Alltoallv
+#define HPAT_SHUFFLE_MSG_BYTES (64 * 1024 * 1024)
 
 /**
  * Static function to be registered in Python and code helpers
@@ -113,26 +117,6 @@ static int hpat_dist_get_rank()
     return rank;
 }
 
-/// return vector of offsets of newlines in first n bytes of given stream
-static vector<size_t> count_lines(istream* f, size_t n)
-{
-    vector<size_t> pos;
-    char c;
-    size_t i = 0;
-
-    while (i < n && f->get(c))
-    {
-        if (c == '\n')
-            pos.push_back(i);
-        ++i;
-    }
-
-    if (i < n)
-        cerr << "Warning, read only " << i << " bytes out of " << n << "requested\n";
-
-    return pos;
-}
-
 /**
  * Code moved from hpat/io/_csv.cpp
  */
@@ -159,6 +143,183 @@ static int hpat_dist_get_size()
     return size;
 }
 
+/**
+ * Two-level (node-aware) collectives, enabled with hpat_dist_set_hierarchical.
+ * Processes are grouped by shared memory node, or in nodes of consecutive ranks of a given size to
+ * test the collectives on one machine. Node-local data goes through MPI shared memory
+ * windows and only the first process of every node (its leader) communicates with other nodes,
+ * so inter-node messages are per pair of nodes instead of per pair of processes.
+ * Communicators are created by the first collective which uses them. They are not used if
+ * there is a single node or a single process on every node.
+ */
+struct hpat_node_comms
+{
+    MPI_Comm node_comm = MPI_COMM_NULL;   // processes of the node, ordered by rank
+    MPI_Comm leader_comm = MPI_COMM_NULL; // leaders of all nodes, null on other processes
+    int node_rank = 0;
+    int node_size = 1;
+    int node_id = 0;
+    int n_nodes = 1;
+    std::vector<std::vector<int>> node_ranks; // ranks of the processes of every node
+    // shared memory of reductions, a slot of scratch_bytes for every process of the node
+    MPI_Win scratch_win = MPI_WIN_NULL;
+    int64_t scratch_bytes = 0;
+    std::vector<char*> scratch;
+};
+
+static bool hpat_hierarchical = false;
+static int hpat_emulated_node_size = 0; // 0 for shared memory nodes
+static hpat_node_comms* hpat_nodes = NULL;
+
+static void hpat_dist_set_hierarchical(int flag, int node_size)
+{
+    hpat_hierarchical = flag != 0;
+    hpat_emulated_node_size = node_size;
+}
+
+/**
+ * Returns the node communicators if two-level collectives are enabled and useful, NULL otherwise.
+ * Collective on all processes.
+ */
+static hpat_node_comms* hpat_get_node_comms()
+{
+    if (!hpat_hierarchical)
+        return NULL;
+    if (hpat_nodes != NULL)
+        return hpat_nodes->node_comm != MPI_COMM_NULL ? hpat_nodes : NULL;
+
+    hpat_nodes = new hpat_node_comms();
+    int rank = hpat_dist_get_rank();
+    int n_pes = hpat_dist_get_size();
+    MPI_Comm node_comm;
+    if (hpat_emulated_node_size > 0)
+        MPI_Comm_split(MPI_COMM_WORLD, rank / hpat_emulated_node_size, rank, &node_comm);
+    else
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+    int node_size;
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm leader_comm;
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+    int node_id = 0;
+    if (node_rank == 0)
+        MPI_Comm_rank(leader_comm, &node_id);
+    MPI_Bcast(&node_id, 1, MPI_INT, 0, node_comm);
+    std::vector<int> node_of(n_pes);
+    MPI_Allgather(&node_id, 1, MPI_INT, node_of.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    int n_nodes = *std::max_element(node_of.begin(), node_of.end()) + 1;
+
+    if (n_nodes == 1 || n_nodes == n_pes)
+    {
+        // no inter-node or no node-local communication to save
+        if (leader_comm != MPI_COMM_NULL)
+            MPI_Comm_free(&leader_comm);
+        MPI_Comm_free(&node_comm);
+        return NULL;
+    }
+    hpat_nodes->node_comm = node_comm;
+    hpat_nodes->leader_comm = leader_comm;
+    hpat_nodes->node_rank = node_rank;
+    hpat_nodes->node_size = node_size;
+    hpat_nodes->node_id = node_id;
+    hpat_nodes->n_nodes = n_nodes;
+    hpat_nodes->node_ranks.resize(n_nodes);
+    for (int i = 0; i < n_pes; i++)
+        hpat_nodes->node_ranks[node_of[i]].push_back(i);
+    return hpat_nodes;
+}
+
+static void hpat_free_node_comms()
+{
+    if (hpat_nodes == NULL)
+        return;
+    if (hpat_nodes->scratch_win != MPI_WIN_NULL)
+        MPI_Win_free(&hpat_nodes->scratch_win);
+    if (hpat_nodes->leader_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&hpat_nodes->leader_comm);
+    if (hpat_nodes->node_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&hpat_nodes->node_comm);
+    delete hpat_nodes;
+    hpat_nodes = NULL;
+}
+
+/**
+ * Allocates a shared memory window of size bytes on the node and returns the memory of every
+ * process of the node in bases. The window is locked for shared access until it is freed.
+ */
+static MPI_Win hpat_node_win_alloc(hpat_node_comms* nc, int64_t size, std::vector<char*>& bases)
+{
+    MPI_Win win;
+    char* base;
+    MPI_Win_allocate_shared((MPI_Aint)size, 1, MPI_INFO_NULL, nc->node_comm, &base, &win);
+    bases.resize(nc->node_size);
+    for (int i = 0; i < nc->node_size; i++)
+    {
+        MPI_Aint i_size;
+        int disp_unit;
+        MPI_Win_shared_query(win, i, &i_size, &disp_unit, &bases[i]);
+    }
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+    return win;
+}
+
+static void hpat_node_win_free(MPI_Win* win)
+{
+    MPI_Win_unlock_all(*win);
+    MPI_Win_free(win);
+}
+
+/**
+ * Makes the writes of all processes of the node to win visible to all of them.
+ */
+static void hpat_node_win_sync(hpat_node_comms* nc, MPI_Win win)
+{
+    MPI_Win_sync(win);
+    MPI_Barrier(nc->node_comm);
+    MPI_Win_sync(win);
+}
+
+/**
+ * MPI_Allreduce of count values, in two levels if enabled: values of the node are reduced by its
+ * leader in shared memory, leaders reduce them across nodes and the result is read back from
+ * shared memory by the processes of the node.
+ */
+static void hpat_allreduce(const void* in_ptr, void* out_ptr, int count, MPI_Datatype mpi_typ, MPI_Op mpi_op)
+{
+    hpat_node_comms* nc = hpat_get_node_comms();
+    if (nc == NULL)
+    {
+        MPI_Allreduce(in_ptr, out_ptr, count, mpi_typ, mpi_op, MPI_COMM_WORLD);
+        return;
+    }
+    int type_size;
+    MPI_Type_size(mpi_typ, &type_size);
+    int64_t n_bytes = (int64_t)count * type_size;
+    // count is the same on all processes, so they all reallocate the window together
+    if (n_bytes > nc->scratch_bytes)
+    {
+        if (nc->scratch_win != MPI_WIN_NULL)
+            hpat_node_win_free(&nc->scratch_win);
+        nc->scratch_bytes = std::max(n_bytes, (int64_t)64);
+        nc->scratch_win = hpat_node_win_alloc(nc, nc->scratch_bytes, nc->scratch);
+    }
+
+    memcpy(nc->scratch[nc->node_rank], in_ptr, n_bytes);
+    hpat_node_win_sync(nc, nc->scratch_win);
+    if (nc->node_rank == 0)
+    {
+        char* res = nc->scratch[0];
+        for (int i = 1; i < nc->node_size; i++)
+            MPI_Reduce_local(nc->scratch[i], res, count, mpi_typ, mpi_op);
+        MPI_Allreduce(MPI_IN_PLACE, res, count, mpi_typ, mpi_op, nc->leader_comm);
+    }
+    hpat_node_win_sync(nc, nc->scratch_win);
+    memcpy(out_ptr, nc->scratch[0], n_bytes);
+    // the slots are reused by the next reduction
+    hpat_node_win_sync(nc, nc->scratch_win);
+}
+
 static int64_t hpat_dist_exscan_i8(int64_t value)
 {
     // printf("sum value: %lld\n", value);
@@ -236,7 +397,7 @@ static void hpat_dist_reduce(char* in_ptr, char* out_ptr, int op_enum, int type_
         memcpy(in_val_rank + value_size, &rank, sizeof(int));
         // TODO: support int64_int value on Windows
         MPI_Datatype val_rank_mpi_typ = get_val_rank_MPI_typ(type_enum);
-        MPI_Allreduce(in_val_rank, out_val_rank, 1, val_rank_mpi_typ, mpi_op, MPI_COMM_WORLD);
+        hpat_allreduce(in_val_rank, out_val_rank, 1, val_rank_mpi_typ, mpi_op);
 
         int target_rank = *((int*)(out_val_rank + value_size));
         // printf("rank:%d allreduce rank:%d val:%lf\n", rank, target_rank, *(double*)out_val_rank);
@@ -246,7 +407,7 @@ static void hpat_dist_reduce(char* in_ptr, char* out_ptr, int op_enum, int type_
         return;
     }
 
-    MPI_Allreduce(in_ptr, out_ptr, 1, mpi_typ, mpi_op, MPI_COMM_WORLD);
+    hpat_allreduce(in_ptr, out_ptr, 1, mpi_typ, mpi_op);
     return;
 }
 
@@ -265,10 +426,19 @@ static MPI_Request hpat_dist_isend(void* out, int size, int type_enum, int pe, i
     return mpi_req_recv;
 }
 
-static void hpat_mpi_csv_get_offsets(
-    istream* f, size_t fsz, bool is_parallel, int64_t skiprows, int64_t nrows, size_t& my_off_start, size_t& my_off_end)
+static void hpat_mpi_csv_get_offsets(istream* f,
+                                     const char* fname,
+                                     size_t fsz,
+                                     bool is_parallel,
+                                     int64_t skiprows,
+                                     int64_t nrows,
+                                     char quotechar,
+                                     size_t& my_off_start,
+                                     size_t& my_off_end)
 {
     size_t nranks = hpat_dist_get_size();
+    // no line after skiprows+nrows is ever needed to find the boundaries
+    size_t max_lines = nrows != -1 ? (size_t)(skiprows + nrows) : SIZE_MAX;
 
     if (is_parallel && nranks > 1)
     {
@@ -284,8 +454,26 @@ static void hpat_mpi_csv_get_offsets(
         }
         // We evenly distribute the 'data' byte-wise
         // count number of lines in chunk
-        // TODO: count only until nrows
-        vector<size_t> line_offset = count_lines(f, hpat_dist_get_node_portion(fsz, nranks, rank));
+        // Counting stops after max_lines: if a rank has that many lines every
+        // later rank starts past the last needed line anyway, and the capped
+        // total is still enough to validate nrows.
+        // Newlines inside quoted fields don't end a line. We don't know yet if
+        // our chunk starts inside quotes, so line ends are collected for both
+        // cases and the quote parity of all previous chunks decides.
+        vector<size_t> parity_line_offset[2];
+        int chunk_parity = csv_count_lines_quoted(f,
+                                                  fname,
+                                                  byte_offset,
+                                                  hpat_dist_get_node_portion(fsz, nranks, rank),
+                                                  max_lines,
+                                                  quotechar,
+                                                  parity_line_offset);
+        int start_parity = 0;
+        MPI_Exscan(&chunk_parity, &start_parity, 1, MPI_INT, MPI_BXOR, MPI_COMM_WORLD);
+        // Exscan result is undefined on first rank
+        if (rank == 0)
+            start_parity = 0;
+        vector<size_t>& line_offset = parity_line_offset[start_parity];
         size_t no_lines = line_offset.size();
         // get total number of lines using allreduce
         int64_t tot_no_lines = 0;
@@ -368,11 +556,13 @@ static void hpat_mpi_csv_get_offsets(
     } // if is_parallel
     else if (skiprows > 0 || nrows != -1)
     {
-        vector<size_t> line_offset = count_lines(f, fsz);
+        vector<size_t> line_offset[2];
+        csv_count_lines_quoted(
+            f, fname, 0, fsz, nrows != -1 ? max_lines : (size_t)skiprows, quotechar, line_offset);
         if (skiprows > 0)
-            my_off_start = line_offset[skiprows - 1] + 1;
+            my_off_start = line_offset[0][skiprows - 1] + 1;
         if (nrows != -1)
-            my_off_end = line_offset[nrows - 1] + 1;
+            my_off_end = line_offset[0][nrows - 1] + 1;
     }
 }
 
@@ -509,10 +699,10 @@ static void file_write_parallel(char* file_name, char* buff, int64_t start, int6
  * Code moved from hpat/_hiframes.cpp
  */
 
-static int64_t get_join_sendrecv_counts(int** p_send_counts,
-                                        int** p_recv_counts,
-                                        int** p_send_disp,
-                                        int** p_recv_disp,
+static int64_t get_join_sendrecv_counts(int64_t** p_send_counts,
+                                        int64_t** p_recv_counts,
+                                        int64_t** p_send_disp,
+                                        int64_t** p_recv_disp,
                                         int64_t arr_len,
                                         int type_enum,
                                         void* data)
@@ -521,31 +711,27 @@ static int64_t get_join_sendrecv_counts(int** p_send_counts,
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     int n_pes;
     MPI_Comm_size(MPI_COMM_WORLD, &n_pes);
-    // alloc buffers
-    int* send_counts = new int[n_pes];
+    // alloc buffers, 64-bit counts for c_alltoallv
+    int64_t* send_counts = new int64_t[n_pes];
     *p_send_counts = send_counts;
-    int* recv_counts = new int[n_pes];
+    int64_t* recv_counts = new int64_t[n_pes];
     *p_recv_counts = recv_counts;
-    int* send_disp = new int[n_pes];
+    int64_t* send_disp = new int64_t[n_pes];
     *p_send_disp = send_disp;
-    int* recv_disp = new int[n_pes];
+    int64_t* recv_disp = new int64_t[n_pes];
     *p_recv_disp = recv_disp;
 
-    // TODO: extend to other key types
-    int64_t* key_arr = (int64_t*)data;
-    memset(send_counts, 0, sizeof(int) * n_pes);
-    for (int64_t i = 0; i < arr_len; i++)
-    {
-        int node_id = key_arr[i] % n_pes;
-        send_counts[node_id]++;
-    }
+    // keys of any numeric type are hashed, see _hpat_hash.h
+    std::vector<int> node_ids(arr_len);
+    uint32_t* no_offsets = NULL;
+    hpat_hash_shuffle_keys(arr_len, 1, &type_enum, &data, &no_offsets, n_pes, node_ids.data(), send_counts);
     // send displacement
     send_disp[0] = 0;
     for (int64_t i = 1; i < n_pes; i++)
     {
         send_disp[i] = send_disp[i - 1] + send_counts[i - 1];
     }
-    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, MPI_COMM_WORLD);
+    MPI_Alltoall(send_counts, 1, MPI_INT64_T, recv_counts, 1, MPI_INT64_T, MPI_COMM_WORLD);
     // recv displacement
     recv_disp[0] = 0;
     for (int64_t i = 1; i < n_pes; i++)
@@ -561,6 +747,94 @@ static int64_t get_join_sendrecv_counts(int** p_send_counts,
     return total_recv_size;
 }
 
+/**
+ * Heavy keys of a join of two distributed tables (see _hpat_hash.h), from the hashes of their keys.
+ * Keys are heavy if their estimated rows in a table exceed threshold times the rows of a node
+ * after an even partitioning. Returns the number of heavy keys, the same on all nodes.
+ */
+static int64_t join_heavy_keys(const uint64_t* hashes1,
+                               int64_t n_rows1,
+                               const uint64_t* hashes2,
+                               int64_t n_rows2,
+                               int64_t sample_size,
+                               double threshold,
+                               int local_sides,
+                               int64_t max_keys,
+                               uint64_t* heavy_hashes,
+                               int* heavy_local)
+{
+    int n_pes;
+    MPI_Comm_size(MPI_COMM_WORLD, &n_pes);
+    if (n_pes == 1 || threshold <= 0 || max_keys <= 0 || local_sides == 0)
+    {
+        return 0;
+    }
+    int64_t n_rows[2] = {n_rows1, n_rows2};
+    int64_t total_rows[2];
+    MPI_Allreduce(n_rows, total_rows, 2, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+    int64_t min_counts[2];
+    for (int side = 0; side < 2; side++)
+    {
+        min_counts[side] = std::max((int64_t)(threshold * total_rows[side] / n_pes), (int64_t)2);
+    }
+
+    // local candidates need the same share of the local rows
+    std::vector<hpat_heavy_key> candidates;
+    hpat_heavy_key_candidates(hashes1, n_rows1, 0, sample_size,
+                              std::max((int64_t)(threshold * n_rows1 / n_pes), (int64_t)2), max_keys, candidates);
+    hpat_heavy_key_candidates(hashes2, n_rows2, 1, sample_size,
+                              std::max((int64_t)(threshold * n_rows2 / n_pes), (int64_t)2), max_keys, candidates);
+
+    int send_size = (int)(candidates.size() * sizeof(hpat_heavy_key));
+    std::vector<int> recv_sizes(n_pes);
+    MPI_Allgather(&send_size, 1, MPI_INT, recv_sizes.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    std::vector<int> recv_disp(n_pes, 0);
+    for (int i = 1; i < n_pes; i++)
+    {
+        recv_disp[i] = recv_disp[i - 1] + recv_sizes[i - 1];
+    }
+    std::vector<hpat_heavy_key> all_candidates((recv_disp[n_pes - 1] + recv_sizes[n_pes - 1]) / sizeof(hpat_heavy_key));
+    MPI_Allgatherv(candidates.data(),
+                   send_size,
+                   MPI_BYTE,
+                   all_candidates.data(),
+                   recv_sizes.data(),
+                   recv_disp.data(),
+                   MPI_BYTE,
+                   MPI_COMM_WORLD);
+    return hpat_select_heavy_keys(all_candidates, min_counts, local_sides, max_keys, heavy_hashes, heavy_local);
+}
+
+/**
+ * Print the rows each node received in a join shuffle and the imbalance, on the root node
+ */
+static void join_report_recv(int64_t n_recv, int64_t n_heavy)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int n_pes;
+    MPI_Comm_size(MPI_COMM_WORLD, &n_pes);
+    std::vector<int64_t> all_recv(rank == ROOT ? n_pes : 0);
+    MPI_Gather(&n_recv, 1, MPI_INT64_T, all_recv.data(), 1, MPI_INT64_T, ROOT, MPI_COMM_WORLD);
+    if (rank != ROOT)
+    {
+        return;
+    }
+    int64_t total_recv = 0;
+    int64_t max_recv = 0;
+    printf("join shuffle rows received per rank:");
+    for (int i = 0; i < n_pes; i++)
+    {
+        printf(" %lld", (long long)all_recv[i]);
+        total_recv += all_recv[i];
+        max_recv = std::max(max_recv, all_recv[i]);
+    }
+    printf("\njoin shuffle max/mean rows received: %.2f, heavy keys: %lld\n",
+           total_recv > 0 ? (double)max_recv * n_pes / total_recv : 1.0,
+           (long long)n_heavy);
+    fflush(stdout);
+}
+
 /**
  * Code moved from hpat/_distibuted.cpp
  */
@@ -615,7 +889,7 @@ static int hpat_dist_arr_reduce(void* out, int64_t* shapes, int ndims, int op_en
     MPI_Op mpi_op = get_MPI_op(op_enum);
     int elem_size = get_elem_size(type_enum);
     void* res_buf = malloc(total_size * elem_size);
-    MPI_Allreduce(out, res_buf, total_size, mpi_typ, mpi_op, MPI_COMM_WORLD);
+    hpat_allreduce(out, res_buf, total_size, mpi_typ, mpi_op);
     memcpy(out, res_buf, total_size * elem_size);
     free(res_buf);
     return 0;
@@ -691,12 +965,306 @@ static void c_alltoall(void* send_data, void* recv_data, int count, int typ_enum
     MPI_Alltoall(send_data, count, mpi_typ, recv_data, count, mpi_typ, MPI_COMM_WORLD);
 }
 
-static void c_alltoallv(
-    void* send_data, void* recv_data, int* send_counts, int* recv_counts, int* send_disp, int* recv_disp, int typ_enum)
+/**
+ * All-to-all exchange of values of elem_size bytes in messages of at most chunk_elems values,
+ * pair of processes by pair of processes (sending to rank + i while receiving from rank - i).
+ * Values received from src are written to recv_data at recv_disp[src] directly. The values
+ * for dest are produced by pack(dest, start, count, buff), which returns a pointer to them:
+ * buff after packing them to it, or the values in place if pack_to_buff is false. With
+ * pack_to_buff, two buffers of chunk_elems values are used, so a chunk is packed while the
+ * previous one is sent.
+ */
+template <typename PackFn>
+static void hpat_alltoallv_stream(int64_t elem_size,
+                                  const int64_t* send_counts,
+                                  const int64_t* recv_counts,
+                                  const int64_t* recv_disp,
+                                  char* recv_data,
+                                  int64_t chunk_elems,
+                                  bool pack_to_buff,
+                                  PackFn pack,
+                                  MPI_Comm comm)
+{
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    int n_pes;
+    MPI_Comm_size(comm, &n_pes);
+    // message sizes are int bytes
+    chunk_elems = std::max(std::min(chunk_elems, (int64_t)INT_MAX / elem_size), (int64_t)1);
+
+    std::vector<char> send_buffs[2];
+    MPI_Request send_reqs[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+    std::vector<MPI_Request> recv_reqs;
+    const int TAG = 12; // arbitrary
+    int buff_id = 0;
+
+    // own values are packed to the output
+    for (int64_t start = 0; start < send_counts[rank]; start += chunk_elems)
+    {
+        int64_t count = std::min(chunk_elems, send_counts[rank] - start);
+        char* out = recv_data + (recv_disp[rank] + start) * elem_size;
+        const char* data = pack(rank, start, count, out);
+        if (data != out)
+        {
+            memcpy(out, data, count * elem_size);
+        }
+    }
+
+    for (int i = 1; i < n_pes; i++)
+    {
+        int dest = (rank + i) % n_pes;
+        int src = (rank - i + n_pes) % n_pes;
+        // receives are posted first so the sends of src can complete
+        recv_reqs.clear();
+        for (int64_t start = 0; start < recv_counts[src]; start += chunk_elems)
+        {
+            int64_t count = std::min(chunk_elems, recv_counts[src] - start);
+            MPI_Request req;
+            MPI_Irecv(recv_data + (recv_disp[src] + start) * elem_size,
+                      (int)(count * elem_size),
+                      MPI_BYTE,
+                      src,
+                      TAG,
+                      comm,
+                      &req);
+            recv_reqs.push_back(req);
+        }
+        for (int64_t start = 0; start < send_counts[dest]; start += chunk_elems)
+        {
+            int64_t count = std::min(chunk_elems, send_counts[dest] - start);
+            // the buffer is reused once its previous message is sent
+            MPI_Wait(&send_reqs[buff_id], MPI_STATUS_IGNORE);
+            if (pack_to_buff && send_buffs[buff_id].empty())
+            {
+                send_buffs[buff_id].resize(chunk_elems * elem_size);
+            }
+            const char* data = pack(dest, start, count, send_buffs[buff_id].data());
+            MPI_Isend(data, (int)(count * elem_size), MPI_BYTE, dest, TAG, comm, &send_reqs[buff_id]);
+            buff_id = 1 - buff_id;
+        }
+        MPI_Waitall((int)recv_reqs.size(), recv_reqs.data(), MPI_STATUSES_IGNORE);
+    }
+    MPI_Waitall(2, send_reqs, MPI_STATUSES_IGNORE);
+}
+
+/**
+ * MPI_Alltoallv on comm with 64-bit counts and displacements (in elements of mpi_typ).
+ * MPI_Alltoallv takes int counts and displacements, so if any of them doesn't fit in int on any
+ * process, the data is exchanged with hpat_alltoallv_stream in messages of HPAT_SHUFFLE_MSG_BYTES.
+ */
+static void hpat_alltoallv_64(const void* send_data,
+                              void* recv_data,
+                              const int64_t* send_counts,
+                              const int64_t* recv_counts,
+                              const int64_t* send_disp,
+                              const int64_t* recv_disp,
+                              MPI_Datatype mpi_typ,
+                              MPI_Comm comm)
+{
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    int n_pes;
+    MPI_Comm_size(comm, &n_pes);
+
+    std::vector<int> i_send_counts(n_pes);
+    std::vector<int> i_recv_counts(n_pes);
+    std::vector<int> i_send_disp(n_pes);
+    std::vector<int> i_recv_disp(n_pes);
+    int big_shuffle = 0;
+    for (int i = 0; i < n_pes; i++)
+    {
+        if (send_counts[i] >= (int64_t)INT_MAX || recv_counts[i] >= (int64_t)INT_MAX ||
+            send_disp[i] >= (int64_t)INT_MAX || recv_disp[i] >= (int64_t)INT_MAX)
+        {
+            big_shuffle = 1;
+            break;
+        }
+        i_send_counts[i] = (int)send_counts[i];
+        i_recv_counts[i] = (int)recv_counts[i];
+        i_send_disp[i] = (int)send_disp[i];
+        i_recv_disp[i] = (int)recv_disp[i];
+    }
+    // all processes have to take the same path
+    MPI_Allreduce(MPI_IN_PLACE, &big_shuffle, 1, MPI_INT, MPI_MAX, comm);
+
+    if (!big_shuffle)
+    {
+        int ierr = MPI_Alltoallv(send_data,
+                                 i_send_counts.data(),
+                                 i_send_disp.data(),
+                                 mpi_typ,
+                                 recv_data,
+                                 i_recv_counts.data(),
+                                 i_recv_disp.data(),
+                                 mpi_typ,
+                                 comm);
+        if (ierr != 0)
+            cerr << "alltoallv error" << '\n';
+        return;
+    }
+
+    // exchanged in place from send_data, in bounded messages
+    int type_size;
+    MPI_Type_size(mpi_typ, &type_size);
+    hpat_alltoallv_stream(type_size,
+                          send_counts,
+                          recv_counts,
+                          recv_disp,
+                          (char*)recv_data,
+                          HPAT_SHUFFLE_MSG_BYTES / type_size,
+                          false,
+                          [&](int dest, int64_t start, int64_t count, char* buff) -> const char* {
+                              return (const char*)send_data + (send_disp[dest] + start) * type_size;
+                          },
+                          comm);
+}
+
+/**
+ * Two-level hpat_alltoallv_64 on MPI_COMM_WORLD (see hpat_node_comms).
+ * Every process copies its counts and send data to a shared memory window, from which the
+ * processes of the node read their node-local data directly. The leader of the node exchanges
+ * the data of the node for every other node, ordered by destination process and then source
+ * process, with the other leaders through hpat_alltoallv_stream, packing it from the window in
+ * bounded messages. It receives to a second shared memory window, from which the processes of
+ * the node read their data.
+ */
+static void hpat_alltoallv_nodes(hpat_node_comms* nc,
+                                 const void* send_data,
+                                 void* recv_data,
+                                 const int64_t* send_counts,
+                                 const int64_t* recv_counts,
+                                 const int64_t* send_disp,
+                                 const int64_t* recv_disp,
+                                 MPI_Datatype mpi_typ)
+{
+    int rank = hpat_dist_get_rank();
+    int n_pes = hpat_dist_get_size();
+    int type_size;
+    MPI_Type_size(mpi_typ, &type_size);
+    const std::vector<int>& my_ranks = nc->node_ranks[nc->node_id];
+
+    // window of every process: send counts, send displacements, recv counts, send data
+    int64_t header_bytes = 3 * n_pes * sizeof(int64_t);
+    int64_t send_len = 0;
+    for (int i = 0; i < n_pes; i++)
+        send_len = std::max(send_len, send_disp[i] + send_counts[i]);
+    std::vector<char*> bases;
+    MPI_Win send_win = hpat_node_win_alloc(nc, header_bytes + send_len * type_size, bases);
+    int64_t* header = (int64_t*)bases[nc->node_rank];
+    memcpy(header, send_counts, n_pes * sizeof(int64_t));
+    memcpy(header + n_pes, send_disp, n_pes * sizeof(int64_t));
+    memcpy(header + 2 * n_pes, recv_counts, n_pes * sizeof(int64_t));
+    memcpy(bases[nc->node_rank] + header_bytes, send_data, send_len * type_size);
+    hpat_node_win_sync(nc, send_win);
+    auto get_send_counts = [&](int i) { return (const int64_t*)bases[i]; };
+    auto get_send_disp = [&](int i) { return (const int64_t*)bases[i] + n_pes; };
+    auto get_recv_counts = [&](int i) { return (const int64_t*)bases[i] + 2 * n_pes; };
+    auto get_send_data = [&](int i) { return bases[i] + header_bytes; };
+
+    // node-local data
+    for (int i = 0; i < nc->node_size; i++)
+    {
+        int src = my_ranks[i];
+        memcpy((char*)recv_data + recv_disp[src] * type_size,
+               get_send_data(i) + get_send_disp(i)[rank] * type_size,
+               recv_counts[src] * type_size);
+    }
+
+    // bytes the leader sends to and receives from every node
+    std::vector<int64_t> node_send_counts(nc->n_nodes, 0);
+    std::vector<int64_t> node_recv_counts(nc->n_nodes, 0);
+    if (nc->node_rank == 0)
+    {
+        for (int node = 0; node < nc->n_nodes; node++)
+        {
+            if (node == nc->node_id)
+                continue;
+            for (int dest : nc->node_ranks[node])
+                for (int i = 0; i < nc->node_size; i++)
+                    node_send_counts[node] += get_send_counts(i)[dest] * type_size;
+            for (int i = 0; i < nc->node_size; i++)
+                for (int src : nc->node_ranks[node])
+                    node_recv_counts[node] += get_recv_counts(i)[src] * type_size;
+        }
+    }
+    std::vector<int64_t> node_recv_disp(nc->n_nodes, 0);
+    for (int node = 1; node < nc->n_nodes; node++)
+        node_recv_disp[node] = node_recv_disp[node - 1] + node_recv_counts[node - 1];
+    int64_t total_recv = node_recv_disp[nc->n_nodes - 1] + node_recv_counts[nc->n_nodes - 1];
+    std::vector<char*> recv_bases;
+    MPI_Win recv_win = hpat_node_win_alloc(nc, total_recv, recv_bases);
+
+    if (nc->node_rank == 0)
+    {
+        // bytes [start, start+count) of the data for node, walking its pieces in packing order
+        auto pack = [&](int node, int64_t start, int64_t count, char* buff) -> const char* {
+            int64_t end = start + count;
+            int64_t pos = 0;
+            char* out = buff;
+            for (int dest : nc->node_ranks[node])
+                for (int i = 0; i < nc->node_size && pos < end; i++)
+                {
+                    int64_t n_bytes = get_send_counts(i)[dest] * type_size;
+                    int64_t lo = std::max(start, pos);
+                    int64_t hi = std::min(end, pos + n_bytes);
+                    if (lo < hi)
+                    {
+                        memcpy(out, get_send_data(i) + get_send_disp(i)[dest] * type_size + (lo - pos), hi - lo);
+                        out += hi - lo;
+                    }
+                    pos += n_bytes;
+                }
+            return buff;
+        };
+        hpat_alltoallv_stream(1,
+                              node_send_counts.data(),
+                              node_recv_counts.data(),
+                              node_recv_disp.data(),
+                              recv_bases[0],
+                              HPAT_SHUFFLE_MSG_BYTES,
+                              true,
+                              pack,
+                              nc->leader_comm);
+    }
+    hpat_node_win_sync(nc, recv_win);
+
+    // data of other nodes, in the order of the leader's packing
+    const char* in = recv_bases[0];
+    for (int node = 0; node < nc->n_nodes; node++)
+    {
+        if (node == nc->node_id)
+            continue;
+        for (int i = 0; i < nc->node_size; i++)
+            for (int src : nc->node_ranks[node])
+            {
+                int64_t n_bytes = get_recv_counts(i)[src] * type_size;
+                if (i == nc->node_rank)
+                    memcpy((char*)recv_data + recv_disp[src] * type_size, in, n_bytes);
+                in += n_bytes;
+            }
+    }
+    // windows are freed once all processes have read them
+    MPI_Barrier(nc->node_comm);
+    hpat_node_win_free(&recv_win);
+    hpat_node_win_free(&send_win);
+}
+
+static void c_alltoallv(void* send_data,
+                        void* recv_data,
+                        int64_t* send_counts,
+                        int64_t* recv_counts,
+                        int64_t* send_disp,
+                        int64_t* recv_disp,
+                        int typ_enum)
 {
     MPI_Datatype mpi_typ = get_MPI_typ(typ_enum);
-    MPI_Alltoallv(
-        send_data, send_counts, send_disp, mpi_typ, recv_data, recv_counts, recv_disp, mpi_typ, MPI_COMM_WORLD);
+    hpat_node_comms* nc = hpat_get_node_comms();
+    if (nc != NULL)
+    {
+        hpat_alltoallv_nodes(nc, send_data, recv_data, send_counts, recv_counts, send_disp, recv_disp, mpi_typ);
+        return;
+    }
+    hpat_alltoallv_64(send_data, recv_data, send_counts, recv_counts, send_disp, recv_disp, mpi_typ, MPI_COMM_WORLD);
 }
 
 static int hpat_finalize()
@@ -712,6 +1280,7 @@ static int hpat_finalize()
     if (!is_finalized)
     {
         // printf("finalizing\n");
+        hpat_free_node_comms();
         MPI_Finalize();
     }
     return 0;
@@ -722,10 +1291,57 @@ static void permutation_int(int64_t* output, int n)
     MPI_Bcast(output, n, MPI_INT64_T, 0, MPI_COMM_WORLD);
 }
 
+/**
+ * Sends the local rows of rhs to the ranks in dest_ranks (freed once used) and receives the
+ * rows of this rank to lhs, in rounds of at most max_bytes of send buffers. The rows to send
+ * are grouped by destination in an index of type I, 32-bit unless there are more local rows.
+ */
+template <typename I>
+static void permutation_send_rows(unsigned char* lhs,
+                                  int64_t elem_size,
+                                  const unsigned char* rhs,
+                                  vector<int64_t>& dest_ranks,
+                                  const vector<int64_t>& recv_counts,
+                                  int64_t max_bytes)
+{
+    auto send_counts = find_send_counts(dest_ranks, recv_counts.size());
+    auto send_disps = find_disps(send_counts);
+    auto recv_disps = find_disps(recv_counts);
+
+    // local rows to send, grouped by destination rank
+    auto offsets = send_disps;
+    vector<I> send_rows(dest_ranks.size());
+    for (size_t i = 0; i < dest_ranks.size(); ++i)
+        send_rows[offsets[dest_ranks[i]]++] = (I)i;
+    vector<int64_t>().swap(dest_ranks);
+
+    // half of max_bytes for each of the two send buffers
+    hpat_alltoallv_stream(elem_size,
+                          send_counts.data(),
+                          recv_counts.data(),
+                          recv_disps.data(),
+                          (char*)lhs,
+                          max_bytes / 2 / elem_size,
+                          true,
+                          [&](int dest, int64_t start, int64_t count, char* buff) -> const char* {
+                              const I* rows = send_rows.data() + send_disps[dest] + start;
+                              for (int64_t i = 0; i < count; ++i)
+                                  memcpy(buff + i * elem_size, rhs + (int64_t)rows[i] * elem_size, elem_size);
+                              return buff;
+                          },
+                          MPI_COMM_WORLD);
+}
+
 // Applies the permutation represented by |p| of size |p_len| to the array |rhs|
-// of elements of size |elem_size| and stores the result in |lhs|.
-static void permutation_array_index(
-    unsigned char* lhs, int64_t len, int64_t elem_size, unsigned char* rhs, int64_t* p, int64_t p_len)
+// of elements of size |elem_size| and stores the result in |lhs|.  Rows are
+// packed for sending in rounds, using at most |max_bytes| of send buffers.
+static void permutation_array_index(unsigned char* lhs,
+                                    int64_t len,
+                                    int64_t elem_size,
+                                    unsigned char* rhs,
+                                    int64_t* p,
+                                    int64_t p_len,
+                                    int64_t max_bytes)
 {
     if (len != p_len)
     {
@@ -733,48 +1349,26 @@ static void permutation_array_index(
         return;
     }
 
-    MPI_Datatype element_t;
-    MPI_Type_contiguous(elem_size, MPI_UNSIGNED_CHAR, &element_t);
-    MPI_Type_commit(&element_t);
-
     auto num_ranks = hpat_dist_get_size();
     auto rank = hpat_dist_get_rank();
     auto dest_ranks = find_dest_ranks(rank, num_ranks, p, p_len);
-    auto send_counts = find_send_counts(dest_ranks, num_ranks, elem_size);
-    auto send_disps = find_disps(send_counts);
-    auto recv_counts = find_recv_counts(rank, num_ranks, p, p_len, elem_size);
-    auto recv_disps = find_disps(recv_counts);
-
-    auto offsets = send_disps;
-    vector<unsigned char> send_buf(dest_ranks.size() * elem_size);
-    for (size_t i = 0; i < dest_ranks.size(); ++i)
-    {
-        auto send_buf_offset = offsets[dest_ranks[i]]++ * elem_size;
-        auto* send_buf_begin = send_buf.data() + send_buf_offset;
-        auto* rhs_begin = rhs + i * elem_size;
-        copy(rhs_begin, rhs_begin + elem_size, send_buf_begin);
-    }
-
-    MPI_Alltoallv(send_buf.data(),
-                  send_counts.data(),
-                  send_disps.data(),
-                  element_t,
-                  lhs,
-                  recv_counts.data(),
-                  recv_disps.data(),
-                  element_t,
-                  MPI_COMM_WORLD);
+    size_t n_rows = dest_ranks.size();
+    auto recv_counts = find_recv_counts(rank, num_ranks, p, p_len);
+    if (n_rows <= UINT32_MAX)
+        permutation_send_rows<uint32_t>(lhs, elem_size, rhs, dest_ranks, recv_counts, max_bytes);
+    else
+        permutation_send_rows<int64_t>(lhs, elem_size, rhs, dest_ranks, recv_counts, max_bytes);
 
     // Let us assume that the global data array is [a b c d e f g h] and the
     // permutation array that we would like to apply to it is [2 7 5 6 4 3 1 0].
     // Hence, the resultant permutation is [c h f g e d b a].  Assuming that
     // there are two ranks, each receiving 4 data items, and we are rank 0,
-    // after MPI_Alltoallv returns, we receive the chunk [c f g h] that
+    // after the exchange, we receive the chunk [c f g h] that
     // corresponds to the sorted chunk of our permutation, which is [2 5 6 7].
     // In order to recover the positions of [c f g h] in the target permutation
     // we first argsort our chunk of permutation array:
     auto begin = p + hpat_dist_get_start(p_len, num_ranks, rank);
-    auto p1 = arg_sort(begin, dest_ranks.size());
+    auto p1 = arg_sort(begin, n_rows);
 
     // The result of the argsort, stored in p1, is [0 2 3 1].  This tells us how
     // the chunk we have received is different from the target permutation we
@@ -782,13 +1376,11 @@ static void permutation_array_index(
     // sort our data chunk based on p1.  One way of sorting array A based on the
     // values of array B, is to argsort array B and apply the permutation to
     // array A.  Therefore, we argsort p1:
-    auto p2 = arg_sort(p1.data(), dest_ranks.size());
+    auto p2 = arg_sort(p1.data(), n_rows);
 
     // which gives us [0 3 1 2], and apply the resultant permutation to our data
     // chunk to obtain the target permutation.
     apply_permutation(lhs, elem_size, p2);
-
-    MPI_Type_free(&element_t);
 }
 
 static void oneD_reshape_shuffle(char* output,
@@ -847,137 +1439,9 @@ static void oneD_reshape_shuffle(char* output,
     // printf("send %d recv %d send_disp %d recv_disp %d\n", send_counts[0], recv_counts[0], send_disp[0], recv_disp[0]);
     // printf("data %lld %lld\n", ((int64_t*)input)[0], ((int64_t*)input)[1]);
 
-    // workaround MPI int limit if necessary
-    int* i_send_counts = new int[num_pes];
-    int* i_recv_counts = new int[num_pes];
-    int* i_send_disp = new int[num_pes];
-    int* i_recv_disp = new int[num_pes];
-    bool big_shuffle = false;
-
-    for (int i = 0; i < num_pes; i++)
-    {
-        // any value doesn't fit in int
-        if (send_counts[i] >= (int64_t)INT_MAX || recv_counts[i] >= (int64_t)INT_MAX ||
-            send_disp[i] >= (int64_t)INT_MAX || recv_disp[i] >= (int64_t)INT_MAX)
-        {
-            big_shuffle = true;
-            break;
-        }
-        i_send_counts[i] = (int)send_counts[i];
-        i_recv_counts[i] = (int)recv_counts[i];
-        i_send_disp[i] = (int)send_disp[i];
-        i_recv_disp[i] = (int)recv_disp[i];
-    }
-
-    if (!big_shuffle)
-    {
-        int ierr = MPI_Alltoallv(
-            input, i_send_counts, i_send_disp, MPI_CHAR, output, i_recv_counts, i_recv_disp, MPI_CHAR, MPI_COMM_WORLD);
-        if (ierr != 0)
-            cerr << "small shuffle error: " << '\n';
-    }
-    else
-    {
-        // char err_string[MPI_MAX_ERROR_STRING];
-        // err_string[MPI_MAX_ERROR_STRING-1] = '\0';
-        // int err_len, err_class;
-        // MPI_Errhandler_set(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
-
-        int* l_send_counts = new int[num_pes];
-        int* l_recv_counts = new int[num_pes];
-        int* l_send_disp = new int[num_pes];
-        int* l_recv_disp = new int[num_pes];
-
-        int64_t* send_offset = new int64_t[num_pes];
-        int64_t* recv_offset = new int64_t[num_pes];
-
-        MPI_Datatype large_dtype;
-        MPI_Type_contiguous(LARGE_DTYPE_SIZE, MPI_CHAR, &large_dtype);
-        MPI_Type_commit(&large_dtype);
-
-        for (int i = 0; i < num_pes; i++)
-        {
-            // large values
-            i_send_counts[i] = (int)(send_counts[i] / LARGE_DTYPE_SIZE);
-            i_recv_counts[i] = (int)(recv_counts[i] / LARGE_DTYPE_SIZE);
-            i_send_disp[i] = (int)(send_disp[i] / LARGE_DTYPE_SIZE);
-            i_recv_disp[i] = (int)(recv_disp[i] / LARGE_DTYPE_SIZE);
-            // leftover values
-            l_send_counts[i] = (int)(send_counts[i] % LARGE_DTYPE_SIZE);
-            l_recv_counts[i] = (int)(recv_counts[i] % LARGE_DTYPE_SIZE);
-            l_send_disp[i] = (int)(send_disp[i] % LARGE_DTYPE_SIZE);
-            l_recv_disp[i] = (int)(recv_disp[i] % LARGE_DTYPE_SIZE);
-            // printf("pe %d rank %d send %d recv %d sdisp %d rdisp %d lsend %d lrecv %d lsdisp %d lrdisp %d\n", i, rank,
-            //         i_send_counts[i], i_recv_counts[i], i_send_disp[i], i_recv_disp[i],
-            //         l_send_counts[i], l_recv_counts[i], l_send_disp[i], l_recv_disp[i]);
-        }
-
-        int64_t curr_send_buff_offset = 0;
-        int64_t curr_recv_buff_offset = 0;
-        // compute buffer offsets
-        for (int i = 0; i < num_pes; i++)
-        {
-            send_offset[i] = curr_send_buff_offset;
-            recv_offset[i] = curr_recv_buff_offset;
-            curr_send_buff_offset += send_counts[i];
-            curr_recv_buff_offset += recv_counts[i];
-            // printf("pe %d rank %d send offset %lld recv offset %lld\n", i, rank, send_offset[i], recv_offset[i]);
-        }
-
-        // XXX implement alltoallv manually
-        for (int i = 0; i < num_pes; i++)
-        {
-            int TAG = 11; // arbitrary
-            int dest = (rank + i + num_pes) % num_pes;
-            int src = (rank - i + num_pes) % num_pes;
-            // printf("rank %d src %d dest %d\n", rank, src, dest);
-            // send big type
-            int ierr = MPI_Sendrecv(input + send_offset[dest],
-                                    i_send_counts[dest],
-                                    large_dtype,
-                                    dest,
-                                    TAG,
-                                    output + recv_offset[src],
-                                    i_recv_counts[src],
-                                    large_dtype,
-                                    src,
-                                    TAG,
-                                    MPI_COMM_WORLD,
-                                    MPI_STATUS_IGNORE);
-            if (ierr != 0)
-                cerr << "large sendrecv error" << '\n';
-            // send leftover
-            ierr = MPI_Sendrecv(input + send_offset[dest] + ((int64_t)i_send_counts[dest]) * LARGE_DTYPE_SIZE,
-                                l_send_counts[dest],
-                                MPI_CHAR,
-                                dest,
-                                TAG + 1,
-                                output + recv_offset[src] + ((int64_t)i_recv_counts[dest]) * LARGE_DTYPE_SIZE,
-                                l_recv_counts[src],
-                                MPI_CHAR,
-                                src,
-                                TAG + 1,
-                                MPI_COMM_WORLD,
-                                MPI_STATUS_IGNORE);
-            if (ierr != 0)
-                cerr << "small sendrecv error" << '\n';
-        }
-
-        // cleanup
-        MPI_Type_free(&large_dtype);
-        delete[] l_send_counts;
-        delete[] l_recv_counts;
-        delete[] l_send_disp;
-        delete[] l_recv_disp;
-        delete[] send_offset;
-        delete[] recv_offset;
-    }
+    hpat_alltoallv_64(input, output, send_counts, recv_counts, send_disp, recv_disp, MPI_CHAR, MPI_COMM_WORLD);
 
     // cleanup
-    delete[] i_send_counts;
-    delete[] i_recv_counts;
-    delete[] i_send_disp;
-    delete[] i_recv_disp;
     delete[] send_counts;
     delete[] recv_counts;
     delete[] send_disp;
@@ -1377,6 +1841,8 @@ PyMODINIT_FUNC PyInit_transport_mpi(void)
     PyObject_SetAttrString(m, "file_write_parallel", PyLong_FromVoidPtr((void*)(&file_write_parallel)));
     PyObject_SetAttrString(m, "get_file_size", PyLong_FromVoidPtr((void*)(&get_file_size)));
     PyObject_SetAttrString(m, "get_join_sendrecv_counts", PyLong_FromVoidPtr((void*)(&get_join_sendrecv_counts)));
+    PyObject_SetAttrString(m, "join_heavy_keys", PyLong_FromVoidPtr((void*)(&join_heavy_keys)));
+    PyObject_SetAttrString(m, "join_report_recv", PyLong_FromVoidPtr((void*)(&join_report_recv)));
     PyObject_SetAttrString(m, "hpat_barrier", PyLong_FromVoidPtr((void*)(&hpat_barrier)));
     PyObject_SetAttrString(m, "hpat_dist_arr_reduce", PyLong_FromVoidPtr((void*)(&hpat_dist_arr_reduce)));
     PyObject_SetAttrString(m, "hpat_dist_exscan_f4", PyLong_FromVoidPtr((void*)(&hpat_dist_exscan_f4)));
@@ -1391,6 +1857,7 @@ PyMODINIT_FUNC PyInit_transport_mpi(void)
     PyObject_SetAttrString(m, "hpat_dist_recv", PyLong_FromVoidPtr((void*)(&hpat_dist_recv)));
     PyObject_SetAttrString(m, "hpat_dist_reduce", PyLong_FromVoidPtr((void*)(&hpat_dist_reduce)));
     PyObject_SetAttrString(m, "hpat_dist_send", PyLong_FromVoidPtr((void*)(&hpat_dist_send)));
+    PyObject_SetAttrString(m, "hpat_dist_set_hierarchical", PyLong_FromVoidPtr((void*)(&hpat_dist_set_hierarchical)));
     PyObject_SetAttrString(m, "hpat_dist_wait", PyLong_FromVoidPtr((void*)(&hpat_dist_wait)));
     PyObject_SetAttrString(m, "hpat_dist_waitall", PyLong_FromVoidPtr((void*)(&hpat_dist_waitall)));
     PyObject_SetAttrString(m, "hpat_finalize", PyLong_FromVoidPtr((void*)(&hpat_finalize)));
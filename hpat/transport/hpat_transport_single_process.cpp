@@ -57,6 +57,7 @@ int gettimeofday(struct timeval* tp, struct timezone* tzp)
 #endif // _WIN32
 
 #include "../_hpat_common.h"
+#include "../io/_csv_lines.h"
 
 using namespace std;
 
@@ -109,12 +110,17 @@ static void c_alltoall(void* send_data, void* recv_data, int count, int typ_enum
     memcpy(recv_data, send_data, type_size_bytes * count);
 }
 
-static void c_alltoallv(
-    void* send_data, void* recv_data, int* send_counts, int* recv_counts, int* send_disp, int* recv_disp, int typ_enum)
+static void c_alltoallv(void* send_data,
+                        void* recv_data,
+                        int64_t* send_counts,
+                        int64_t* recv_counts,
+                        int64_t* send_disp,
+                        int64_t* recv_disp,
+                        int typ_enum)
 {
     size_t type_size_bytes = get_type_size_bytes(typ_enum);
-    memcpy((char*)recv_data + recv_disp[0],
-           (char*)send_data + send_disp[0],
+    memcpy((char*)recv_data + type_size_bytes * recv_disp[0],
+           (char*)send_data + type_size_bytes * send_disp[0],
            type_size_bytes * min(send_counts[0], recv_counts[0]));
 }
 
@@ -187,10 +193,10 @@ static uint64_t get_file_size(const char* file_name)
     return end - begin;
 }
 
-static int64_t get_join_sendrecv_counts(int** p_send_counts,
-                                        int** p_recv_counts,
-                                        int** p_send_disp,
-                                        int** p_recv_disp,
+static int64_t get_join_sendrecv_counts(int64_t** p_send_counts,
+                                        int64_t** p_recv_counts,
+                                        int64_t** p_send_disp,
+                                        int64_t** p_recv_disp,
                                         int64_t arr_len,
                                         int type_enum,
                                         void* data)
@@ -198,6 +204,27 @@ static int64_t get_join_sendrecv_counts(int** p_send_counts,
     throw runtime_error(__FUNCTION__ + string(": Is not implemented"));
 }
 
+static int64_t join_heavy_keys(const uint64_t* hashes1,
+                               int64_t n_rows1,
+                               const uint64_t* hashes2,
+                               int64_t n_rows2,
+                               int64_t sample_size,
+                               double threshold,
+                               int local_sides,
+                               int64_t max_keys,
+                               uint64_t* heavy_hashes,
+                               int* heavy_local)
+{
+    // all keys are on one node
+    return 0;
+}
+
+static void join_report_recv(int64_t n_recv, int64_t n_heavy)
+{
+    printf("join shuffle rows received per rank: %lld\n", (long long)n_recv);
+    fflush(stdout);
+}
+
 static int hpat_barrier()
 {
     return 0;
@@ -274,6 +301,11 @@ static void hpat_dist_send(void* out, int size, int type_enum, int pe, int tag)
     throw runtime_error(__FUNCTION__ + string(": Is not implemented"));
 }
 
+static void hpat_dist_set_hierarchical(int flag, int node_size)
+{
+    // no action needed
+}
+
 static int hpat_dist_wait(MPI_Request req, bool cond)
 {
     throw runtime_error(__FUNCTION__ + string(": Is not implemented"));
@@ -294,45 +326,31 @@ static double hpat_get_time()
     return hpat_dist_get_time();
 }
 
-/// return vector of offsets of newlines in first n bytes of given stream
-static vector<size_t> count_lines(istream* f, size_t n)
-{
-    vector<size_t> pos;
-    char c;
-    size_t i = 0;
-
-    while (i < n && f->get(c))
-    {
-        if (c == '\n')
-        {
-            pos.push_back(i);
-        }
-        ++i;
-    }
-
-    if (i < n)
-    {
-        cerr << "Warning, read only " << i << " bytes out of " << n << "requested\n";
-    }
-
-    return pos;
-}
-
-static void hpat_mpi_csv_get_offsets(
-    istream* f, size_t fsz, bool is_parallel, int64_t skiprows, int64_t nrows, size_t& my_off_start, size_t& my_off_end)
+static void hpat_mpi_csv_get_offsets(istream* f,
+                                     const char* fname,
+                                     size_t fsz,
+                                     bool is_parallel,
+                                     int64_t skiprows,
+                                     int64_t nrows,
+                                     char quotechar,
+                                     size_t& my_off_start,
+                                     size_t& my_off_end)
 {
     if (skiprows > 0 || nrows != -1)
     {
-        vector<size_t> line_offset = count_lines(f, fsz);
+        size_t max_lines = nrows != -1 ? (size_t)(skiprows + nrows) : (size_t)skiprows;
+        // file starts outside of quotes, line ends are in line_offset[0]
+        vector<size_t> line_offset[2];
+        csv_count_lines_quoted(f, fname, 0, fsz, max_lines, quotechar, line_offset);
 
         if (skiprows > 0)
         {
-            my_off_start = line_offset[skiprows - 1] + 1;
+            my_off_start = line_offset[0][skiprows - 1] + 1;
         }
 
         if (nrows != -1)
         {
-            my_off_end = line_offset[nrows - 1] + 1;
+            my_off_end = line_offset[0][nrows - 1] + 1;
         }
     }
 
@@ -423,8 +441,13 @@ static void oneD_reshape_shuffle(char* output,
     throw runtime_error(__FUNCTION__ + string(": Is not implemented"));
 }
 
-static void permutation_array_index(
-    unsigned char* lhs, int64_t len, int64_t elem_size, unsigned char* rhs, int64_t* p, int64_t p_len)
+static void permutation_array_index(unsigned char* lhs,
+                                    int64_t len,
+                                    int64_t elem_size,
+                                    unsigned char* rhs,
+                                    int64_t* p,
+                                    int64_t p_len,
+                                    int64_t max_bytes)
 {
     throw runtime_error(__FUNCTION__ + string(": Is not implemented"));
 }
@@ -473,6 +496,8 @@ PyMODINIT_FUNC PyInit_transport_seq(void)
     PyObject_SetAttrString(m, "file_write_parallel", PyLong_FromVoidPtr((void*)(&file_write_parallel)));
     PyObject_SetAttrString(m, "get_file_size", PyLong_FromVoidPtr((void*)(&get_file_size)));
     PyObject_SetAttrString(m, "get_join_sendrecv_counts", PyLong_FromVoidPtr((void*)(&get_join_sendrecv_counts)));
+    PyObject_SetAttrString(m, "join_heavy_keys", PyLong_FromVoidPtr((void*)(&join_heavy_keys)));
+    PyObject_SetAttrString(m, "join_report_recv", PyLong_FromVoidPtr((void*)(&join_report_recv)));
     PyObject_SetAttrString(m, "hpat_barrier", PyLong_FromVoidPtr((void*)(&hpat_barrier)));
     PyObject_SetAttrString(m, "hpat_dist_arr_reduce", PyLong_FromVoidPtr((void*)(&hpat_dist_arr_reduce)));
     PyObject_SetAttrString(m, "hpat_dist_exscan_f4", PyLong_FromVoidPtr((void*)(&hpat_dist_exscan_f4)));
@@ -487,6 +512,7 @@ PyMODINIT_FUNC PyInit_transport_seq(void)
     PyObject_SetAttrString(m, "hpat_dist_recv", PyLong_FromVoidPtr((void*)(&hpat_dist_recv)));
     PyObject_SetAttrString(m, "hpat_dist_reduce", PyLong_FromVoidPtr((void*)(&hpat_dist_reduce)));
     PyObject_SetAttrString(m, "hpat_dist_send", PyLong_FromVoidPtr((void*)(&hpat_dist_send)));
+    PyObject_SetAttrString(m, "hpat_dist_set_hierarchical", PyLong_FromVoidPtr((void*)(&hpat_dist_set_hierarchical)));
     PyObject_SetAttrString(m, "hpat_dist_wait", PyLong_FromVoidPtr((void*)(&hpat_dist_wait)));
     PyObject_SetAttrString(m, "hpat_dist_waitall", PyLong_FromVoidPtr((void*)(&hpat_dist_waitall)));
     PyObject_SetAttrString(m, "hpat_finalize", PyLong_FromVoidPtr((void*)(&hpat_finalize)));
@@ -0,0 +1,134 @@
+#ifndef _HPAT_NULL_BITMAP_H_INCLUDED
+#define _HPAT_NULL_BITMAP_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * Copy num_bits bits of src starting at bit src_offset to dst starting at bit dst_offset.
+ * Bits are in Arrow order (bit i is bit i % 8 of byte i / 8) and the bits of dst from
+ * dst_offset on are expected to be zero. Unaligned ranges are copied 56 bits at a time
+ * so that a word load or store never spans more than 8 bytes (little-endian words).
+ **/
+inline void hpat_copy_bits(uint8_t* dst, int64_t dst_offset, const uint8_t* src, int64_t src_offset, int64_t num_bits)
+{
+    if (num_bits <= 0)
+    {
+        return;
+    }
+
+    if (dst_offset % 8 == 0 && src_offset % 8 == 0)
+    {
+        int64_t n_full_bytes = num_bits / 8;
+        memcpy(dst + dst_offset / 8, src + src_offset / 8, n_full_bytes);
+        int n_rem_bits = num_bits % 8;
+        if (n_rem_bits > 0)
+        {
+            dst[dst_offset / 8 + n_full_bytes] |= src[src_offset / 8 + n_full_bytes] & ((1 << n_rem_bits) - 1);
+        }
+        return;
+    }
+
+    const int64_t step = 56;
+    for (int64_t i = 0; i < num_bits; i += step)
+    {
+        int64_t n = std::min(step, num_bits - i);
+
+        int64_t src_bit = src_offset + i;
+        int src_shift = src_bit % 8;
+        uint64_t word = 0;
+        memcpy(&word, src + src_bit / 8, (src_shift + n + 7) / 8);
+        word = (word >> src_shift) & ((uint64_t(1) << n) - 1);
+
+        int64_t dst_bit = dst_offset + i;
+        int dst_shift = dst_bit % 8;
+        int64_t n_dst_bytes = (dst_shift + n + 7) / 8;
+        uint64_t out = 0;
+        memcpy(&out, dst + dst_bit / 8, n_dst_bytes);
+        out |= word << dst_shift;
+        memcpy(dst + dst_bit / 8, &out, n_dst_bytes);
+    }
+}
+
+/// set num_bits bits of dst starting at bit offset, the others are left as is
+inline void hpat_set_bits(uint8_t* dst, int64_t offset, int64_t num_bits)
+{
+    int64_t end = offset + num_bits;
+    // leading bits up to a byte boundary
+    while (offset < end && offset % 8 != 0)
+    {
+        dst[offset / 8] |= (uint8_t)(1 << (offset % 8));
+        offset++;
+    }
+    int64_t n_full_bytes = (end - offset) / 8;
+    memset(dst + offset / 8, 0xff, n_full_bytes);
+    offset += n_full_bytes * 8;
+    // trailing bits
+    if (offset < end)
+    {
+        dst[offset / 8] |= (uint8_t)((1 << (end - offset)) - 1);
+    }
+}
+
+/**
+ * Packed validity bitmap that the validity of values read in pieces (row groups, files)
+ * is appended to, at arbitrary bit offsets of the sources.
+ **/
+class hpat_null_bitmap
+{
+public:
+    /// append num_values bits of src starting at bit offset, all valid if src is NULL
+    void append(const uint8_t* src, int64_t offset, int64_t num_values)
+    {
+        if (num_values <= 0)
+        {
+            return;
+        }
+        reserve(n_bits + num_values);
+        if (src == nullptr)
+        {
+            hpat_set_bits(bytes.data(), n_bits, num_values);
+        }
+        else
+        {
+            hpat_copy_bits(bytes.data(), n_bits, src, offset, num_values);
+            has_nulls = true;
+        }
+        n_bits += num_values;
+    }
+
+    int64_t size() const { return n_bits; }
+
+    /// new[] allocated copy of the first n bits in *out_nulls, nullptr if no source had nulls
+    void pack(uint8_t** out_nulls, int64_t n) const
+    {
+        if (!has_nulls)
+        {
+            *out_nulls = nullptr;
+            return;
+        }
+        int64_t n_bytes = (n + 7) / 8;
+        *out_nulls = new uint8_t[n_bytes];
+        memset(*out_nulls, 0, n_bytes);
+        hpat_copy_bits(*out_nulls, 0, bytes.data(), 0, std::min(n, n_bits));
+    }
+
+private:
+    void reserve(int64_t num_bits)
+    {
+        size_t n_bytes = (num_bits + 7) / 8;
+        if (bytes.size() < n_bytes)
+        {
+            // bits past the end are kept zero, appends OR into them
+            bytes.resize(std::max(n_bytes, 2 * bytes.size()), 0);
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+    int64_t n_bits = 0;
+    bool has_nulls = false;
+};
+
+#endif // _HPAT_NULL_BITMAP_H_INCLUDED
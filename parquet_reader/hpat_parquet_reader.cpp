@@ -1,19 +1,27 @@
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #if _MSC_VER >= 1900
 #undef timezone
 #endif
 
 #include "arrow/io/hdfs.h"
+#include "arrow/io/memory.h"
 #include "arrow/table.h"
 #include "arrow/type.h"
 #include "parquet/api/reader.h"
 #include "parquet/arrow/reader.h"
 #include "parquet/arrow/schema.h"
 
+#include "hpat_null_bitmap.h"
+
 using arrow::Type;
 using parquet::ParquetFileReader;
 using parquet::arrow::FileReader;
@@ -21,6 +29,9 @@ using parquet::arrow::FileReader;
 extern "C"
 {
     int64_t pq_get_size_single_file(std::shared_ptr<FileReader> arrow_reader, int64_t column_idx);
+    void pq_get_row_group_sizes_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                            std::vector<int64_t>* rg_rows,
+                                            std::vector<int64_t>* rg_bytes);
     int64_t
         pq_read_single_file(std::shared_ptr<FileReader> arrow_reader, int64_t column_idx, uint8_t* out, int out_dtype);
     int pq_read_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
@@ -28,7 +39,18 @@ extern "C"
                                      uint8_t* out_data,
                                      int out_dtype,
                                      int64_t start,
-                                     int64_t count);
+                                     int64_t count,
+                                     const std::vector<int>* row_groups = NULL);
+    int pq_read_columns_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                             int64_t n_cols,
+                                             const int64_t* column_idxs,
+                                             uint8_t** out_datas,
+                                             const int* out_dtypes,
+                                             int64_t start,
+                                             int64_t count,
+                                             const std::vector<int>* row_groups = NULL,
+                                             int prefetch_depth = 0,
+                                             int64_t prefetch_max_bytes = 0);
 
     int64_t pq_read_string_single_file(std::shared_ptr<FileReader> arrow_reader,
                                        int64_t column_idx,
@@ -37,7 +59,7 @@ extern "C"
                                        uint8_t** out_nulls,
                                        std::vector<uint32_t>* offset_vec = NULL,
                                        std::vector<uint8_t>* data_vec = NULL,
-                                       std::vector<bool>* null_vec = NULL);
+                                       hpat_null_bitmap* null_vec = NULL);
     int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
                                             int64_t column_idx,
                                             uint32_t** out_offsets,
@@ -47,11 +69,31 @@ extern "C"
                                             int64_t count,
                                             std::vector<uint32_t>* offset_vec = NULL,
                                             std::vector<uint8_t>* data_vec = NULL,
-                                            std::vector<bool>* null_vec = NULL);
+                                            hpat_null_bitmap* null_vec = NULL,
+                                            const std::vector<int>* row_groups = NULL);
+    int64_t pq_read_categorical_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                            int64_t column_idx,
+                                            uint8_t* out_codes,
+                                            int code_size,
+                                            const uint8_t* cat_chars,
+                                            const uint32_t* cat_offsets,
+                                            int64_t n_cats,
+                                            int64_t start,
+                                            int64_t count,
+                                            const std::vector<int>* row_groups = NULL);
+    void pq_get_dictionary_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                       int64_t column_idx,
+                                       std::vector<std::string>* values);
+    void pq_filter_row_groups_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                          int64_t column_idx,
+                                          int op,
+                                          int is_float,
+                                          int64_t int_value,
+                                          double float_value,
+                                          std::vector<int>* row_groups);
 
 } // extern "C"
 
-void pack_null_bitmap(uint8_t** out_nulls, std::vector<bool>& null_vec, int64_t n_all_vals);
 std::shared_ptr<arrow::DataType> get_arrow_type(std::shared_ptr<FileReader> arrow_reader, int64_t column_idx);
 bool arrowPqTypesEqual(std::shared_ptr<arrow::DataType> arrow_type, ::parquet::Type::type pq_type);
 inline void copy_data(uint8_t* out_data,
@@ -64,10 +106,12 @@ inline void copy_data(uint8_t* out_data,
 
 template <typename T, int64_t SHIFT>
 inline void convertArrowToDT64(const uint8_t* buff, uint8_t* out_data, int64_t rows_to_skip, int64_t rows_to_read);
-void append_bits_to_vec(
-    std::vector<bool>* null_vec, const uint8_t* null_buff, int64_t null_size, int64_t offset, int64_t num_values);
 
-void pq_init_reader(const char* file_name, std::shared_ptr<FileReader>* a_reader);
+// footer of the file is parsed unless its metadata is given, e.g. broadcast by another rank
+void pq_init_reader(const char* file_name,
+                    std::shared_ptr<FileReader>* a_reader,
+                    const std::shared_ptr<parquet::FileMetaData>& metadata = nullptr);
+void pq_get_footer_single_file(std::shared_ptr<FileReader> arrow_reader, std::string* footer);
 
 // parquet type sizes (NOT arrow), parquet/types.h
 // boolean, int32, int64, int96, float, double, byte
@@ -76,6 +120,20 @@ static int pq_type_sizes[] = {1, 4, 8, 8, 4, 8, 1};
 #define PQ_DT64_TYPE 3                     // using INT96 value as dt64, TODO: refactor
 #define kNanosecondsInDay 86400000000000LL // TODO: reuse from type_traits.h
 
+// comparison operators of row group filters, see pq_filter_row_groups_single_file
+#define PQ_FILTER_EQ 0
+#define PQ_FILTER_NE 1
+#define PQ_FILTER_LT 2
+#define PQ_FILTER_LE 3
+#define PQ_FILTER_GT 4
+#define PQ_FILTER_GE 5
+
+// index of the row group at position pos of the row groups to read (all if NULL)
+inline int pq_row_group_at(const std::vector<int>* row_groups, int pos)
+{
+    return row_groups == NULL ? pos : (*row_groups)[pos];
+}
+
 int64_t pq_get_size_single_file(std::shared_ptr<FileReader> arrow_reader, int64_t column_idx)
 {
     int64_t nrows = arrow_reader->parquet_reader()->metadata()->num_rows();
@@ -83,6 +141,143 @@ int64_t pq_get_size_single_file(std::shared_ptr<FileReader> arrow_reader, int64_
     return nrows;
 }
 
+// append number of rows and total byte size of each row group of the file
+void pq_get_row_group_sizes_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                        std::vector<int64_t>* rg_rows,
+                                        std::vector<int64_t>* rg_bytes)
+{
+    auto metadata = arrow_reader->parquet_reader()->metadata();
+    for (int i = 0; i < metadata->num_row_groups(); i++)
+    {
+        auto rg_metadata = metadata->RowGroup(i);
+        rg_rows->push_back(rg_metadata->num_rows());
+        rg_bytes->push_back(rg_metadata->total_byte_size());
+    }
+}
+
+// min and max statistics of a column chunk as the values read for the column, e.g. dates in nanoseconds.
+// has_missing is set if the chunk may have nulls or NaNs, which statistics don't include in min and max
+static bool pq_get_chunk_min_max(std::unique_ptr<parquet::ColumnChunkMetaData> chunk,
+                                 std::shared_ptr<arrow::DataType> arrow_type,
+                                 long double* min,
+                                 long double* max,
+                                 bool* has_missing)
+{
+    long double scale = 1;
+    switch (arrow_type->id())
+    {
+    case Type::INT8:
+    case Type::INT16:
+    case Type::INT32:
+    case Type::INT64:
+    case Type::FLOAT:
+    case Type::DOUBLE: break;
+    case Type::DATE32: scale = kNanosecondsInDay; break;
+    case Type::DATE64: scale = 1000000L; break;
+    case Type::TIMESTAMP:
+    {
+        const auto& ts_type = static_cast<const arrow::TimestampType&>(*arrow_type);
+        if (ts_type.unit() == arrow::TimeUnit::MICRO)
+            scale = 1000L;
+        else if (ts_type.unit() == arrow::TimeUnit::MILLI)
+            scale = 1000000L;
+        else if (ts_type.unit() == arrow::TimeUnit::SECOND)
+            scale = 1000000000L;
+        break;
+    }
+    // unsigned integers have a different sort order, booleans and strings aren't supported
+    default: return false;
+    }
+
+    if (!chunk->is_stats_set())
+        return false;
+    std::shared_ptr<parquet::Statistics> stats = chunk->statistics();
+    if (stats == nullptr || !stats->HasMinMax())
+        return false;
+    *has_missing = stats->null_count() != 0 || arrow_type->id() == Type::FLOAT || arrow_type->id() == Type::DOUBLE;
+    switch (stats->physical_type())
+    {
+    case parquet::Type::INT32:
+    {
+        auto typed_stats = std::static_pointer_cast<parquet::Int32Statistics>(stats);
+        *min = typed_stats->min();
+        *max = typed_stats->max();
+        break;
+    }
+    case parquet::Type::INT64:
+    {
+        auto typed_stats = std::static_pointer_cast<parquet::Int64Statistics>(stats);
+        *min = typed_stats->min();
+        *max = typed_stats->max();
+        break;
+    }
+    case parquet::Type::FLOAT:
+    {
+        auto typed_stats = std::static_pointer_cast<parquet::FloatStatistics>(stats);
+        *min = typed_stats->min();
+        *max = typed_stats->max();
+        break;
+    }
+    case parquet::Type::DOUBLE:
+    {
+        auto typed_stats = std::static_pointer_cast<parquet::DoubleStatistics>(stats);
+        *min = typed_stats->min();
+        *max = typed_stats->max();
+        break;
+    }
+    // INT96 timestamps have no reliable statistics
+    default: return false;
+    }
+    *min *= scale;
+    *max *= scale;
+    return true;
+}
+
+// true if no value in [min, max] satisfies "value <op> filter_value". Comparisons with NaN
+// statistics are false so such row groups are kept. Nulls and NaNs only satisfy !=, so
+// row groups which may have them are kept for !=
+static bool pq_min_max_exclude(int op, long double min, long double max, bool has_missing, long double filter_value)
+{
+    switch (op)
+    {
+    case PQ_FILTER_EQ: return filter_value < min || filter_value > max;
+    case PQ_FILTER_NE: return !has_missing && min == filter_value && max == filter_value;
+    case PQ_FILTER_LT: return min >= filter_value;
+    case PQ_FILTER_LE: return min > filter_value;
+    case PQ_FILTER_GT: return max <= filter_value;
+    case PQ_FILTER_GE: return max < filter_value;
+    }
+    return false;
+}
+
+// remove the row groups whose statistics show that no row satisfies "column <op> value"
+void pq_filter_row_groups_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                      int64_t column_idx,
+                                      int op,
+                                      int is_float,
+                                      int64_t int_value,
+                                      double float_value,
+                                      std::vector<int>* row_groups)
+{
+    auto metadata = arrow_reader->parquet_reader()->metadata();
+    std::shared_ptr<arrow::DataType> arrow_type = get_arrow_type(arrow_reader, column_idx);
+    long double filter_value = is_float ? (long double)float_value : (long double)int_value;
+
+    std::vector<int> kept_row_groups;
+    for (int row_group_index : *row_groups)
+    {
+        long double min, max;
+        bool has_missing;
+        if (!pq_get_chunk_min_max(
+                metadata->RowGroup(row_group_index)->ColumnChunk(column_idx), arrow_type, &min, &max, &has_missing) ||
+            !pq_min_max_exclude(op, min, max, has_missing, filter_value))
+        {
+            kept_row_groups.push_back(row_group_index);
+        }
+    }
+    row_groups->swap(kept_row_groups);
+}
+
 int64_t
     pq_read_single_file(std::shared_ptr<FileReader> arrow_reader, int64_t column_idx, uint8_t* out_data, int out_dtype)
 {
@@ -118,18 +313,21 @@ int pq_read_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
                                  uint8_t* out_data,
                                  int out_dtype,
                                  int64_t start,
-                                 int64_t count)
+                                 int64_t count,
+                                 const std::vector<int>* row_groups)
 {
     if (count == 0)
     {
         return 0;
     }
 
-    int64_t n_row_groups = arrow_reader->parquet_reader()->metadata()->num_row_groups();
+    int64_t n_row_groups =
+        row_groups == NULL ? arrow_reader->parquet_reader()->metadata()->num_row_groups() : row_groups->size();
     std::vector<int> column_indices;
     column_indices.push_back(column_idx);
 
-    int row_group_index = 0;
+    int rg_pos = 0;
+    int row_group_index = pq_row_group_at(row_groups, rg_pos);
     int64_t skipped_rows = 0;
     int64_t read_rows = 0;
 
@@ -142,7 +340,7 @@ int pq_read_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
     while (start - skipped_rows >= nrows_in_group)
     {
         skipped_rows += nrows_in_group;
-        row_group_index++;
+        row_group_index = pq_row_group_at(row_groups, ++rg_pos);
         auto rg_metadata = arrow_reader->parquet_reader()->metadata()->RowGroup(row_group_index);
         nrows_in_group = rg_metadata->ColumnChunk(column_idx)->num_values();
     }
@@ -189,9 +387,10 @@ int pq_read_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
         skipped_rows += rows_to_skip;
         read_rows += rows_to_read;
 
-        row_group_index++;
-        if (row_group_index < n_row_groups)
+        rg_pos++;
+        if (rg_pos < n_row_groups)
         {
+            row_group_index = pq_row_group_at(row_groups, rg_pos);
             auto rg_metadata = arrow_reader->parquet_reader()->metadata()->RowGroup(row_group_index);
             nrows_in_group = rg_metadata->ColumnChunk(column_idx)->num_values();
         }
@@ -203,6 +402,445 @@ int pq_read_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
     return 0;
 }
 
+// row group of a read and the rows to copy from it
+struct pq_row_group_read
+{
+    int row_group_index;
+    int64_t rows_to_skip;
+    int64_t rows_to_read;
+    int64_t n_bytes; // uncompressed size, used to bound the prefetched data
+};
+
+/**
+ * Row groups are read and decoded by a background thread while the main thread copies
+ * the previous ones to the output. At most depth row groups are buffered, and no more
+ * than max_bytes unless the queue is empty.
+ **/
+class pq_row_group_prefetcher
+{
+public:
+    pq_row_group_prefetcher(std::shared_ptr<FileReader> arrow_reader,
+                            const std::vector<int>& column_indices,
+                            const std::vector<pq_row_group_read>& reads,
+                            int depth,
+                            int64_t max_bytes)
+        : arrow_reader(arrow_reader)
+        , column_indices(column_indices)
+        , reads(reads)
+        , depth(depth)
+        , max_bytes(max_bytes)
+    {
+        worker = std::thread(&pq_row_group_prefetcher::run, this);
+    }
+
+    ~pq_row_group_prefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cond.notify_all();
+        worker.join();
+    }
+
+    /// table of the next row group, null if its read failed
+    std::shared_ptr<::arrow::Table> next()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] { return !queue.empty(); });
+        std::shared_ptr<::arrow::Table> table = queue.front();
+        queue.pop_front();
+        queued_bytes -= reads[n_consumed++].n_bytes;
+        lock.unlock();
+        cond.notify_all();
+        return table;
+    }
+
+private:
+    void run()
+    {
+        for (size_t i = 0; i < reads.size(); i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [this, i] {
+                    return stop || queue.empty()
+                           || ((int64_t)queue.size() < depth && queued_bytes + reads[i].n_bytes <= max_bytes);
+                });
+                if (stop)
+                    return;
+            }
+            std::shared_ptr<::arrow::Table> table;
+            arrow::Status status = arrow_reader->ReadRowGroup(reads[i].row_group_index, column_indices, &table);
+            if (!status.ok())
+            {
+                std::cerr << "parquet row group read error: " << status.ToString() << std::endl;
+                table = nullptr;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(table);
+                queued_bytes += reads[i].n_bytes;
+            }
+            cond.notify_all();
+        }
+    }
+
+    std::shared_ptr<FileReader> arrow_reader;
+    const std::vector<int>& column_indices;
+    const std::vector<pq_row_group_read>& reads;
+    int64_t depth;
+    int64_t max_bytes;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::shared_ptr<::arrow::Table>> queue;
+    int64_t queued_bytes = 0;
+    size_t n_consumed = 0;
+    bool stop = false;
+};
+
+// read rows [start, start+count) of multiple columns, decoding each row group once for all of them
+int pq_read_columns_parallel_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                         int64_t n_cols,
+                                         const int64_t* column_idxs,
+                                         uint8_t** out_datas,
+                                         const int* out_dtypes,
+                                         int64_t start,
+                                         int64_t count,
+                                         const std::vector<int>* row_groups,
+                                         int prefetch_depth,
+                                         int64_t prefetch_max_bytes)
+{
+    if (count == 0 || n_cols == 0)
+    {
+        return 0;
+    }
+
+    auto metadata = arrow_reader->parquet_reader()->metadata();
+    int64_t n_row_groups = row_groups == NULL ? metadata->num_row_groups() : row_groups->size();
+    std::vector<int> column_indices(column_idxs, column_idxs + n_cols);
+    std::vector<std::shared_ptr<arrow::DataType>> arrow_types;
+    for (int64_t j = 0; j < n_cols; j++)
+    {
+        arrow_types.push_back(get_arrow_type(arrow_reader, column_idxs[j]));
+    }
+    // column chunks of a row group are decoded in parallel on Arrow's thread pool
+    arrow_reader->set_use_threads(true);
+
+    // row groups and rows to read
+    std::vector<pq_row_group_read> reads;
+    int64_t skipped_rows = 0;
+    int64_t planned_rows = 0;
+    for (int rg_pos = 0; rg_pos < n_row_groups && planned_rows < count; rg_pos++)
+    {
+        int row_group_index = pq_row_group_at(row_groups, rg_pos);
+        auto rg_metadata = metadata->RowGroup(row_group_index);
+        int64_t nrows_in_group = rg_metadata->num_rows();
+        // skip whole row groups if no need to read any rows
+        if (start - skipped_rows >= nrows_in_group)
+        {
+            skipped_rows += nrows_in_group;
+            continue;
+        }
+        int64_t rows_to_skip = std::max(start - skipped_rows, (int64_t)0);
+        int64_t rows_to_read = std::min(count - planned_rows, nrows_in_group - rows_to_skip);
+        reads.push_back({row_group_index, rows_to_skip, rows_to_read, rg_metadata->total_byte_size()});
+        skipped_rows += rows_to_skip;
+        planned_rows += rows_to_read;
+    }
+
+    // overlap reading and decoding the next row groups with copying, unless there is
+    // only one row group to read
+    std::unique_ptr<pq_row_group_prefetcher> prefetcher;
+    if (prefetch_depth > 0 && reads.size() > 1)
+    {
+        prefetcher.reset(new pq_row_group_prefetcher(
+            arrow_reader, column_indices, reads, prefetch_depth, prefetch_max_bytes));
+    }
+
+    int64_t read_rows = 0;
+    for (const auto& read : reads)
+    {
+        std::shared_ptr<::arrow::Table> table;
+        if (prefetcher)
+        {
+            table = prefetcher->next();
+        }
+        else
+        {
+            arrow::Status status = arrow_reader->ReadRowGroup(read.row_group_index, column_indices, &table);
+            if (!status.ok())
+            {
+                std::cerr << "parquet row group read error: " << status.ToString() << std::endl;
+                table = nullptr;
+            }
+        }
+        if (!table)
+        {
+            break;
+        }
+
+        for (int64_t j = 0; j < n_cols; j++)
+        {
+            std::shared_ptr<::arrow::ChunkedArray> chunked_arr = table->column(j)->data();
+            if (chunked_arr->num_chunks() != 1)
+            {
+                std::cerr << "invalid parquet number of array chunks" << std::endl;
+            }
+            std::shared_ptr<::arrow::Array> arr = chunked_arr->chunk(0);
+            auto buffers = arr->data()->buffers;
+            if (buffers.size() != 2)
+            {
+                std::cerr << "invalid parquet number of array buffers" << std::endl;
+            }
+            const uint8_t* buff = buffers[1]->data();
+            const uint8_t* null_bitmap_buff = arr->null_count() == 0 ? nullptr : arr->null_bitmap_data();
+
+            copy_data(out_datas[j] + read_rows * pq_type_sizes[out_dtypes[j]],
+                      buff,
+                      read.rows_to_skip,
+                      read.rows_to_read,
+                      arrow_types[j],
+                      null_bitmap_buff,
+                      out_dtypes[j]);
+        }
+        read_rows += read.rows_to_read;
+    }
+    if (read_rows != count)
+        std::cerr << "parquet read incomplete" << '\n';
+    return 0;
+}
+
+// string value of a column or a category, hashed and compared by content
+struct pq_str_key
+{
+    const uint8_t* ptr;
+    uint32_t len;
+
+    bool operator==(const pq_str_key& other) const
+    {
+        return len == other.len && memcmp(ptr, other.ptr, len) == 0;
+    }
+};
+
+struct pq_str_key_hash
+{
+    size_t operator()(const pq_str_key& key) const
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ULL;
+        for (uint32_t i = 0; i < key.len; i++)
+        {
+            hash = (hash ^ key.ptr[i]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+// store categorical code as integer of code_size bytes
+inline void pq_store_code(uint8_t* out_codes, int code_size, int64_t i, int64_t code)
+{
+    switch (code_size)
+    {
+    case 1: ((int8_t*)out_codes)[i] = (int8_t)code; break;
+    case 2: ((int16_t*)out_codes)[i] = (int16_t)code; break;
+    case 4: ((int32_t*)out_codes)[i] = (int32_t)code; break;
+    default: ((int64_t*)out_codes)[i] = code;
+    }
+}
+
+/**
+ * Read rows [start, start+count) of a string column as codes of the given categories, -1 for
+ * nulls. Values come from the low-level column reader, for dictionary encoded column chunks
+ * they point into the decoded dictionary page so no string is copied.
+ * Returns the number of values not in the categories, which are stored as -1 too.
+ **/
+int64_t pq_read_categorical_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                        int64_t column_idx,
+                                        uint8_t* out_codes,
+                                        int code_size,
+                                        const uint8_t* cat_chars,
+                                        const uint32_t* cat_offsets,
+                                        int64_t n_cats,
+                                        int64_t start,
+                                        int64_t count,
+                                        const std::vector<int>* row_groups)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    std::unordered_map<pq_str_key, int64_t, pq_str_key_hash> cat_codes;
+    for (int64_t i = 0; i < n_cats; i++)
+    {
+        cat_codes[{cat_chars + cat_offsets[i], cat_offsets[i + 1] - cat_offsets[i]}] = i;
+    }
+
+    auto metadata = arrow_reader->parquet_reader()->metadata();
+    int64_t n_row_groups = row_groups == NULL ? metadata->num_row_groups() : row_groups->size();
+    int rg_pos = 0;
+    int row_group_index = pq_row_group_at(row_groups, rg_pos);
+    int64_t skipped_rows = 0;
+    int64_t read_rows = 0;
+    int64_t nrows_in_group = metadata->RowGroup(row_group_index)->num_rows();
+
+    // skip whole row groups if no need to read any rows
+    while (start - skipped_rows >= nrows_in_group)
+    {
+        skipped_rows += nrows_in_group;
+        row_group_index = pq_row_group_at(row_groups, ++rg_pos);
+        nrows_in_group = metadata->RowGroup(row_group_index)->num_rows();
+    }
+
+    const int64_t batch_size = 4096;
+    std::vector<int16_t> def_levels(batch_size);
+    std::vector<parquet::ByteArray> values(batch_size);
+    int64_t n_unknown = 0;
+
+    while (read_rows < count)
+    {
+        int64_t rows_to_skip = start - skipped_rows;
+        int64_t rows_to_read = std::min(count - read_rows, nrows_in_group - rows_to_skip);
+
+        std::shared_ptr<parquet::ColumnReader> col_reader =
+            arrow_reader->parquet_reader()->RowGroup(row_group_index)->Column(column_idx);
+        auto ba_reader = std::static_pointer_cast<parquet::ByteArrayReader>(col_reader);
+        int16_t max_def_level = col_reader->descr()->max_definition_level();
+        ba_reader->Skip(rows_to_skip);
+
+        int64_t row = read_rows;
+        int64_t end_row = read_rows + rows_to_read;
+        while (row < end_row && ba_reader->HasNext())
+        {
+            int64_t values_read = 0;
+            int64_t levels_read = ba_reader->ReadBatch(
+                std::min(batch_size, end_row - row), def_levels.data(), NULL, values.data(), &values_read);
+            int64_t val_ind = 0;
+            for (int64_t i = 0; i < levels_read; i++)
+            {
+                int64_t code = -1;
+                // levels are only written for nullable columns
+                if (max_def_level == 0 || def_levels[i] == max_def_level)
+                {
+                    const parquet::ByteArray& val = values[val_ind++];
+                    auto it = cat_codes.find({val.ptr, val.len});
+                    if (it != cat_codes.end())
+                        code = it->second;
+                    else
+                        n_unknown++;
+                }
+                pq_store_code(out_codes, code_size, row + i, code);
+            }
+            row += levels_read;
+        }
+        if (row != end_row)
+            std::cerr << "parquet read incomplete" << '\n';
+
+        skipped_rows += rows_to_skip;
+        read_rows += rows_to_read;
+
+        rg_pos++;
+        if (rg_pos < n_row_groups)
+        {
+            row_group_index = pq_row_group_at(row_groups, rg_pos);
+            nrows_in_group = metadata->RowGroup(row_group_index)->num_rows();
+        }
+        else
+            break;
+    }
+    if (read_rows != count)
+        std::cerr << "parquet read incomplete" << '\n';
+    if (n_unknown > 0)
+        std::cerr << "parquet categorical read: " << n_unknown << " values not in categories" << std::endl;
+    return n_unknown;
+}
+
+// append the non-null values of a string column chunk to values
+static void pq_append_chunk_values(std::shared_ptr<parquet::ColumnReader> col_reader, std::vector<std::string>* values)
+{
+    const int64_t batch_size = 4096;
+    std::vector<int16_t> def_levels(batch_size);
+    std::vector<parquet::ByteArray> batch(batch_size);
+    auto ba_reader = std::static_pointer_cast<parquet::ByteArrayReader>(col_reader);
+    while (ba_reader->HasNext())
+    {
+        int64_t values_read = 0;
+        ba_reader->ReadBatch(batch_size, def_levels.data(), NULL, batch.data(), &values_read);
+        for (int64_t i = 0; i < values_read; i++)
+        {
+            values->emplace_back((const char*)batch[i].ptr, batch[i].len);
+        }
+    }
+}
+
+static bool pq_is_dictionary_encoding(parquet::Encoding::type encoding)
+{
+    return encoding == parquet::Encoding::PLAIN_DICTIONARY || encoding == parquet::Encoding::RLE_DICTIONARY;
+}
+
+/**
+ * Append the values of the dictionary page of each column chunk of a string column to values
+ * (possibly repeated across chunks). Data pages are only checked for their encoding, chunks
+ * that aren't fully dictionary encoded (writers fall back to plain encoding when dictionaries
+ * grow large) have their values read instead.
+ **/
+void pq_get_dictionary_single_file(std::shared_ptr<FileReader> arrow_reader,
+                                   int64_t column_idx,
+                                   std::vector<std::string>* values)
+{
+    auto metadata = arrow_reader->parquet_reader()->metadata();
+    for (int rg = 0; rg < metadata->num_row_groups(); rg++)
+    {
+        std::shared_ptr<parquet::RowGroupReader> rg_reader = arrow_reader->parquet_reader()->RowGroup(rg);
+        std::unique_ptr<parquet::PageReader> pages = rg_reader->GetColumnPageReader(column_idx);
+        std::vector<std::string> dict_values;
+        bool dict_encoded = true;
+        std::shared_ptr<parquet::Page> page;
+        while (dict_encoded && (page = pages->NextPage()) != nullptr)
+        {
+            if (page->type() == parquet::PageType::DICTIONARY_PAGE)
+            {
+                // plain encoded values, each prefixed by its 4 byte length
+                auto dict_page = std::static_pointer_cast<parquet::DictionaryPage>(page);
+                const uint8_t* data = dict_page->data();
+                const uint8_t* end = data + dict_page->size();
+                for (int32_t i = 0; i < dict_page->num_values() && data + sizeof(uint32_t) <= end; i++)
+                {
+                    uint32_t len;
+                    memcpy(&len, data, sizeof(uint32_t));
+                    data += sizeof(uint32_t);
+                    if (len > (uint64_t)(end - data))
+                    {
+                        break;
+                    }
+                    dict_values.emplace_back((const char*)data, len);
+                    data += len;
+                }
+            }
+            else if (page->type() == parquet::PageType::DATA_PAGE)
+            {
+                dict_encoded = pq_is_dictionary_encoding(std::static_pointer_cast<parquet::DataPage>(page)->encoding());
+            }
+            else if (page->type() == parquet::PageType::DATA_PAGE_V2)
+            {
+                dict_encoded =
+                    pq_is_dictionary_encoding(std::static_pointer_cast<parquet::DataPageV2>(page)->encoding());
+            }
+        }
+        if (dict_encoded)
+        {
+            values->insert(values->end(), dict_values.begin(), dict_values.end());
+        }
+        else
+        {
+            pq_append_chunk_values(rg_reader->Column(column_idx), values);
+        }
+    }
+}
+
 template <typename T_in, typename T_out>
 inline void copy_data_cast(uint8_t* out_data,
                            const uint8_t* buff,
@@ -386,7 +1024,7 @@ int64_t pq_read_string_single_file(std::shared_ptr<FileReader> arrow_reader,
                                    uint8_t** out_nulls,
                                    std::vector<uint32_t>* offset_vec,
                                    std::vector<uint8_t>* data_vec,
-                                   std::vector<bool>* null_vec)
+                                   hpat_null_bitmap* null_vec)
 {
     // std::cout << "string read file" << '\n';
     //
@@ -441,7 +1079,7 @@ int64_t pq_read_string_single_file(std::shared_ptr<FileReader> arrow_reader,
     {
         offset_vec->insert(offset_vec->end(), offsets_buff, offsets_buff + offsets_size / sizeof(uint32_t));
         data_vec->insert(data_vec->end(), data_buff, data_buff + data_size);
-        append_bits_to_vec(null_vec, null_buff, null_size, 0, num_values);
+        null_vec->append(null_size > 0 ? null_buff : nullptr, 0, num_values);
     }
 
     return num_values;
@@ -456,7 +1094,8 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader
                                         int64_t count,
                                         std::vector<uint32_t>* offset_vec,
                                         std::vector<uint8_t>* data_vec,
-                                        std::vector<bool>* null_vec)
+                                        hpat_null_bitmap* null_vec,
+                                        const std::vector<int>* row_groups)
 {
     if (count == 0)
     {
@@ -476,14 +1115,16 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader
     {
         *out_offsets = new uint32_t[count + 1];
         data_vec = new std::vector<uint8_t>();
-        null_vec = new std::vector<bool>();
+        null_vec = new hpat_null_bitmap();
     }
 
-    int64_t n_row_groups = arrow_reader->parquet_reader()->metadata()->num_row_groups();
+    int64_t n_row_groups =
+        row_groups == NULL ? arrow_reader->parquet_reader()->metadata()->num_row_groups() : row_groups->size();
     std::vector<int> column_indices;
     column_indices.push_back(column_idx);
 
-    int row_group_index = 0;
+    int rg_pos = 0;
+    int row_group_index = pq_row_group_at(row_groups, rg_pos);
     int64_t skipped_rows = 0;
     int64_t read_rows = 0;
 
@@ -494,7 +1135,7 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader
     while (start - skipped_rows >= nrows_in_group)
     {
         skipped_rows += nrows_in_group;
-        row_group_index++;
+        row_group_index = pq_row_group_at(row_groups, ++rg_pos);
         auto rg_metadata = arrow_reader->parquet_reader()->metadata()->RowGroup(row_group_index);
         nrows_in_group = rg_metadata->ColumnChunk(column_idx)->num_values();
     }
@@ -552,14 +1193,15 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader
         data_vec->insert(data_vec->end(),
                          data_buff + offsets_buff[rows_to_skip],
                          data_buff + offsets_buff[rows_to_skip] + data_size);
-        append_bits_to_vec(null_vec, null_buff, null_size, rows_to_skip, rows_to_read);
+        null_vec->append(null_size > 0 ? null_buff : nullptr, rows_to_skip, rows_to_read);
 
         skipped_rows += rows_to_skip;
         read_rows += rows_to_read;
 
-        row_group_index++;
-        if (row_group_index < n_row_groups)
+        rg_pos++;
+        if (rg_pos < n_row_groups)
         {
+            row_group_index = pq_row_group_at(row_groups, rg_pos);
             auto rg_metadata = arrow_reader->parquet_reader()->metadata()->RowGroup(row_group_index);
             nrows_in_group = rg_metadata->ColumnChunk(column_idx)->num_values();
         }
@@ -575,7 +1217,7 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader
         *out_data = new uint8_t[curr_offset];
         // printf("buffer size:%d curr_offset:%d\n", data_vec->size(), curr_offset);
         memcpy(*out_data, data_vec->data(), curr_offset);
-        pack_null_bitmap(out_nulls, *null_vec, count);
+        null_vec->pack(out_nulls, count);
         delete data_vec;
         delete null_vec;
     }
@@ -591,7 +1233,9 @@ int pq_read_string_parallel_single_file(std::shared_ptr<FileReader> arrow_reader
     return 0;
 }
 
-void pq_init_reader(const char* file_name, std::shared_ptr<FileReader>* a_reader)
+void pq_init_reader(const char* file_name,
+                    std::shared_ptr<FileReader>* a_reader,
+                    const std::shared_ptr<parquet::FileMetaData>& metadata)
 {
     std::string f_name(file_name);
     auto pool = ::arrow::default_memory_pool();
@@ -634,17 +1278,30 @@ void pq_init_reader(const char* file_name, std::shared_ptr<FileReader>* a_reader
         ::arrow::io::HadoopFileSystem::Connect(&hfs_config, &fs);
         std::shared_ptr<::arrow::io::HdfsReadableFile> file;
         fs->OpenReadable(f_name, &file);
-        a_reader->reset(new FileReader(pool, ParquetFileReader::Open(file)));
+        a_reader->reset(
+            new FileReader(pool, ParquetFileReader::Open(file, parquet::default_reader_properties(), metadata)));
     }
     else // regular file system
     {
-        a_reader->reset(new FileReader(pool, ParquetFileReader::OpenFile(f_name, false)));
+        a_reader->reset(new FileReader(
+            pool, ParquetFileReader::OpenFile(f_name, false, parquet::default_reader_properties(), metadata)));
     }
     // printf("file open for arrow reader done\n");
     // fflush(stdout);
     return;
 }
 
+// serialized footer (Thrift FileMetaData) of the file, which can be passed to pq_init_reader
+void pq_get_footer_single_file(std::shared_ptr<FileReader> arrow_reader, std::string* footer)
+{
+    std::shared_ptr<arrow::io::BufferOutputStream> stream;
+    arrow::io::BufferOutputStream::Create(4096, arrow::default_memory_pool(), &stream);
+    arrow_reader->parquet_reader()->metadata()->WriteTo(stream.get());
+    std::shared_ptr<arrow::Buffer> buffer;
+    stream->Finish(&buffer);
+    footer->assign((const char*)buffer->data(), buffer->size());
+}
+
 // get type as enum values defined in arrow/cpp/src/arrow/type.h
 // TODO: handle more complex types
 std::shared_ptr<arrow::DataType> get_arrow_type(std::shared_ptr<FileReader> arrow_reader, int64_t column_idx)
@@ -698,37 +1355,3 @@ inline void convertArrowToDT64(const uint8_t* buff, uint8_t* out_data, int64_t r
         *out_values++ = (static_cast<int64_t>(in_values[rows_to_skip + i]) * SHIFT);
     }
 }
-
-void append_bits_to_vec(
-    std::vector<bool>* null_vec, const uint8_t* null_buff, int64_t null_size, int64_t offset, int64_t num_values)
-{
-    if (null_buff != nullptr && null_size > 0)
-    {
-        // to make packing portions of data easier, add data to vector in unpacked format then repack
-        for (int64_t i = offset; i < offset + num_values; i++)
-        {
-            bool val = ::arrow::BitUtil::GetBit(null_buff, i);
-            // printf("packing %d %d\n", i, (int)val);
-            null_vec->push_back(val);
-        }
-        // null_vec->insert(null_vec->end(), null_buff, null_buff+null_size);
-    }
-}
-
-void pack_null_bitmap(uint8_t** out_nulls, std::vector<bool>& null_vec, int64_t n_all_vals)
-{
-    if (null_vec.size() > 0)
-    {
-        int64_t n_bytes = (null_vec.size() + sizeof(uint8_t) - 1) / sizeof(uint8_t);
-        *out_nulls = new uint8_t[n_bytes];
-        memset(*out_nulls, 0, n_bytes);
-        for (int64_t i = 0; i < n_all_vals; i++)
-        {
-            // printf("null %d %d\n", i, (int)null_vec[i]);
-            if (null_vec[i])
-                ::arrow::BitUtil::SetBit(*out_nulls, i);
-        }
-    }
-    else
-        *out_nulls = nullptr;
-}
@@ -156,23 +156,28 @@ if not is_win:
     boost_libs = ['boost_filesystem', 'boost_system']
     io_libs += boost_libs
 
+# std::thread in the native CSV parser
+io_thread_flags = [] if is_win else ['-pthread']
+
 ext_io = Extension(name="hpat.hio",
                    sources=["hpat/io/_io.cpp", "hpat/io/_csv.cpp"],
                    depends=["hpat/_hpat_common.h", "hpat/_distributed.h",
                             "hpat/_import_py.h", "hpat/io/_csv.h",
+                            "hpat/io/_csv_lines.h", "hpat/io/_csv_parser.h",
+                            "hpat/io/_csv_writer.h",
                             "hpat/_datetime_ext.h"],
                    libraries=boost_libs,
                    include_dirs=ind + np_compile_args['include_dirs'],
                    library_dirs=lid,
                    define_macros=H5_CPP_FLAGS,
-                   extra_compile_args=eca,
-                   extra_link_args=ela,
+                   extra_compile_args=eca + io_thread_flags,
+                   extra_link_args=ela + io_thread_flags,
                    language="c++"
                    )
 
 ext_transport_mpi = Extension(name="hpat.transport_mpi",
                               sources=["hpat/transport/hpat_transport_mpi.cpp"],
-                              depends=["hpat/_distributed.h"],
+                              depends=["hpat/_distributed.h", "hpat/_hpat_hash.h", "hpat/io/_csv_lines.h"],
                               libraries=io_libs,
                               include_dirs=ind,
                               library_dirs=lid,
@@ -183,7 +188,7 @@ ext_transport_mpi = Extension(name="hpat.transport_mpi",
 
 ext_transport_seq = Extension(name="hpat.transport_seq",
                               sources=["hpat/transport/hpat_transport_single_process.cpp"],
-                              depends=["hpat/_distributed.h"],
+                              depends=["hpat/_distributed.h", "hpat/io/_csv_lines.h"],
                               include_dirs=ind,
                               library_dirs=lid,
                               extra_compile_args=eca,
@@ -214,7 +219,7 @@ ext_hdist = Extension(name="hpat.hdist",
 
 ext_chiframes = Extension(name="hpat.chiframes",
                           sources=["hpat/_hiframes.cpp"],
-                          depends=["hpat/_hpat_sort.h"],
+                          depends=["hpat/_hpat_sort.h", "hpat/_hpat_hash.h"],
                           extra_compile_args=eca,
                           extra_link_args=ela,
                           include_dirs=ind,
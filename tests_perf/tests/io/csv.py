@@ -1,3 +1,6 @@
+import numpy as np
+import pandas as pd
+
 import hpat
 
 from ..common import BaseIO, Implementation as Impl
@@ -7,23 +10,69 @@ from ..data_generator import DataGenerator
 class ToCSV(BaseIO):
     fname = '__test__.csv'
     params = [
-        [Impl.interpreted_python.value, Impl.compiled_python.value]
+        [Impl.interpreted_python.value, Impl.compiled_python.value],
+        ['native', 'pandas']
     ]
-    pparam_names = ['implementation']
+    param_names = ['implementation', 'writer']
 
-    def setup(self, implementation):
+    def setup(self, implementation, writer):
+        if implementation == Impl.interpreted_python.value and writer == 'native':
+            raise NotImplementedError
         N = 10 ** 4
         data_generator = DataGenerator()
         self.df = data_generator.make_numeric_dataframe(5 * N)
 
+        # the writer is picked when the function is compiled
+        native_writer = hpat.config.config_csv_native_writer
+        hpat.config.config_csv_native_writer = writer == 'native'
+        self._to_csv = hpat.jit(distributed={'df'})(self._to_csv_impl)
+        self._to_csv(self.df, self.fname)
+        hpat.config.config_csv_native_writer = native_writer
+
     @staticmethod
-    @hpat.jit
-    def _to_csv(df, fname):
+    def _to_csv_impl(df, fname):
         return df.to_csv(fname)
 
-    def time_to_csv(self, implementation):
-        """Time both interpreted and compiled DataFrame.to_csv"""
+    def time_to_csv(self, implementation, writer):
+        """Time both interpreted and compiled DataFrame.to_csv, compiled with native and pandas row formatting"""
         if implementation == Impl.compiled_python.value:
             return self._to_csv(self.df, self.fname)
         if implementation == Impl.interpreted_python.value:
-            return self.df.to_csv(self.fname)
+            return self._to_csv_impl(self.df, self.fname)
+
+
+class ReadCSV(BaseIO):
+    fname = '__test__.csv'
+    params = [
+        [Impl.interpreted_python.value, Impl.compiled_python.value],
+        ['native', 'pandas']
+    ]
+    param_names = ['implementation', 'parser']
+
+    def setup(self, implementation, parser):
+        if implementation == Impl.interpreted_python.value and parser == 'native':
+            raise NotImplementedError
+        N = 10 ** 4
+        data_generator = DataGenerator()
+        df = data_generator.make_numeric_dataframe(5 * N)
+        df['E'] = df['A'].astype(str)
+        df.to_csv(self.fname, header=False, index=False)
+
+        # the parser is picked when the function is compiled
+        native_parser = hpat.config.config_csv_native_parser
+        hpat.config.config_csv_native_parser = parser == 'native'
+        self._read_csv = hpat.jit(self._read_csv_impl)
+        self._read_csv(self.fname)
+        hpat.config.config_csv_native_parser = native_parser
+
+    @staticmethod
+    def _read_csv_impl(fname):
+        return pd.read_csv(fname, names=['A', 'B', 'C', 'D', 'E'],
+                           dtype={'A': np.int64, 'B': np.float64, 'C': np.float64, 'D': np.float64, 'E': str})
+
+    def time_read_csv(self, implementation, parser):
+        """Time both interpreted and compiled pandas.read_csv, compiled with native and pandas chunk parsers"""
+        if implementation == Impl.compiled_python.value:
+            return self._read_csv(self.fname)
+        if implementation == Impl.interpreted_python.value:
+            return self._read_csv_impl(self.fname)
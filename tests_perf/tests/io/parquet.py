@@ -0,0 +1,46 @@
+import numpy as np
+import pandas as pd
+import pyarrow as pa
+import pyarrow.parquet as pq
+
+import hpat
+
+from ..common import BaseIO, Implementation as Impl
+
+
+# file name has to be a constant for HPAT to get the Parquet schema at compile time
+_str_nulls_fname = '__test_str_nulls__.parquet'
+
+
+class ReadParquetStrNulls(BaseIO):
+    fname = _str_nulls_fname
+    params = [
+        [Impl.interpreted_python.value, Impl.compiled_python.value],
+        ['sparse', 'dense']
+    ]
+    param_names = ['implementation', 'nulls']
+
+    def setup(self, implementation, nulls):
+        N = 10 ** 6
+        np.random.seed(0)
+        null_ratio = 0.01 if nulls == 'sparse' else 0.5
+        values = np.random.randint(0, 1000, N).astype(str).astype(object)
+        values[np.random.random(N) < null_ratio] = None
+        table = pa.Table.from_pandas(pd.DataFrame({'A': values}), preserve_index=False)
+        # small row groups with odd sizes, validity bits of each row group are
+        # appended at unaligned offsets
+        pq.write_table(table, self.fname, row_group_size=10 ** 4 + 3)
+        self._read_parquet = hpat.jit(self._read_parquet_impl)
+        self._read_parquet()
+
+    @staticmethod
+    def _read_parquet_impl():
+        df = pd.read_parquet(_str_nulls_fname)
+        return df.A.isna().sum()
+
+    def time_read_parquet_str_nulls(self, implementation, nulls):
+        """Time reading a string column with sparse and dense nulls, which rebuilds its null bitmap"""
+        if implementation == Impl.compiled_python.value:
+            return self._read_parquet()
+        if implementation == Impl.interpreted_python.value:
+            return self._read_parquet_impl()